@@ -104,6 +104,52 @@ settings = {
 	-- Fix missing attack information in unit encyclopedia
 	detailedAttackDescription = true,
 
+	-- Lua garbage collector settings, see 'Garbage Collection' in Lua 5.4 manual.
+	-- When 'generational' is false, incremental mode is used with
+	-- 'pause' [1 : 1000], 'stepMultiplier' [1 : 1000] and 'stepSize' [1 : 20] parameters.
+	-- Otherwise generational mode is used with
+	-- 'minorMultiplier' [1 : 100] and 'majorMultiplier' [1 : 1000] parameters.
+	-- Collector statistics are written to 'luaGc.log' when debugHooks is true
+	luaGc = {
+		-- Scripts executed once per call: targeting, doppelganger, summon, transform self
+		scripts = {
+			generational = false,
+			pause = 200, stepMultiplier = 100, stepSize = 13
+		},
+		-- Long-lived state shared by all scriptable event conditions
+		eventConditions = {
+			generational = true,
+			minorMultiplier = 20, majorMultiplier = 100
+		}
+	},
+
+	-- Keep parsed copies of databases read by mss32 proxy dll in 'mss32Cache' folder
+	-- to speed up game start. Caches are rebuilt automatically when databases change
+	cacheDatabases = true,
+
+	-- Apply changes of custom attack scripts and maximum targets (LAttR.dbf),
+	-- immunity AI ratings (LAttS.dbf) and units for hire (Grace.dbf) without game restart.
+	-- Other changes of these databases still require restart.
+	-- Works only in single player and hotseat games, all online players must use the same data
+	reloadDatabases = false,
+
+	-- Count calls of mss32 proxy dll hooks and measure their duration.
+	-- Report is written to 'hookProfile.log' on exit and when Ctrl+Shift+P is pressed
+	profileHooks = false,
+
+	-- Record latest hook calls, Lua targeting script calls, event condition tests,
+	-- database loads and battle messages serialization of each thread.
+	-- Trace is written to 'mss32Trace.bin' on exit and when Ctrl+Shift+T is pressed,
+	-- use tracetool to convert it for viewing
+	recordTrace = false,
+
+	-- Capture battle state, unit stats and chosen targets of each battle action
+	-- to 'battleCapture.bin', use replaytool to replay them through targeting scripts
+	captureBattles = false,
+
+	-- Append runtime performance metrics of each turn to 'metrics.csv'
+	writeMetrics = false,
+
 	-- Create mss32 proxy dll log files with debug info
 	debugHooks = false,
 }
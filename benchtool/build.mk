@@ -0,0 +1,56 @@
+# Common rules of the tools that are built from proxy sources on Linux.
+# Including makefile sets TARGET, SOURCES (relative to the repository root) and ROOT.
+# Submodules must be checked out: git submodule update --init fmt GSL sol2
+
+BUILD ?= build
+
+CC ?= gcc
+CXX ?= g++
+# Proxy code calls game functions with their calling conventions,
+# so tools are 32-bit and conventions are mapped to gcc attributes
+ARCH := -m32
+CONVENTIONS := '-D__cdecl=__attribute__((cdecl))' \
+               '-D__stdcall=__attribute__((stdcall))' \
+               '-D__fastcall=__attribute__((fastcall))' \
+               '-D__thiscall=__attribute__((thiscall))'
+
+INCLUDES := -I$(ROOT)/GSL/include -I$(ROOT)/fmt/include -I$(ROOT)/sol2/include \
+            -I$(ROOT)/mss32/include -I$(ROOT)/mss32/include/bindings \
+            -I$(ROOT)/mss32/include/dbf -I$(ROOT)/lua -I$(ROOT)/benchtool
+
+OPTIMIZATION ?= -O2
+TOOL_CFLAGS := $(ARCH) $(OPTIMIZATION) -MMD -MP
+TOOL_CXXFLAGS := $(ARCH) -std=c++17 $(OPTIMIZATION) -MMD -MP $(CONVENTIONS)
+
+# Lua is built from the sources in the repository, without standalone interpreter and compiler
+LUA_SOURCES := $(filter-out lua/lua.c lua/luac.c,$(patsubst $(ROOT)/%,%,$(wildcard $(ROOT)/lua/*.c)))
+
+ALL_SOURCES := $(SOURCES) fmt/src/format.cc $(LUA_SOURCES)
+OBJECTS := $(addprefix $(BUILD)/,$(addsuffix .o,$(basename $(ALL_SOURCES))))
+
+all: $(TARGET)
+
+$(ROOT)/sol2/include/sol/sol.hpp $(ROOT)/fmt/src/format.cc:
+	$(error $@ is missing, run 'git submodule update --init fmt GSL sol2')
+
+$(TARGET): $(OBJECTS)
+	$(CXX) $(ARCH) $(LDFLAGS) $^ -o $@
+
+$(BUILD)/%.o: $(ROOT)/%.c
+	@mkdir -p $(dir $@)
+	$(CC) $(TOOL_CFLAGS) $(CPPFLAGS) $(CFLAGS) -c $< -o $@
+
+$(BUILD)/%.o: $(ROOT)/%.cc | $(ROOT)/sol2/include/sol/sol.hpp
+	@mkdir -p $(dir $@)
+	$(CXX) $(TOOL_CXXFLAGS) $(CPPFLAGS) $(INCLUDES) $(CXXFLAGS) -c $< -o $@
+
+$(BUILD)/%.o: $(ROOT)/%.cpp | $(ROOT)/sol2/include/sol/sol.hpp
+	@mkdir -p $(dir $@)
+	$(CXX) $(TOOL_CXXFLAGS) $(CPPFLAGS) $(INCLUDES) $(CXXFLAGS) -c $< -o $@
+
+clean:
+	rm -rf $(BUILD) $(TARGET)
+
+.PHONY: all clean
+
+-include $(OBJECTS:.o=.d)
@@ -0,0 +1,1056 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Stand-ins of the game functions used by targeting and event condition code.
+ * Game Api structures are tables of function addresses, so stand-ins are written into
+ * the tables of the first game version the same way the proxy replaces game functions.
+ * Stand-ins work with battle and scenario objects kept in memory.
+ */
+
+#include "batattack.h"
+#include "battlemsgdata.h"
+#include "dynamiccast.h"
+#include "game.h"
+#include "globaldata.h"
+#include "mempool.h"
+#include "midevcondition.h"
+#include "midevent.h"
+#include "midgard.h"
+#include "midgardid.h"
+#include "midgardmapblock.h"
+#include "midgardobjectmap.h"
+#include "midgardstream.h"
+#include "midlocation.h"
+#include "midplayer.h"
+#include "midscenvariables.h"
+#include "midunit.h"
+#include "midunitgroup.h"
+#include "racetype.h"
+#include "scenarioinfo.h"
+#include "standins.h"
+#include "subracecat.h"
+#include "unitgenerator.h"
+#include "ussoldier.h"
+#include "usunit.h"
+#include "version.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace benchtool {
+
+namespace {
+
+/** Two character codes of IdType values as they appear in id strings. */
+const char idTypeCodes[][3] = {
+    "00", "TA", "BB", "RR", "LR", "SS", "UU", "UG", "UM", "AA", "TG", "MG", "IG", "NA", "DU",
+    "DA", "AL", "DC", "AC", "CC", "CW", "CO", "PN", "OB", "SC", "MP", "MB", "IF", "ET", "FT",
+    "PL", "KS", "FG", "PB", "RA", "KC", "UN", "MM", "IM", "BG", "SI", "RU", "TB", "RD", "CR",
+    "DP", "ST", "LO", "TM", "EV", "SD", "TC", "MT", "ML", "SR", "BR", "QL", "TS", "SV",
+};
+
+const char idCategoryCodes[] = "GCSE";
+
+/** Category index of stand-in scenario, the same as in scenarios made by the editor. */
+constexpr int scenarioIndex{143};
+
+/** Type index of the first summon unit id, see CMidgardIDApi::Api::isSummonUnitId. */
+constexpr int summonTypeIndex{0x4e20};
+
+bool isValid(const game::CMidgardID* id)
+{
+    const int type{(id->value >> 16) & 0x3f};
+    return type < static_cast<int>(game::IdType::Invalid);
+}
+
+game::CMidgardID makeId(game::IdCategory category,
+                        int categoryIndex,
+                        game::IdType type,
+                        int typeIndex)
+{
+    return game::CMidgardID{(static_cast<int>(category) << 30) | (categoryIndex << 22)
+                            | (static_cast<int>(type) << 16) | typeIndex};
+}
+
+game::IdCategory __fastcall idGetCategory(const game::CMidgardID* id, int /*%edx*/)
+{
+    if (!isValid(id)) {
+        return game::IdCategory::Invalid;
+    }
+
+    return static_cast<game::IdCategory>((id->value >> 30) & 3);
+}
+
+int __fastcall idGetCategoryIndex(const game::CMidgardID* id, int /*%edx*/)
+{
+    return isValid(id) ? (id->value >> 22) & 0xff : 256;
+}
+
+game::IdType __fastcall idGetType(const game::CMidgardID* id, int /*%edx*/)
+{
+    if (!isValid(id)) {
+        return game::IdType::Invalid;
+    }
+
+    return static_cast<game::IdType>((id->value >> 16) & 0x3f);
+}
+
+int __fastcall idGetTypeIndex(const game::CMidgardID* id, int /*%edx*/)
+{
+    return isValid(id) ? id->value & 0xffff : 0x10000;
+}
+
+char* __fastcall idToString(const game::CMidgardID* id, int /*%edx*/, char* string)
+{
+    if (!isValid(id)) {
+        std::snprintf(string, 11, "INVALID-ID");
+        return string;
+    }
+
+    std::snprintf(string, 11, "%c%03d%s%04x", idCategoryCodes[(id->value >> 30) & 3],
+                  (id->value >> 22) & 0xff, idTypeCodes[(id->value >> 16) & 0x3f],
+                  id->value & 0xffff);
+    return string;
+}
+
+bool parseId(game::CMidgardID& id, const char* string)
+{
+    if (!string || std::strlen(string) != 10) {
+        return false;
+    }
+
+    const char* category = std::strchr(idCategoryCodes, std::toupper(string[0]));
+    if (!category || !*category) {
+        return false;
+    }
+
+    int categoryIndex{};
+    for (int i = 1; i < 4; ++i) {
+        if (!std::isdigit(static_cast<unsigned char>(string[i]))) {
+            return false;
+        }
+
+        categoryIndex = categoryIndex * 10 + (string[i] - '0');
+    }
+
+    int type{-1};
+    for (int i = 0; i < static_cast<int>(std::size(idTypeCodes)); ++i) {
+        if (std::toupper(string[4]) == idTypeCodes[i][0]
+            && std::toupper(string[5]) == idTypeCodes[i][1]) {
+            type = i;
+            break;
+        }
+    }
+
+    char* end{};
+    const long typeIndex = std::strtol(string + 6, &end, 16);
+    if (type < 0 || categoryIndex > 0xff || end != string + 10) {
+        return false;
+    }
+
+    id = makeId(static_cast<game::IdCategory>(category - idCategoryCodes), categoryIndex,
+                static_cast<game::IdType>(type), static_cast<int>(typeIndex));
+    return true;
+}
+
+game::CMidgardID* __fastcall idFromString(game::CMidgardID* id,
+                                          int /*%edx*/,
+                                          const char* string)
+{
+    if (!parseId(*id, string)) {
+        *id = game::invalidId;
+    }
+
+    return id;
+}
+
+game::CMidgardID* __stdcall idFromParts(game::CMidgardID* id,
+                                        game::IdCategory category,
+                                        int categoryIndex,
+                                        game::IdType type,
+                                        int typeIndex)
+{
+    using namespace game;
+
+    if (category < IdCategory::Global || category >= IdCategory::Invalid || categoryIndex < 0
+        || categoryIndex > 0xff || type <= IdType::Empty || type >= IdType::Invalid
+        || typeIndex < 0 || typeIndex > 0xffff) {
+        *id = invalidId;
+        return id;
+    }
+
+    *id = makeId(category, categoryIndex, type, typeIndex);
+    return id;
+}
+
+bool __stdcall idIsStringValid(const char* string)
+{
+    game::CMidgardID id{};
+    return parseId(id, string);
+}
+
+game::CMidgardID* __fastcall idIsSummonUnitId(game::CMidgardID* id,
+                                              int /*%edx*/,
+                                              const game::CMidgardID* other)
+{
+    const int typeIndex{other->value & 0xffff};
+    const bool summon{(other->value & 0xffff0000) == 0 && typeIndex >= summonTypeIndex
+                      && typeIndex < summonTypeIndex + 6};
+
+    *id = summon ? *other : game::emptyId;
+    return id;
+}
+
+void __fastcall idSummonUnitIdFromPosition(game::CMidgardID* id, int /*%edx*/, int position)
+{
+    if (position >= 0 && position < 6) {
+        id->value = summonTypeIndex + position;
+    }
+}
+
+int __fastcall idSummonUnitIdToPosition(const game::CMidgardID* id, int /*%edx*/)
+{
+    return (id->value & 0xffff) - summonTypeIndex;
+}
+
+game::CMidgardID* __stdcall idChangeType(game::CMidgardID* id,
+                                         const game::CMidgardID* src,
+                                         game::IdType newType)
+{
+    return idFromParts(id, idGetCategory(src, 0), idGetCategoryIndex(src, 0), newType,
+                       idGetTypeIndex(src, 0));
+}
+
+game::CMidgardID* __stdcall idValidateId(game::CMidgardID* value, game::CMidgardID id)
+{
+    *value = isValid(&id) ? id : game::invalidId;
+    return value;
+}
+
+/** Soldier interface of the stand-in unit implementation, reads stats of the unit. */
+struct StandInSoldier : public game::IUsSoldier
+{
+    const StandInUnit* stats;
+    game::CMidgardID raceId;
+    game::LSubRaceCategory subrace;
+    int armor;
+    int regen;
+};
+
+struct StandInUnitImpl : public game::IUsUnit
+{
+    StandInSoldier soldier;
+};
+
+struct StandInMidUnit : public game::CMidUnit
+{
+    StandInUnit stats;
+    StandInUnitImpl impl;
+};
+
+const game::CMidgardID* __fastcall soldierGetRaceId(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return &thisptr->raceId;
+}
+
+const game::LSubRaceCategory* __fastcall soldierGetSubrace(const StandInSoldier* thisptr,
+                                                           int /*%edx*/)
+{
+    return &thisptr->subrace;
+}
+
+bool __fastcall soldierGetSizeSmall(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->small;
+}
+
+bool __fastcall soldierGetSexM(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->male;
+}
+
+int __fastcall soldierGetLevel(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->level;
+}
+
+int __fastcall soldierGetHitPoints(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->hpMax;
+}
+
+int* __fastcall soldierGetArmor(const StandInSoldier* thisptr, int /*%edx*/, int* armor)
+{
+    *armor = thisptr->armor;
+    return armor;
+}
+
+int* __fastcall soldierGetRegen(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return const_cast<int*>(&thisptr->regen);
+}
+
+int __fastcall soldierGetXpNext(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->xpNext;
+}
+
+int __fastcall soldierGetXpKilled(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->xpKilled;
+}
+
+bool __fastcall soldierGetAttackTwice(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->attacksTwice;
+}
+
+bool __fastcall soldierGetWaterOnly(const StandInSoldier* thisptr, int /*%edx*/)
+{
+    return thisptr->stats->waterOnly;
+}
+
+int __fastcall soldierGetDynUpgLvl(const StandInSoldier*, int /*%edx*/)
+{
+    return 0;
+}
+
+const game::CMidgardID* __fastcall soldierGetDynUpgrade(const StandInSoldier*, int /*%edx*/)
+{
+    return &game::emptyId;
+}
+
+const game::IUsSoldierVftable& soldierVftable()
+{
+    static const game::IUsSoldierVftable vftable = []() {
+        using namespace game;
+
+        IUsSoldierVftable value{};
+        value.getRaceId = (IUsSoldierVftable::GetId)soldierGetRaceId;
+        value.getSubrace = (IUsSoldierVftable::GetSubrace)soldierGetSubrace;
+        value.getSizeSmall = (IUsSoldierVftable::GetBool)soldierGetSizeSmall;
+        value.getSexM = (IUsSoldierVftable::GetBool)soldierGetSexM;
+        value.getLevel = (IUsSoldierVftable::GetInt)soldierGetLevel;
+        value.getHitPoints = (IUsSoldierVftable::GetInt)soldierGetHitPoints;
+        value.getArmor = (IUsSoldierVftable::GetArmor)soldierGetArmor;
+        value.getRegen = (IUsSoldierVftable::GetRegen)soldierGetRegen;
+        value.getXpNext = (IUsSoldierVftable::GetInt)soldierGetXpNext;
+        value.getXpKilled = (IUsSoldierVftable::GetInt)soldierGetXpKilled;
+        value.getAttackTwice = (IUsSoldierVftable::GetBool)soldierGetAttackTwice;
+        value.getDynUpg1 = (IUsSoldierVftable::GetId)soldierGetDynUpgrade;
+        value.getDynUpgLvl = (IUsSoldierVftable::GetDynUpgLvl)soldierGetDynUpgLvl;
+        value.getDynUpg2 = (IUsSoldierVftable::GetId)soldierGetDynUpgrade;
+        value.getWaterOnly = (IUsSoldierVftable::GetBool)soldierGetWaterOnly;
+        return value;
+    }();
+
+    return vftable;
+}
+
+/** Race types of global data, indexed by RaceId. */
+struct StandInRace
+{
+    game::TRaceType type;
+    game::TRaceTypeData data;
+};
+
+struct StandInObjectMap : public game::IMidgardObjectMap
+{
+    game::CMidgardID scenarioId;
+    std::unordered_map<int, game::IMidScenarioObject*> battleObjects;
+    std::unordered_map<int, game::IMidScenarioObject*> scenarioObjects;
+};
+
+struct BattleWorld
+{
+    std::vector<std::unique_ptr<StandInMidUnit>> units;
+    game::CMidUnitGroup groups[2];
+    game::BattleMsgData battleMsgData;
+    game::IBatAttack batAttack;
+    bool summonAttack;
+    StandInBattleObjects objects;
+};
+
+struct ScenarioWorld
+{
+    std::vector<std::unique_ptr<game::CMidPlayer>> players;
+    std::vector<game::CMidgardMapBlock> blocks;
+    std::vector<game::ScenarioVariablesListNode> variableNodes;
+    game::CScenarioInfo info;
+    game::CMidLocation location;
+    game::CMidScenVariables variables;
+    game::CMidgardData midgardData;
+    game::CMidgard midgard;
+    StandInScenarioObjects objects;
+};
+
+struct World
+{
+    StandInObjectMap objectMap{};
+    std::unique_ptr<BattleWorld> battle;
+    std::unique_ptr<ScenarioWorld> scenario;
+    StandInRace races[6]{};
+    game::GlobalData globalData{};
+    game::GlobalData* globalDataPtr{&globalData};
+    game::CUnitGenerator unitGenerator{};
+    /** Unit implementations and race types by their ids. */
+    std::unordered_map<int, void*> globalObjects;
+};
+
+World& world()
+{
+    static World instance;
+    return instance;
+}
+
+game::IMidScenarioObject* findObject(const game::CMidgardID* id)
+{
+    const auto& objectMap = world().objectMap;
+
+    auto it = objectMap.battleObjects.find(id->value);
+    if (it != objectMap.battleObjects.end()) {
+        return it->second;
+    }
+
+    it = objectMap.scenarioObjects.find(id->value);
+    return it != objectMap.scenarioObjects.end() ? it->second : nullptr;
+}
+
+const game::CMidgardID* __fastcall objectMapGetId(const StandInObjectMap* thisptr, int /*%edx*/)
+{
+    return &thisptr->scenarioId;
+}
+
+int __fastcall objectMapGetObjectsTotal(const StandInObjectMap* thisptr, int /*%edx*/)
+{
+    return static_cast<int>(thisptr->battleObjects.size() + thisptr->scenarioObjects.size());
+}
+
+game::IMidScenarioObject* __fastcall objectMapFindObject(const StandInObjectMap*,
+                                                         int /*%edx*/,
+                                                         const game::CMidgardID* id)
+{
+    return findObject(id);
+}
+
+const game::IMidgardObjectMapVftable objectMapVftable{
+    nullptr,
+    (game::IMidgardObjectMapVftable::GetId)objectMapGetId,
+    (game::IMidgardObjectMapVftable::GetObjectsTotal)objectMapGetObjectsTotal,
+    nullptr,
+    nullptr,
+    (game::IMidgardObjectMapVftable::FindScenarioObjectById)objectMapFindObject,
+    (game::IMidgardObjectMapVftable::FindScenarioObjectByIdForChange)objectMapFindObject,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+};
+
+StandInMidUnit* findUnit(const game::CMidgardID* unitId)
+{
+    if (!world().battle || idGetType(unitId, 0) != game::IdType::Unit) {
+        return nullptr;
+    }
+
+    const auto it = world().objectMap.battleObjects.find(unitId->value);
+    if (it == world().objectMap.battleObjects.end()) {
+        return nullptr;
+    }
+
+    return static_cast<StandInMidUnit*>(it->second);
+}
+
+game::CMidUnit* __stdcall findUnitById(const game::IMidgardObjectMap*,
+                                       const game::CMidgardID* unitId)
+{
+    return findUnit(unitId);
+}
+
+game::IUsSoldier* __stdcall castUnitImplToSoldier(const game::IUsUnit* unitImpl)
+{
+    auto impl = static_cast<const StandInUnitImpl*>(unitImpl);
+    return const_cast<StandInSoldier*>(&impl->soldier);
+}
+
+game::CMidUnitGroup* __fastcall getStackFortRuinGroup(void*,
+                                                      int /*%edx*/,
+                                                      const game::IMidgardObjectMap*,
+                                                      const game::CMidgardID* objectId)
+{
+    auto& battle = world().battle;
+    if (!battle) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (battle->objects.groupIds[i] == *objectId) {
+            return &battle->groups[i];
+        }
+    }
+
+    return nullptr;
+}
+
+int __stdcall getUnitPositionDistance(int unitPosition, int targetPosition, bool isTargetAlly)
+{
+    if (unitPosition < 0 || unitPosition >= 6 || targetPosition < 0 || targetPosition >= 6) {
+        return 0;
+    }
+
+    return standIns().distances[unitPosition][isTargetAlly ? targetPosition : targetPosition + 6];
+}
+
+int __fastcall unitGetHpMax(const StandInMidUnit* thisptr, int /*%edx*/)
+{
+    return thisptr->stats.hpMax;
+}
+
+int __fastcall groupGetUnitPosition(const game::CMidUnitGroup* thisptr,
+                                    int /*%edx*/,
+                                    const game::CMidgardID* unitId)
+{
+    for (int i = 0; i < 6; ++i) {
+        if (thisptr->positions[i] == *unitId) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+const game::CMidgardID* __fastcall groupGetUnitIdByPosition(const game::CMidUnitGroup* thisptr,
+                                                            int /*%edx*/,
+                                                            int position)
+{
+    if (position < 0 || position >= 6) {
+        return &game::emptyId;
+    }
+
+    return &thisptr->positions[position];
+}
+
+game::UnitInfo* __stdcall getUnitInfoById(const game::BattleMsgData* battleMsgData,
+                                          const game::CMidgardID* unitId)
+{
+    for (auto& info : battleMsgData->unitsInfo) {
+        if (info.unitId1 == *unitId) {
+            return const_cast<game::UnitInfo*>(&info);
+        }
+    }
+
+    return nullptr;
+}
+
+bool __fastcall getUnitStatus(const game::BattleMsgData* thisptr,
+                              int /*%edx*/,
+                              const game::CMidgardID* unitId,
+                              game::BattleStatus status)
+{
+    const auto info = getUnitInfoById(thisptr, unitId);
+    return info && (info->unitStatuses & (std::uint64_t{1} << static_cast<int>(status))) != 0;
+}
+
+bool __stdcall canPerformAttackOnUnit(const game::IMidgardObjectMap*,
+                                      const game::BattleMsgData*,
+                                      const game::IBatAttack*,
+                                      const game::CMidgardID* unitId)
+{
+    const auto unit = findUnit(unitId);
+    return unit && unit->stats.attackable;
+}
+
+bool __fastcall batAttackCanTargetEmpty(const game::IBatAttack*,
+                                        int /*%edx*/,
+                                        const game::BattleMsgData*)
+{
+    return world().battle && world().battle->summonAttack;
+}
+
+const game::IBatAttackVftable& batAttackVftable()
+{
+    static const game::IBatAttackVftable vftable = []() {
+        game::IBatAttackVftable value{};
+        value.method17 = (game::IBatAttackVftable::UnknownMethod)batAttackCanTargetEmpty;
+        return value;
+    }();
+
+    return vftable;
+}
+
+game::GlobalData** __cdecl getGlobalData()
+{
+    return &world().globalDataPtr;
+}
+
+void* __fastcall findGlobalById(void*, int /*%edx*/, const game::CMidgardID* id)
+{
+    const auto& objects = world().globalObjects;
+
+    const auto it = objects.find(id->value);
+    return it != objects.end() ? it->second : nullptr;
+}
+
+const game::CDynUpgrade* __fastcall findDynUpgradeById(game::DynUpgradeList*,
+                                                       int /*%edx*/,
+                                                       const game::CMidgardID*)
+{
+    return nullptr;
+}
+
+/** Stand-in units are global, so their implementations are global as well. */
+game::CMidgardID* __fastcall getGlobalUnitImplId(game::CUnitGenerator*,
+                                                 int /*%edx*/,
+                                                 game::CMidgardID* resultUnitImplId,
+                                                 const game::CMidgardID* unitImplId)
+{
+    *resultUnitImplId = *unitImplId;
+    return resultUnitImplId;
+}
+
+game::CUnitGeneratorVftable& unitGeneratorVftable()
+{
+    static game::CUnitGeneratorVftable vftable = []() {
+        game::CUnitGeneratorVftable value{};
+        value.getGlobalUnitImplId = (game::CUnitGeneratorVftable::GetGlobalUnitImplId)
+            getGlobalUnitImplId;
+        return value;
+    }();
+
+    return vftable;
+}
+
+void* __cdecl dynamicCast(const void* ptr,
+                          int,
+                          const game::TypeDescriptor*,
+                          const game::TypeDescriptor* dstType,
+                          int)
+{
+    auto& scenario = world().scenario;
+    if (scenario && dstType == game::RttiApi::rtti().CMidLocationType
+        && ptr == static_cast<const game::IMidScenarioObject*>(&scenario->location)) {
+        return &scenario->location;
+    }
+
+    return nullptr;
+}
+
+void* __cdecl allocate(int sizeBytes)
+{
+    return std::malloc(static_cast<std::size_t>(sizeBytes));
+}
+
+void __cdecl freeNonZero(void* ptr)
+{
+    std::free(ptr);
+}
+
+game::CMidgard* __cdecl midgardInstance()
+{
+    auto& scenario = world().scenario;
+    return scenario ? &scenario->midgard : nullptr;
+}
+
+/** All players are affected by the stand-in event. */
+bool __stdcall eventAffectsPlayer(const game::IMidgardObjectMap*,
+                                  const game::CMidgardID*,
+                                  const game::CMidgardID*)
+{
+    return true;
+}
+
+/** Objects of stand-in scenario are owned by the world, destructor only notifies the proxy. */
+void __fastcall destroyScenarioObject(game::IMidObject*, int /*%edx*/, char)
+{ }
+
+/** Not const, proxy replaces destructor of scenario variables. */
+game::IMidScenarioObjectVftable& scenVariablesVftable()
+{
+    static game::IMidScenarioObjectVftable vftable = []() {
+        game::IMidScenarioObjectVftable value{};
+        value.destructor = (game::IMidObjectVftable::Destructor)destroyScenarioObject;
+        return value;
+    }();
+
+    return vftable;
+}
+
+void __stdcall advanceVariable(game::ScenarioVariablesListNode** current,
+                               game::ScenarioVariablesListNode*)
+{
+    *current = (*current)->greater;
+}
+
+game::ScenarioVariableData* __fastcall getVariableData(const game::CMidScenVariables* thisptr,
+                                                       int /*%edx*/,
+                                                       int variableId)
+{
+    static game::ScenarioVariableData empty{};
+
+    const auto begin = thisptr->variables.begin;
+    for (auto node = begin->less; node != begin; node = node->greater) {
+        if (node->value.variableId == variableId) {
+            return &node->value.data;
+        }
+    }
+
+    return &empty;
+}
+
+/** Stream that reads values by their names, as scenario loading does. */
+struct StandInStream : public game::IMidgardStream
+{
+    const std::map<std::string, int>* values;
+};
+
+const int* findStreamValue(const StandInStream* stream, const char* name)
+{
+    const auto it = stream->values->find(name);
+    return it != stream->values->end() ? &it->second : nullptr;
+}
+
+bool __fastcall streamReadMode(StandInStream*, int /*%edx*/)
+{
+    return true;
+}
+
+bool __fastcall streamHasValue(StandInStream* thisptr, int /*%edx*/, const char* name)
+{
+    return findStreamValue(thisptr, name) != nullptr;
+}
+
+void __fastcall streamInt(StandInStream* thisptr, int /*%edx*/, const char* name, int* data)
+{
+    if (auto value = findStreamValue(thisptr, name)) {
+        *data = *value;
+    }
+}
+
+void __fastcall streamBool(StandInStream* thisptr, int /*%edx*/, const char* name, bool* data)
+{
+    if (auto value = findStreamValue(thisptr, name)) {
+        *data = *value != 0;
+    }
+}
+
+/** Value of currency is its gold, other resources are zero. */
+void __fastcall streamCurrency(StandInStream* thisptr,
+                               int /*%edx*/,
+                               const char* name,
+                               game::Bank* data)
+{
+    if (auto value = findStreamValue(thisptr, name)) {
+        *data = game::Bank{};
+        data->gold = static_cast<std::int16_t>(*value);
+    }
+}
+
+game::IMidgardStreamVftable& streamVftable()
+{
+    static game::IMidgardStreamVftable vftable = []() {
+        using namespace game;
+
+        IMidgardStreamVftable value{};
+        value.readMode = (IMidgardStreamVftable::GetBool)streamReadMode;
+        value.hasValue = (IMidgardStreamVftable::HasValue)streamHasValue;
+        value.streamInt = (IMidgardStreamVftable::StreamData<int>)streamInt;
+        value.streamBool = (IMidgardStreamVftable::StreamData<bool>)streamBool;
+        value.streamCurrency = (IMidgardStreamVftable::StreamData<Bank>)streamCurrency;
+        return value;
+    }();
+
+    return vftable;
+}
+
+StandInRace& race(game::RaceId raceId)
+{
+    return world().races[static_cast<int>(raceId)];
+}
+
+} // namespace
+
+void installGameStandIns()
+{
+    using namespace game;
+
+    hooks::currentGameVersion = hooks::GameVersion::Akella;
+
+    auto& id = CMidgardIDApi::get();
+    id.getCategory = (CMidgardIDApi::Api::GetCategory)idGetCategory;
+    id.getCategoryIndex = (CMidgardIDApi::Api::GetCategoryIndex)idGetCategoryIndex;
+    id.getType = (CMidgardIDApi::Api::GetType)idGetType;
+    id.getTypeIndex = (CMidgardIDApi::Api::GetTypeIndex)idGetTypeIndex;
+    id.toString = (CMidgardIDApi::Api::ToString)idToString;
+    id.fromString = (CMidgardIDApi::Api::FromString)idFromString;
+    id.fromParts = idFromParts;
+    id.isIdStringValid = idIsStringValid;
+    id.isSummonUnitId = (CMidgardIDApi::Api::IsSummonUnitId)idIsSummonUnitId;
+    id.summonUnitIdFromPosition = (CMidgardIDApi::Api::SummonUnitIdFromPosition)
+        idSummonUnitIdFromPosition;
+    id.summonUnitIdToPosition = (CMidgardIDApi::Api::SummonUnitIdToPosition)
+        idSummonUnitIdToPosition;
+    id.changeType = idChangeType;
+    id.validateId = idValidateId;
+
+    auto& fn = gameFunctions();
+    fn.findUnitById = findUnitById;
+    fn.castUnitImplToSoldier = castUnitImplToSoldier;
+    fn.getStackFortRuinGroup = (GetStackFortRuinGroup)getStackFortRuinGroup;
+    fn.getUnitPositionDistance = getUnitPositionDistance;
+
+    CMidUnitApi::get().getHpMax = (CMidUnitApi::Api::GetHpMax)unitGetHpMax;
+
+    auto& group = CMidUnitGroupApi::get();
+    group.getUnitPosition = (CMidUnitGroupApi::Api::GetUnitPosition)groupGetUnitPosition;
+    group.getUnitIdByPosition = (CMidUnitGroupApi::Api::GetUnitIdByPosition)
+        groupGetUnitIdByPosition;
+
+    auto& battle = BattleMsgDataApi::get();
+    battle.getUnitStatus = (BattleMsgDataApi::Api::GetUnitStatus)getUnitStatus;
+    battle.getUnitInfoById = getUnitInfoById;
+    battle.canPerformAttackOnUnitWithStatusCheck = canPerformAttackOnUnit;
+
+    auto& global = GlobalDataApi::get();
+    global.getGlobalData = getGlobalData;
+    global.findById = (GlobalDataApi::Api::FindById)findGlobalById;
+    global.findDynUpgradeById = (GlobalDataApi::Api::FindDynUpgradeById)findDynUpgradeById;
+
+    RttiApi::get().dynamicCast = dynamicCast;
+
+    auto& memory = Memory::get();
+    memory.allocate = allocate;
+    memory.freeNonZero = freeNonZero;
+
+    CMidgardApi::get().instance = midgardInstance;
+    CMidEventApi::get().affectsPlayer = eventAffectsPlayer;
+
+    auto& variables = CMidScenVariablesApi::get();
+    variables.advance = advanceVariable;
+    variables.getData = (CMidScenVariablesApi::Api::GetData)getVariableData;
+
+    auto& data = world();
+    data.objectMap.vftable = &objectMapVftable;
+    data.objectMap.scenarioId = makeId(IdCategory::Scenario, scenarioIndex, IdType::ScenarioFile,
+                                       0);
+
+    data.unitGenerator.vftable = &unitGeneratorVftable();
+    data.globalData.unitGenerator = &data.unitGenerator;
+
+    for (int i = 0; i < static_cast<int>(std::size(data.races)); ++i) {
+        auto& standIn = data.races[i];
+        standIn.type.raceId = makeId(IdCategory::Global, 0, IdType::Race, i);
+        standIn.type.data = &standIn.data;
+        standIn.data.raceType.id = static_cast<RaceId>(i);
+
+        data.globalObjects[standIn.type.raceId.value] = &standIn.type;
+    }
+}
+
+const StandInBattleObjects& setBattle(const StandInBattle& battle)
+{
+    using namespace game;
+
+    auto& data = world();
+    if (data.battle) {
+        for (const auto& unit : data.battle->units) {
+            data.globalObjects.erase(unit->impl.unitId.value);
+        }
+    }
+
+    data.objectMap.battleObjects.clear();
+    data.battle = std::make_unique<BattleWorld>();
+
+    auto& battleWorld = *data.battle;
+    battleWorld.summonAttack = battle.summonAttack;
+    battleWorld.batAttack.vftable = &batAttackVftable();
+
+    auto& objects = battleWorld.objects;
+    objects.objectMap = &data.objectMap;
+    objects.battleMsgData = &battleWorld.battleMsgData;
+    objects.batAttack = &battleWorld.batAttack;
+
+    std::size_t unitsInfo{};
+    for (int i = 0; i < 2; ++i) {
+        const auto groupId = makeId(IdCategory::Scenario, scenarioIndex, IdType::Stack, i);
+        objects.groupIds[i] = groupId;
+
+        auto& group = battleWorld.groups[i];
+        for (int position = 0; position < 6; ++position) {
+            group.positions[position] = emptyId;
+            objects.unitIds[i][position] = emptyId;
+
+            const auto& stats = battle.groups[i][position];
+            if (!stats) {
+                continue;
+            }
+
+            const int index{i * 6 + position};
+            auto unit = std::make_unique<StandInMidUnit>();
+            unit->stats = *stats;
+            unit->unitId = makeId(IdCategory::Scenario, scenarioIndex, IdType::Unit, index);
+            unit->currentHp = stats->hp;
+            unit->currentXp = stats->xp;
+            unit->unitImpl = &unit->impl;
+
+            auto& impl = unit->impl;
+            impl.unitId = makeId(IdCategory::Global, 0, IdType::UnitGlobal, index);
+
+            auto& soldier = impl.soldier;
+            soldier.vftable = &soldierVftable();
+            soldier.stats = &unit->stats;
+            soldier.raceId = race(stats->race).type.raceId;
+            soldier.subrace.id = stats->subrace;
+            soldier.armor = stats->armor;
+            soldier.regen = stats->regen;
+
+            auto& info = battleWorld.battleMsgData.unitsInfo[unitsInfo++];
+            info.unitId1 = unit->unitId;
+            info.unitStatuses = stats->statuses;
+
+            group.positions[position] = unit->unitId;
+            objects.unitIds[i][position] = unit->unitId;
+            data.objectMap.battleObjects[unit->unitId.value] = unit.get();
+            data.globalObjects[impl.unitId.value] = &impl;
+            battleWorld.units.push_back(std::move(unit));
+        }
+    }
+
+    battleWorld.battleMsgData.attackerGroupId = objects.groupIds[0];
+    battleWorld.battleMsgData.defenderGroupId = objects.groupIds[1];
+
+    return objects;
+}
+
+const StandInScenarioObjects& setScenario(const StandInScenario& scenario)
+{
+    using namespace game;
+
+    auto& data = world();
+    data.objectMap.scenarioObjects.clear();
+    if (data.scenario) {
+        // The game destroys variables of the previous scenario when another one is loaded
+        auto& variables = data.scenario->variables;
+        variables.vftable->destructor(reinterpret_cast<game::IMidObject*>(&variables), 1);
+    }
+
+    data.scenario = std::make_unique<ScenarioWorld>();
+
+    auto& scenarioWorld = *data.scenario;
+    auto& objects = scenarioWorld.objects;
+    auto& scenarioObjects = data.objectMap.scenarioObjects;
+    objects.objectMap = &data.objectMap;
+    objects.eventId = makeId(IdCategory::Scenario, scenarioIndex, IdType::Event, 0);
+
+    scenarioWorld.midgardData.multiplayerGame = scenario.multiplayer;
+    scenarioWorld.midgardData.hotseatGame = scenario.hotseat;
+    scenarioWorld.midgard.data = &scenarioWorld.midgardData;
+
+    auto& info = scenarioWorld.info;
+    info.infoId = makeId(IdCategory::Scenario, scenarioIndex, IdType::ScenarioInfo, 0);
+    info.currentTurn = scenario.day;
+    info.mapSize = scenario.mapSize;
+    scenarioObjects[info.infoId.value] = &info;
+
+    // Map blocks must not move after they are added to the object map
+    scenarioWorld.blocks.resize(((scenario.mapSize + 7) / 8) * ((scenario.mapSize + 3) / 4));
+
+    auto block = scenarioWorld.blocks.begin();
+    for (int blockY = 0; blockY < scenario.mapSize; blockY += 4) {
+        for (int blockX = 0; blockX < scenario.mapSize; blockX += 8, ++block) {
+            block->blockId = makeId(IdCategory::Scenario, scenarioIndex, IdType::MapBlock,
+                                    blockX | (blockY << 8));
+            block->position = CMqPoint{blockX, blockY};
+
+            for (int i = 0; i < 32; ++i) {
+                const int x = blockX + i % 8;
+                const int y = blockY + i / 8;
+                const auto terrain = (x + y) % 7 == 0 ? TerrainId::Neutral : TerrainId::Human;
+                block->tiles[i] = static_cast<std::uint32_t>(terrain);
+            }
+
+            scenarioObjects[block->blockId.value] = &*block;
+        }
+    }
+
+    auto& location = scenarioWorld.location;
+    location.locationId = makeId(IdCategory::Scenario, scenarioIndex, IdType::Location, 0);
+    location.position = CMqPoint{scenario.mapSize / 2, scenario.mapSize / 2};
+    location.radius = scenario.locationRadius;
+    objects.locationId = location.locationId;
+    scenarioObjects[location.locationId.value] = static_cast<IMidScenarioObject*>(&location);
+
+    // Sorted list of variables is kept as a chain of greater nodes that ends at the first node
+    auto& variables = scenarioWorld.variables;
+    variables.vftable = &scenVariablesVftable();
+    variables.variablesId = makeId(IdCategory::Scenario, scenarioIndex, IdType::ScenarioVariable,
+                                   0);
+    scenarioWorld.variableNodes.resize(static_cast<std::size_t>(scenario.variablesTotal) + 1);
+
+    auto& nodes = scenarioWorld.variableNodes;
+    for (std::size_t i = 1; i < nodes.size(); ++i) {
+        auto& variable = nodes[i].value;
+        variable.variableId = static_cast<int>(i - 1);
+        variable.data.value = variable.variableId;
+        std::snprintf(variable.data.name, sizeof(variable.data.name), "VAR%d",
+                      variable.variableId);
+
+        nodes[i - 1].greater = &nodes[i];
+    }
+
+    nodes.back().greater = &nodes.front();
+    nodes.front().less = nodes.front().greater;
+    variables.variables.length = static_cast<std::uint32_t>(scenario.variablesTotal);
+    variables.variables.begin = &nodes.front();
+    variables.variables.end = &nodes.front();
+    scenarioObjects[variables.variablesId.value] = &variables;
+
+    for (int i = 0; i < scenario.playersTotal; ++i) {
+        auto player = std::make_unique<CMidPlayer>();
+        player->playerId = makeId(IdCategory::Scenario, scenarioIndex, IdType::Player, i);
+        player->raceId = race(RaceId::Human).type.raceId;
+        player->raceType = &race(RaceId::Human).type;
+        player->bank = scenario.bank;
+        player->isHuman = i == 0;
+
+        objects.playerIds.push_back(player->playerId);
+        scenarioObjects[player->playerId.value] = player.get();
+        scenarioWorld.players.push_back(std::move(player));
+    }
+
+    return objects;
+}
+
+void readCondition(game::CMidEvCondition* condition, const std::map<std::string, int>& values)
+{
+    StandInStream stream{};
+    stream.vftable = &streamVftable();
+    stream.values = &values;
+
+    game::IMidgardStream* streamPtr = &stream;
+    condition->vftable->stream(condition, &streamPtr);
+}
+
+} // namespace benchtool
@@ -0,0 +1,916 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks of proxy logic: DBF loading, damage ratio math, debug logging, targeting scripts
+ * and event conditions.
+ * Targeting and event conditions run through the real proxy code and bindings,
+ * game functions they call are replaced with stand-ins working with configurable
+ * in-memory battle and scenario, see standins.h.
+ * Results are compared with stored baseline to catch performance regressions.
+ */
+
+#include "customattacks.h"
+#include "customattackutils.h"
+#include "damageratio.h"
+#include "dbffile.h"
+#include "dbfheader.h"
+#include "dbfindex.h"
+#include "dbftable.h"
+#include "dbfwriter.h"
+#include "log.h"
+#include "luagctelemetry.h"
+#include "mappedfile.h"
+#include "midcondgamemode.h"
+#include "midcondownresource.h"
+#include "midcondplayertype.h"
+#include "midcondvarcmp.h"
+#include "midevcondition.h"
+#include "scenarioview.h"
+#include "scripts.h"
+#include "settings.h"
+#include "standins.h"
+#include "testcondition.h"
+#include "testconditioncache.h"
+#include "unitslotview.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sol/sol.hpp>
+#include <string>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+struct Options
+{
+    std::filesystem::path baseline{"benchBaseline.txt"};
+    std::filesystem::path scriptsFolder{"Scripts"};
+    std::filesystem::path examplesFolder{"Examples"};
+    std::filesystem::path workFolder{std::filesystem::temp_directory_path() / "benchtool"};
+    std::string filter;
+    /** Allowed slowdown relative to baseline, in percents. */
+    double threshold{10.0};
+    std::uint32_t records{100000};
+    int targets{6};
+    int mapSize{48};
+    bool updateBaseline{};
+};
+
+struct Result
+{
+    std::string name;
+    double nanoseconds; /**< Per operation. */
+};
+
+/**
+ * Runs operation the specified number of times in several rounds.
+ * Minimum of the rounds is used since it is the least affected by other processes.
+ */
+double measure(std::uint64_t operations, const std::function<void()>& run)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches and lazily initialized data
+    run();
+
+    double best{};
+    for (int round = 0; round < 5; ++round) {
+        const auto start{Clock::now()};
+        run();
+        const std::chrono::duration<double, std::nano> elapsed{Clock::now() - start};
+
+        const double perOperation{elapsed.count() / operations};
+        if (round == 0 || perOperation < best) {
+            best = perOperation;
+        }
+    }
+
+    return best;
+}
+
+class Suite
+{
+public:
+    explicit Suite(const Options& options)
+        : options{options}
+    { }
+
+    void add(const std::string& name, std::uint64_t operations, const std::function<void()>& run)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) {
+            return;
+        }
+
+        const double nanoseconds{measure(operations, run)};
+        std::printf("%-48s %12.1f ns/op\n", name.c_str(), nanoseconds);
+        std::fflush(stdout);
+
+        results.push_back({name, nanoseconds});
+    }
+
+    const std::vector<Result>& getResults() const
+    {
+        return results;
+    }
+
+private:
+    const Options& options;
+    std::vector<Result> results;
+};
+
+/** Prevents compiler from optimizing away benchmarked computations. */
+volatile std::uint64_t sink{};
+
+/** Writes synthetic table with unit-like records, same as 'dbftool generate'. */
+bool generateTable(const std::filesystem::path& path, std::uint32_t recordsTotal)
+{
+    DbfWriter writer;
+    if (!writer.open(path, {{"UNIT_ID", ColumnType::Character, 10},
+                            {"NAME_TXT", ColumnType::Character, 10},
+                            {"LEVEL", ColumnType::Number, 3},
+                            {"HIT_POINT", ColumnType::Number, 6},
+                            {"SIZE_SMALL", ColumnType::Logical, 1},
+                            {"DESCR", ColumnType::Character, 60}})) {
+        return false;
+    }
+
+    const auto& columns = writer.columns();
+    static const char* words[] = {"goblin", "archer", "knight", "mage", "dragon", "wolf"};
+
+    std::uint64_t random{0x9e3779b97f4a7c15ull};
+    char text[16];
+    for (std::uint32_t i = 0; i < recordsTotal; ++i) {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+
+        auto record = writer.newRecord();
+        std::snprintf(text, sizeof(text), "G%09X", i);
+        writeField(record, columns[0], text);
+        std::snprintf(text, sizeof(text), "X%09X", i % 1000000);
+        writeField(record, columns[1], text);
+        writeField(record, columns[2], static_cast<int>(random % 10 + 1));
+        writeField(record, columns[3], static_cast<int>(random % 3000 + 10));
+        writeField(record, columns[4], (random & 1) != 0);
+        writeField(record, columns[5], words[random % std::size(words)]);
+
+        if (!writer.writeRecord()) {
+            return false;
+        }
+    }
+
+    return writer.close();
+}
+
+/** Reads every field of every record through DbfRecord, the way tables were read before. */
+std::uint64_t scanRecords(const DbfFile& dbf)
+{
+    std::uint64_t sum{};
+    DbfRecord record;
+    for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i) {
+        if (!dbf.record(record, i)) {
+            continue;
+        }
+
+        for (std::uint32_t j = 0; j < dbf.columnsTotal(); ++j) {
+            const auto& column{*dbf.column(j)};
+
+            switch (column.type) {
+            case ColumnType::Character: {
+                std::string value;
+                record.value(value, column);
+                sum += value.size();
+                break;
+            }
+
+            case ColumnType::Number: {
+                int value{};
+                record.value(value, column);
+                sum += value;
+                break;
+            }
+
+            case ColumnType::Logical: {
+                bool value{};
+                record.value(value, column);
+                sum += value;
+                break;
+            }
+            }
+        }
+    }
+
+    return sum;
+}
+
+/** Reads every cell of table, columns are resolved by names and types of DBF source. */
+std::uint64_t scanTable(const DbfTable& table, const DbfFile& dbf)
+{
+    std::vector<DbfTable::Column<std::string_view>> strings;
+    std::vector<DbfTable::Column<int>> numbers;
+    std::vector<DbfTable::Column<bool>> logicals;
+
+    for (std::uint32_t j = 0; j < dbf.columnsTotal(); ++j) {
+        const auto& column{*dbf.column(j)};
+
+        switch (column.type) {
+        case ColumnType::Character:
+            strings.push_back(table.column<std::string_view>(column.name));
+            break;
+
+        case ColumnType::Number:
+            numbers.push_back(table.column<int>(column.name));
+            break;
+
+        case ColumnType::Logical:
+            logicals.push_back(table.column<bool>(column.name));
+            break;
+        }
+    }
+
+    std::uint64_t sum{};
+    for (std::uint32_t i = 0; i < table.recordsTotal(); ++i) {
+        for (const auto& column : strings) {
+            sum += column.get(i).size();
+        }
+
+        for (const auto& column : numbers) {
+            sum += column.get(i);
+        }
+
+        for (const auto& column : logicals) {
+            sum += column.get(i);
+        }
+    }
+
+    return sum;
+}
+
+/**
+ * Compares reading whole table through DbfRecord with parsing it to DbfTable
+ * and with loading DbfTable from binary cache.
+ */
+void addTableBenchmarks(Suite& suite,
+                        const std::string& prefix,
+                        const DbfFile& dbf,
+                        const std::filesystem::path& cacheFolder)
+{
+    const auto& tablePath{dbf.path()};
+    const std::uint32_t records{std::max(dbf.recordsTotal(), 1u)};
+
+    suite.add(prefix + "/per-record", records, [&]() {
+        DbfFile file;
+        if (file.open(tablePath)) {
+            sink = sink + scanRecords(file);
+        }
+    });
+
+    suite.add(prefix + "/table-parse", records, [&]() {
+        DbfTable table;
+        if (table.open(tablePath, {})) {
+            sink = sink + scanTable(table, dbf);
+        }
+    });
+
+    {
+        // Build cache once, so the benchmark measures loading only
+        DbfTable table;
+        table.open(tablePath, cacheFolder);
+    }
+
+    suite.add(prefix + "/table-load-cache", records, [&]() {
+        DbfTable table;
+        if (table.open(tablePath, cacheFolder)) {
+            sink = sink + scanTable(table, dbf);
+        }
+    });
+}
+
+/** Adds table benchmarks for each DBF file in examples folder. */
+void addExampleTableBenchmarks(Suite& suite, const Options& options)
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> tables;
+    for (const auto& entry : std::filesystem::directory_iterator(options.examplesFolder, error)) {
+        auto extension{entry.path().extension().string()};
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (extension == ".dbf") {
+            tables.push_back(entry.path());
+        }
+    }
+
+    if (error || tables.empty()) {
+        std::fprintf(stderr, "No DBF tables found in %s, skipped\n",
+                     options.examplesFolder.string().c_str());
+        return;
+    }
+
+    std::sort(tables.begin(), tables.end());
+
+    for (const auto& path : tables) {
+        DbfFile dbf;
+        if (!dbf.open(path)) {
+            std::fprintf(stderr, "Could not open %s\n", path.string().c_str());
+            continue;
+        }
+
+        addTableBenchmarks(suite, "dbf/" + path.stem().string(), dbf,
+                           options.workFolder / "cache");
+    }
+}
+
+bool addDbfBenchmarks(Suite& suite, const Options& options)
+{
+    std::error_code error;
+    std::filesystem::create_directories(options.workFolder, error);
+
+    const auto tablePath{options.workFolder / "units.dbf"};
+    if (!generateTable(tablePath, options.records)) {
+        std::fprintf(stderr, "Could not create %s\n", tablePath.string().c_str());
+        return false;
+    }
+
+    const std::uint32_t records{options.records};
+
+    // Reads records block the way DbfFile did before files were mapped
+    suite.add("dbf/stream-read", records, [&]() {
+        std::ifstream stream(tablePath, std::ios_base::binary);
+
+        DbfHeader header{};
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        stream.seekg(header.headerLength, stream.beg);
+
+        std::vector<std::uint8_t> recordsData(header.recordsTotal * header.recordLength);
+        stream.read(reinterpret_cast<char*>(recordsData.data()), recordsData.size());
+
+        std::uint64_t deleted{};
+        for (std::size_t i = 0; i < recordsData.size(); i += header.recordLength) {
+            deleted += recordsData[i] == 0x2a;
+        }
+
+        sink = sink + deleted + recordsData.size();
+    });
+
+    suite.add("dbf/mapped-read", records, [&]() {
+        MappedFile file;
+        if (!file.open(tablePath)) {
+            return;
+        }
+
+        DbfHeader header{};
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        const std::uint8_t* recordsData{file.data() + header.headerLength};
+        const std::size_t recordsLength{header.recordsTotal * header.recordLength};
+
+        std::uint64_t deleted{};
+        for (std::size_t i = 0; i < recordsLength; i += header.recordLength) {
+            deleted += recordsData[i] == 0x2a;
+        }
+
+        sink = sink + deleted + recordsLength;
+    });
+
+    suite.add("dbf/open-and-scan", records, [&]() {
+        DbfFile dbf;
+        if (!dbf.open(tablePath)) {
+            return;
+        }
+
+        const auto level{dbf.columnRef<int>("LEVEL")};
+        const auto hitPoints{dbf.columnRef<int>("HIT_POINT")};
+        const auto name{dbf.columnRef<std::string_view>("NAME_TXT")};
+
+        std::uint64_t sum{};
+        DbfRecord record;
+        for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i) {
+            if (dbf.record(record, i)) {
+                sum += level.get(record) + hitPoints.get(record) + name.get(record).size();
+            }
+        }
+
+        sink = sink + sum;
+    });
+
+    DbfFile dbf;
+    if (!dbf.open(tablePath)) {
+        std::fprintf(stderr, "Could not open %s\n", tablePath.string().c_str());
+        return false;
+    }
+
+    suite.add("dbf/index-build", records, [&]() {
+        DbfIndex index;
+        index.build(dbf, "UNIT_ID");
+        sink = sink + index.size();
+    });
+
+    DbfIndex index;
+    index.build(dbf, "UNIT_ID");
+
+    std::vector<std::string> ids(records);
+    for (std::uint32_t i = 0; i < records; ++i) {
+        char text[16];
+        std::snprintf(text, sizeof(text), "G%09X", (i * 7919u) % records);
+        ids[i] = text;
+    }
+
+    suite.add("dbf/index-find", records, [&]() {
+        std::uint64_t sum{};
+        for (const auto& id : ids) {
+            sum += index.find(id).value_or(0);
+        }
+
+        sink = sink + sum;
+    });
+
+    addTableBenchmarks(suite, "dbf", dbf, options.workFolder / "cache");
+    addExampleTableBenchmarks(suite, options);
+    return true;
+}
+
+void addDamageRatioBenchmarks(Suite& suite, const Options& options)
+{
+    static const hooks::DamageRatio ratios[] = {
+        {100, false, false},
+        {50, false, false},
+        {50, true, false},
+        {25, true, true},
+    };
+
+    constexpr std::uint64_t iterations{100000};
+
+    suite.add("damage-ratio/compute", iterations * std::size(ratios), [&]() {
+        std::uint64_t sum{};
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            for (const auto& ratio : ratios) {
+                for (double value : hooks::computeDamageRatios(ratio, options.targets)) {
+                    sum += hooks::applyAttackDamageRatio(100, value);
+                }
+            }
+        }
+
+        sink = sink + sum;
+    });
+
+    suite.add("damage-ratio/total", iterations * std::size(ratios), [&]() {
+        double sum{};
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            for (const auto& ratio : ratios) {
+                sum += hooks::computeTotalDamageRatio(ratio, options.targets);
+            }
+        }
+
+        sink = sink + static_cast<std::uint64_t>(sum);
+    });
+}
+
+void addLogBenchmarks(Suite& suite)
+{
+    constexpr std::uint64_t messages{1000000};
+    auto& standIns{benchtool::standIns()};
+
+    standIns.debugLogs = false;
+    suite.add("log/debug-disabled", messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            hooks::logDebug("mss32Proxy.log", "Unit {:s} attacks with damage {:d} of {:d}",
+                            "S143UU0001", static_cast<int>(i), 100);
+        }
+    });
+
+    // Message formatted before the check, the way debug messages were logged before
+    suite.add("log/debug-disabled-eager", messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            hooks::logDebug("mss32Proxy.log",
+                            fmt::format("Unit {:s} attacks with damage {:d} of {:d}",
+                                        "S143UU0001", static_cast<int>(i), 100));
+        }
+    });
+
+    standIns.debugLogs = true;
+    suite.add("log/debug-enabled", messages, [&]() {
+        for (std::uint64_t i = 0; i < messages; ++i) {
+            hooks::logDebug("mss32Proxy.log", "Unit {:s} attacks with damage {:d} of {:d}",
+                            "S143UU0001", static_cast<int>(i), 100);
+        }
+    });
+
+    standIns.debugLogs = false;
+    sink = sink + standIns.loggedBytes;
+}
+
+/** Event condition from the Lua API examples. */
+const char conditionBody[] = R"(
+    local forEachTile = function (location, f)
+        local pos = location.position
+        local halfR = math.floor(location.radius / 2)
+        for x = pos.x - halfR, pos.x + halfR, 1 do
+            for y = pos.y - halfR, pos.y + halfR, 1 do
+                f(x, y)
+            end
+        end
+    end
+
+    local location = scenario:getLocation('S143LO0000')
+    if (location == nil) then
+        return false
+    end
+
+    local tilesTotal = location.radius * location.radius
+    local count = 0
+
+    forEachTile(location, function (x, y)
+        local tile = scenario:getTile(x, y)
+        if (tile ~= nil and tile.terrain == Terrain.Human) then
+            count = count + 1
+        end
+    end)
+
+    return tilesTotal == count
+)";
+
+/** Event condition that checks scenario variable. */
+const char variableConditionBody[] = R"(
+    local variable = scenario.variables:getVariable('VAR10')
+    return variable ~= nil and variable.value == 10
+)";
+
+benchtool::StandInGroup createGroup(int count, int seed)
+{
+    benchtool::StandInGroup group;
+    for (int i = 0; i < count; ++i) {
+        benchtool::StandInUnit unit;
+        unit.hp = 50 + (i * 17 + seed) % 50;
+        unit.level = (i + seed) % 5 + 1;
+        unit.male = (i + seed) % 3 != 0;
+        unit.subrace = (i + seed) % 2 == 0 ? game::SubRaceId::NeutralGreenSkin
+                                           : game::SubRaceId::Human;
+        group[i] = unit;
+    }
+
+    return group;
+}
+
+/**
+ * Runs targeting scripts through the proxy code the game calls for custom attack reaches,
+ * including script loading, battle snapshot and bindings.
+ */
+void addTargetingBenchmarks(Suite& suite, const Options& options)
+{
+    std::error_code error;
+    std::vector<std::filesystem::path> scripts;
+    for (const auto& entry : std::filesystem::directory_iterator(options.scriptsFolder, error)) {
+        const auto name{entry.path().filename().string()};
+        if (name.rfind("get", 0) == 0 && entry.path().extension() == ".lua") {
+            scripts.push_back(entry.path());
+        }
+    }
+
+    if (error || scripts.empty()) {
+        std::fprintf(stderr, "No targeting scripts found in %s, skipped\n",
+                     options.scriptsFolder.string().c_str());
+        return;
+    }
+
+    std::sort(scripts.begin(), scripts.end());
+
+    benchtool::StandInBattle battle;
+    battle.groups[0] = createGroup(options.targets, 1);
+    battle.groups[1] = createGroup(options.targets, 2);
+    const auto& objects{benchtool::setBattle(battle)};
+
+    // Attacker is the first unit of attacking group, selected is one of the targets
+    const auto& attackerGroupId{objects.groupIds[0]};
+    const auto& attackerId{objects.unitIds[0][0]};
+    const auto& targetGroupId{objects.groupIds[1]};
+
+    // Each call loads script into a new lua state
+    constexpr std::uint64_t calls{1000};
+
+    for (const auto& script : scripts) {
+        hooks::CustomAttackReach reach{};
+        reach.attackScript = script.filename().string();
+
+        const auto getTargets = [&](std::uint64_t i) {
+            const auto& targetId{objects.unitIds[1][i % options.targets]};
+            return hooks::getTargetsToAttackForCustomAttackReach(objects.objectMap,
+                                                                 objects.battleMsgData,
+                                                                 objects.batAttack,
+                                                                 &targetGroupId, &targetId,
+                                                                 &attackerGroupId,
+                                                                 &attackerId, reach);
+        };
+
+        // Broken script reports error on each call, check it once
+        auto& standIns{benchtool::standIns()};
+        const auto errors{standIns.errors};
+        getTargets(0);
+        if (standIns.errors != errors) {
+            std::fprintf(stderr, "%s failed, skipped\n", script.string().c_str());
+            continue;
+        }
+
+        suite.add("targeting/" + script.stem().string(), calls, [&]() {
+            for (std::uint64_t i = 0; i < calls; ++i) {
+                sink = sink + getTargets(i).size();
+            }
+        });
+    }
+}
+
+/** Runs condition the same way as CMidCondScript test does: in a new environment. */
+bool testScriptCondition(sol::state& lua,
+                         hooks::LuaGcTelemetry& gcTelemetry,
+                         const std::string& code,
+                         const game::IMidgardObjectMap* objectMap)
+{
+    sol::environment env{lua, sol::create, lua.globals()};
+
+    gcTelemetry.callStarted(lua.lua_state());
+    auto result = lua.safe_script(code, env, [](lua_State*, sol::protected_function_result pfr) {
+        return pfr;
+    });
+
+    bool passed{};
+    if (result.valid()) {
+        using CheckCondition = std::function<bool(const bindings::ScenarioView&)>;
+
+        auto checkCondition = hooks::getScriptFunction<CheckCondition>(env,
+                                                                       "checkEventCondition");
+        if (checkCondition) {
+            try {
+                const bindings::ScenarioView scenario{objectMap};
+                passed = (*checkCondition)(scenario);
+            } catch (const std::exception&) {
+            }
+        }
+    }
+
+    gcTelemetry.callFinished(lua.lua_state());
+    return passed;
+}
+
+struct ConditionBenchmark
+{
+    const char* name;
+    game::CMidEvCondition* (*createCondition)();
+    game::ITestCondition* (*createTest)(game::CMidEvCondition* eventCondition);
+    std::map<std::string, int> values;
+    /** Starts new session before each test, so cached results are not used. */
+    bool uncached{};
+};
+
+/**
+ * Tests custom event conditions through their test objects, the way the game does
+ * for each player at the start of turn.
+ */
+void addConditionBenchmarks(Suite& suite, const Options& options)
+{
+    benchtool::StandInScenario scenario;
+    scenario.mapSize = options.mapSize;
+    scenario.bank.gold = 500;
+    const auto& objects{benchtool::setScenario(scenario)};
+
+    constexpr std::uint64_t tests{100000};
+
+    const ConditionBenchmark benchmarks[] = {
+        {"game-mode", hooks::createMidCondGameMode, hooks::createTestGameMode, {{"MODE", 0}}},
+        {"player-type", hooks::createMidCondPlayerType, hooks::createTestPlayerType, {{"AI", 1}}},
+        {"player-type-uncached", hooks::createMidCondPlayerType, hooks::createTestPlayerType,
+         {{"AI", 1}}, true},
+        {"own-resource", hooks::createMidCondOwnResource, hooks::createTestOwnResource,
+         {{"BANK", 300}, {"GRE", 1}}},
+        // VAR1 < VAR2
+        {"variable-compare", hooks::createMidCondVarCmp, hooks::createTestVarCmp,
+         {{"VAR1", 1}, {"VAR2", 2}, {"CMP", 4}}},
+    };
+
+    for (const auto& benchmark : benchmarks) {
+        auto condition{benchmark.createCondition()};
+        benchtool::readCondition(condition, benchmark.values);
+        auto test{benchmark.createTest(condition)};
+
+        suite.add(std::string{"conditions/"} + benchmark.name, tests, [&]() {
+            std::uint64_t passed{};
+            for (std::uint64_t i = 0; i < tests; ++i) {
+                if (benchmark.uncached) {
+                    hooks::nextTestConditionGeneration();
+                }
+
+                const auto& playerId{objects.playerIds[i % objects.playerIds.size()]};
+                passed += test->vftable->test(test, objects.objectMap, &playerId,
+                                              &objects.eventId);
+            }
+
+            sink = sink + passed;
+        });
+
+        test->vftable->destructor(test, 1);
+        condition->vftable->destructor(condition, 1);
+    }
+
+    // Telemetry is declared first so it outlives the state and its finalizers
+    hooks::LuaGcTelemetry gcTelemetry{"eventConditions"};
+    sol::state lua{hooks::createLuaState(true)};
+    hooks::configureGarbageCollector(lua.lua_state(), hooks::userSettings().luaGc.eventConditions);
+    gcTelemetry.attach(lua.lua_state());
+
+    constexpr std::uint64_t scriptTests{10000};
+
+    const std::pair<const char*, const char*> scripts[] = {
+        {"script", conditionBody},
+        {"script-variable", variableConditionBody},
+    };
+
+    for (const auto& [name, body] : scripts) {
+        const auto code{fmt::format("{:s}\n{:s}\nend\n", "function checkEventCondition(scenario)",
+                                    body)};
+
+        suite.add(std::string{"conditions/"} + name, scriptTests, [&]() {
+            std::uint64_t passed{};
+            for (std::uint64_t i = 0; i < scriptTests; ++i) {
+                passed += testScriptCondition(lua, gcTelemetry, code, objects.objectMap);
+            }
+
+            sink = sink + passed;
+        });
+    }
+}
+
+std::map<std::string, double> readBaseline(const std::filesystem::path& path)
+{
+    std::map<std::string, double> baseline;
+
+    std::ifstream stream(path);
+    std::string name;
+    double nanoseconds{};
+    while (stream >> name >> nanoseconds) {
+        baseline[name] = nanoseconds;
+    }
+
+    return baseline;
+}
+
+bool writeBaseline(const std::filesystem::path& path, const std::vector<Result>& results)
+{
+    auto baseline{readBaseline(path)};
+    for (const auto& result : results) {
+        baseline[result.name] = result.nanoseconds;
+    }
+
+    std::ofstream stream(path);
+    for (const auto& [name, nanoseconds] : baseline) {
+        stream << name << ' ' << nanoseconds << '\n';
+    }
+
+    return static_cast<bool>(stream);
+}
+
+/** Returns number of benchmarks that became slower than allowed. */
+int compareWithBaseline(const Options& options, const std::vector<Result>& results)
+{
+    const auto baseline{readBaseline(options.baseline)};
+    if (baseline.empty()) {
+        std::fprintf(stderr, "No baseline in %s, run with -u to store one\n",
+                     options.baseline.string().c_str());
+        return 0;
+    }
+
+    int regressions{};
+    for (const auto& result : results) {
+        const auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            continue;
+        }
+
+        const double change{(result.nanoseconds / it->second - 1.0) * 100.0};
+        if (change > options.threshold) {
+            std::printf("REGRESSION %s: %.1f ns/op, baseline %.1f ns/op (%+.1f%%)\n",
+                        result.name.c_str(), result.nanoseconds, it->second, change);
+            ++regressions;
+        }
+    }
+
+    return regressions;
+}
+
+void printUsage()
+{
+    std::fputs(
+        "Usage:\n"
+        "  benchtool [options]\n"
+        "Options:\n"
+        "  -b <file>     baseline file, benchBaseline.txt by default\n"
+        "  -u            store results in baseline file instead of comparing\n"
+        "  -t <percent>  allowed slowdown relative to baseline, 10 by default\n"
+        "  -f <text>     run only benchmarks with names containing text\n"
+        "  -s <folder>   folder with targeting scripts, Scripts by default\n"
+        "  -e <folder>   folder with DBF tables to benchmark, Examples by default\n"
+        "  -r <records>  records in DBF benchmarks table, 100000 by default\n"
+        "  -n <count>    units in each battle group, 6 by default\n"
+        "  -m <size>     map size of event conditions scenario, 48 by default\n"
+        "  -w <folder>   folder for generated files, system temporary folder by default\n"
+        "Exit code is 1 if any benchmark is slower than baseline by more than allowed.\n",
+        stderr);
+}
+
+bool parseOptions(Options& options, int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument{argv[i]};
+        if (argument == "-u") {
+            options.updateBaseline = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const char* value = argv[++i];
+        if (argument == "-b") {
+            options.baseline = value;
+        } else if (argument == "-t") {
+            options.threshold = std::strtod(value, nullptr);
+        } else if (argument == "-f") {
+            options.filter = value;
+        } else if (argument == "-s") {
+            options.scriptsFolder = value;
+        } else if (argument == "-e") {
+            options.examplesFolder = value;
+        } else if (argument == "-r") {
+            options.records = std::strtoul(value, nullptr, 10);
+        } else if (argument == "-n") {
+            options.targets = std::clamp(std::atoi(value), 1, 6);
+        } else if (argument == "-m") {
+            options.mapSize = std::clamp(std::atoi(value), 1, 144);
+        } else if (argument == "-w") {
+            options.workFolder = value;
+        } else {
+            return false;
+        }
+    }
+
+    return options.records > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(options, argc, argv)) {
+        printUsage();
+        return 2;
+    }
+
+    benchtool::installGameStandIns();
+    benchtool::standIns().scriptsFolder = options.scriptsFolder;
+
+    Suite suite{options};
+    if (!addDbfBenchmarks(suite, options)) {
+        return 2;
+    }
+
+    addDamageRatioBenchmarks(suite, options);
+    addLogBenchmarks(suite);
+    addTargetingBenchmarks(suite, options);
+    addConditionBenchmarks(suite, options);
+
+    if (options.updateBaseline) {
+        if (!writeBaseline(options.baseline, suite.getResults())) {
+            std::fprintf(stderr, "Could not write %s\n", options.baseline.string().c_str());
+            return 2;
+        }
+
+        return 0;
+    }
+
+    return compareWithBaseline(options, suite.getResults()) ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Stand-ins of proxy functions from translation units that depend on Windows:
+ * logging, utils, metrics and trace recording, so the rest of proxy code can be linked as is.
+ * Functions that only call the game are copies of utils.cpp implementations.
+ */
+
+#include "standins.h"
+#include "dbfcatalog.h"
+#include "log.h"
+#include "metrics.h"
+#include "midgardid.h"
+#include "midgardobjectmap.h"
+#include "midscenvariables.h"
+#include "tracerecorder.h"
+#include "utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace hooks {
+
+bool debugLogEnabled()
+{
+    return benchtool::standIns().debugLogs;
+}
+
+void logDebug(std::string_view, std::string_view message)
+{
+    benchtool::standIns().loggedBytes += message.size();
+}
+
+void logError(std::string_view, std::string_view message)
+{
+    benchtool::standIns().loggedBytes += message.size();
+}
+
+void flushLogs()
+{ }
+
+const std::filesystem::path& gameFolder()
+{
+    static const std::filesystem::path folder{std::filesystem::current_path()};
+    return folder;
+}
+
+const std::filesystem::path& scriptsFolder()
+{
+    return benchtool::standIns().scriptsFolder;
+}
+
+utils::DbfCatalog& dbfCatalog()
+{
+    static utils::DbfCatalog catalog{std::filesystem::path{}};
+    return catalog;
+}
+
+std::string idToString(const game::CMidgardID* id)
+{
+    char idString[11] = {0};
+    game::CMidgardIDApi::get().toString(id, idString);
+
+    return {idString};
+}
+
+std::string getTranslatedText(const char*)
+{
+    return {};
+}
+
+bool replace(std::string& str, const std::string& keyword, const std::string& replacement)
+{
+    const auto pos = str.find(keyword);
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    str.replace(pos, keyword.length(), replacement);
+    return true;
+}
+
+std::string readFile(const std::filesystem::path& file)
+{
+    std::ifstream stream(file);
+    if (!stream) {
+        return {};
+    }
+
+    const auto size = static_cast<size_t>(std::filesystem::file_size(file));
+    std::string contents;
+    contents.resize(size);
+
+    stream.read(&contents[0], size);
+    return contents;
+}
+
+void showMessageBox(const std::string& message, game::CMidMsgBoxButtonHandler*, bool)
+{
+    ++benchtool::standIns().errors;
+    std::fprintf(stderr, "%s\n", message.c_str());
+}
+
+void showErrorMessageBox(const std::string& message)
+{
+    ++benchtool::standIns().errors;
+    std::fprintf(stderr, "%s\n", message.c_str());
+}
+
+bool writeProtectedMemory(void* address, const void* data, std::size_t size)
+{
+    // Stand-in vftables are writable
+    std::memcpy(address, data, size);
+    return true;
+}
+
+game::CMidgardID createScenarioVariablesId(const game::IMidgardObjectMap* objectMap)
+{
+    using namespace game;
+
+    const auto& id = CMidgardIDApi::get();
+    auto scenarioId = objectMap->vftable->getId(objectMap);
+
+    CMidgardID variablesId{};
+    id.fromParts(&variablesId, id.getCategory(scenarioId), id.getCategoryIndex(scenarioId),
+                 IdType::ScenarioVariable, 0);
+
+    return variablesId;
+}
+
+void forEachScenarioVariable(const game::CMidScenVariables* variables,
+                             std::function<void(const game::ScenarioVariable*, std::uint32_t)> f)
+{
+    using namespace game;
+
+    if (!variables->variables.length) {
+        return;
+    }
+
+    auto begin = variables->variables.begin;
+    auto end = variables->variables.end;
+    auto current = begin->less;
+
+    ScenarioVariablesListIterator listIterator{};
+    listIterator.node = current;
+    listIterator.node2 = end;
+
+    std::uint32_t listIndex{};
+    while (listIndex++ < variables->variables.length) {
+        const bool done = (current != begin || listIterator.node2 != end) ? false : true;
+        if (done) {
+            break;
+        }
+
+        f(&current->value, listIndex);
+
+        CMidScenVariablesApi::get().advance(&listIterator.node, listIterator.node2);
+        current = listIterator.node;
+    }
+}
+
+void addMetric(Metric, std::int64_t)
+{ }
+
+void setMetric(Metric, std::int64_t)
+{ }
+
+std::int64_t metricTicks()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void addMetricTime(Metric, std::int64_t)
+{ }
+
+void updateMetricsTurn(const game::IMidgardObjectMap*)
+{ }
+
+bool metricsWriteEnabled()
+{
+    return false;
+}
+
+bool traceRecording{false};
+
+std::uint32_t traceName(std::string_view)
+{
+    return emptyTraceName;
+}
+
+void traceRecord(TraceEvent, TracePhase, std::uint32_t, std::uint64_t)
+{ }
+
+} // namespace hooks
+
+namespace benchtool {
+
+/** Distances between positions of two groups facing each other with their front lines. */
+static DistanceTable defaultDistances()
+{
+    DistanceTable table{};
+    for (int from = 0; from < 6; ++from) {
+        const int line = from % 2;
+        const int column = from / 2;
+
+        for (int to = 0; to < 6; ++to) {
+            const int toLine = to % 2;
+            const int columns = std::abs(column - to / 2);
+
+            table[from][to] = std::abs(line - toLine) + columns;
+            table[from][to + 6] = line + toLine + 1 + columns;
+        }
+    }
+
+    return table;
+}
+
+StandIns& standIns()
+{
+    static StandIns instance{[]() {
+        StandIns value;
+        value.distances = defaultDistances();
+        return value;
+    }()};
+
+    return instance;
+}
+
+} // namespace benchtool
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef STANDINS_H
+#define STANDINS_H
+
+#include "categoryids.h"
+#include "currency.h"
+#include "midgardid.h"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace game {
+struct IMidgardObjectMap;
+struct BattleMsgData;
+struct IBatAttack;
+struct CMidEvCondition;
+} // namespace game
+
+namespace benchtool {
+
+/** Distances between battle slots, see BattleSnapshotView::getDistanceTable. */
+using DistanceTable = std::array<std::array<int, 12>, 12>;
+
+/** State of stand-ins, configured by benchmarks. */
+struct StandIns
+{
+    bool debugLogs{};
+    /** Total length of messages logged through stand-ins, keeps them from being optimized out. */
+    std::uint64_t loggedBytes{};
+    /** Number of errors that proxy code reported to the user. */
+    std::uint32_t errors{};
+    /** Folder returned by scriptsFolder(). */
+    std::filesystem::path scriptsFolder{"Scripts"};
+    /**
+     * Distances the game reports for unit positions.
+     * Rows 0-5 are positions of the unit, columns 0-5 are positions of its allies,
+     * columns 6-11 are positions of the opposing group.
+     * Must be set before the first script call, proxy reads them once.
+     */
+    DistanceTable distances;
+};
+
+StandIns& standIns();
+
+/**
+ * Replaces address tables of the game functions used by linked proxy code with stand-ins
+ * that work with in-memory objects created by setBattle and setScenario.
+ * Must be called before any proxy code runs.
+ */
+void installGameStandIns();
+
+/** Unit of the stand-in battle, fields are returned by stand-ins of the game unit methods. */
+struct StandInUnit
+{
+    int hp{100};
+    int hpMax{100};
+    int xp{};
+    int level{1};
+    int xpNext{100};
+    int xpKilled{10};
+    int armor{};
+    int regen{};
+    game::RaceId race{game::RaceId::Neutral};
+    game::SubRaceId subrace{game::SubRaceId::Neutral};
+    bool small{true};
+    bool male{true};
+    bool waterOnly{};
+    bool attacksTwice{};
+    /** Bitmask made of BattleStatus values used as shifts. */
+    std::uint64_t statuses{};
+    /** Result of the game check whether the unit can be attacked. */
+    bool attackable{true};
+};
+
+/** Units by their positions in group. */
+using StandInGroup = std::array<std::optional<StandInUnit>, 6>;
+
+struct StandInBattle
+{
+    /** Attacking group and defending group. */
+    std::array<StandInGroup, 2> groups;
+    /** Attack can target empty positions, as summon attacks do. */
+    bool summonAttack{};
+};
+
+/** Game objects created from StandInBattle, valid until the next setBattle call. */
+struct StandInBattleObjects
+{
+    const game::IMidgardObjectMap* objectMap;
+    const game::BattleMsgData* battleMsgData;
+    const game::IBatAttack* batAttack;
+    std::array<game::CMidgardID, 2> groupIds;
+    /** Ids of units by groups and positions, emptyId for empty positions. */
+    std::array<std::array<game::CMidgardID, 6>, 2> unitIds;
+};
+
+const StandInBattleObjects& setBattle(const StandInBattle& battle);
+
+struct StandInScenario
+{
+    /** Map tiles have Neutral terrain when (x + y) % 7 == 0 and Human terrain otherwise. */
+    int mapSize{48};
+    int day{1};
+    bool multiplayer{};
+    bool hotseat{};
+    /** First player is human, others are controlled by AI. */
+    int playersTotal{4};
+    game::Bank bank{};
+    /** Variables have ids from 0, names 'VAR<id>' and values equal to ids. */
+    int variablesTotal{100};
+    /** Radius of location 'S143LO0000' in the center of the map. */
+    int locationRadius{4};
+};
+
+/** Game objects created from StandInScenario, valid until the next setScenario call. */
+struct StandInScenarioObjects
+{
+    const game::IMidgardObjectMap* objectMap;
+    game::CMidgardID eventId;
+    game::CMidgardID locationId;
+    std::vector<game::CMidgardID> playerIds;
+};
+
+const StandInScenarioObjects& setScenario(const StandInScenario& scenario);
+
+/**
+ * Reads fields of event condition through its stream method, the same way scenario loading does.
+ * Values are looked up by names the condition streams its fields with.
+ */
+void readCondition(game::CMidEvCondition* condition, const std::map<std::string, int>& values);
+
+} // namespace benchtool
+
+#endif // STANDINS_H
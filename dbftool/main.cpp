@@ -0,0 +1,1226 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Command line tool for querying DBF tables.
+ * Reads tables through the same code the proxy uses, records are streamed from mapped file.
+ */
+
+#include "codepage.h"
+#include "dbfcolumndecoders.h"
+#include "dbffile.h"
+#include "dbfindex.h"
+#include "dbfwriter.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace utils;
+
+namespace {
+
+enum class Format
+{
+    Csv,
+    Json,
+    None,
+};
+
+enum class Operator
+{
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains,
+};
+
+struct Predicate
+{
+    const DbfColumn* column{};
+    Operator op{};
+    std::string value;
+    int number{};
+};
+
+struct Options
+{
+    std::vector<std::string> arguments;
+    std::vector<std::string> where;
+    std::vector<std::string> select;
+    std::vector<std::string> joinSelect;
+    Format format{Format::Csv};
+    bool utf8{true};
+    std::uint64_t limit{std::numeric_limits<std::uint64_t>::max()};
+};
+
+/** Prints records processing speed to stderr. */
+class Throughput
+{
+public:
+    explicit Throughput(std::uint32_t recordLength)
+        : recordLength{recordLength}
+        , start{Clock::now()}
+    { }
+
+    void report(const char* action,
+                std::uint64_t processed,
+                const char* resultAction,
+                std::uint64_t results) const
+    {
+        using namespace std::chrono;
+
+        const double seconds = duration<double>(Clock::now() - start).count();
+        const double mebibytes = static_cast<double>(processed) * recordLength
+                                 / (1024.0 * 1024.0);
+        const double safeSeconds = seconds > 0.0 ? seconds : 1e-9;
+
+        std::fprintf(stderr,
+                     "%s %llu records (%.1f MiB), %s %llu in %.3f s: "
+                     "%.0f records/s, %.1f MiB/s\n",
+                     action, static_cast<unsigned long long>(processed), mebibytes, resultAction,
+                     static_cast<unsigned long long>(results), seconds, processed / safeSeconds,
+                     mebibytes / safeSeconds);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::uint32_t recordLength;
+    Clock::time_point start;
+};
+
+/** Writes selected columns of records as CSV or JSON lines to stdout. */
+class RecordWriter
+{
+public:
+    RecordWriter(Format format)
+        : format{format}
+    {
+        std::setvbuf(stdout, nullptr, _IOFBF, 1 << 20);
+    }
+
+    void header(const std::vector<const DbfColumn*>& columns)
+    {
+        if (format != Format::Csv) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (i) {
+                std::fputc(',', stdout);
+            }
+
+            writeCsv(columns[i]->name);
+        }
+
+        std::fputc('\n', stdout);
+    }
+
+    void beginRecord()
+    {
+        fieldsWritten = 0;
+        if (format == Format::Json) {
+            std::fputc('{', stdout);
+        }
+    }
+
+    /** Character values are decoded to UTF-8 if decoder is specified. */
+    void field(const DbfRecord& record, const DbfColumn& column, const TextDecoder* decoder)
+    {
+        if (format == Format::None) {
+            return;
+        }
+
+        if (fieldsWritten++) {
+            std::fputc(',', stdout);
+        }
+
+        if (format == Format::Json) {
+            writeJson(column.name);
+            std::fputc(':', stdout);
+        }
+
+        switch (column.type) {
+        case ColumnType::Character: {
+            std::string_view text;
+            record.value(text, column);
+            if (decoder) {
+                decoded.clear();
+                decoder->append(decoded, text);
+                text = decoded;
+            }
+
+            format == Format::Json ? writeJson(text) : writeCsv(text);
+            break;
+        }
+
+        case ColumnType::Number: {
+            int number{};
+            if (record.value(number, column)) {
+                std::fprintf(stdout, "%d", number);
+            } else if (format == Format::Json) {
+                std::fputs("null", stdout);
+            }
+            break;
+        }
+
+        case ColumnType::Logical: {
+            bool logical{};
+            record.value(logical, column);
+            if (format == Format::Json) {
+                std::fputs(logical ? "true" : "false", stdout);
+            } else {
+                std::fputc(logical ? 'T' : 'F', stdout);
+            }
+            break;
+        }
+
+        default:
+            if (format == Format::Json) {
+                std::fputs("null", stdout);
+            }
+            break;
+        }
+    }
+
+    void endRecord()
+    {
+        if (format == Format::Json) {
+            std::fputc('}', stdout);
+        }
+
+        if (format != Format::None) {
+            std::fputc('\n', stdout);
+        }
+    }
+
+private:
+    static void writeCsv(std::string_view text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            return;
+        }
+
+        std::fputc('"', stdout);
+        for (const char c : text) {
+            if (c == '"') {
+                std::fputc('"', stdout);
+            }
+
+            std::fputc(c, stdout);
+        }
+
+        std::fputc('"', stdout);
+    }
+
+    static void writeJson(std::string_view text)
+    {
+        std::fputc('"', stdout);
+        for (const char c : text) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                std::fputc('\\', stdout);
+                std::fputc(c, stdout);
+            } else if (byte < 0x20) {
+                std::fprintf(stdout, "\\u%04x", byte);
+            } else {
+                std::fputc(c, stdout);
+            }
+        }
+
+        std::fputc('"', stdout);
+    }
+
+    Format format;
+    std::size_t fieldsWritten{};
+    std::string decoded;
+};
+
+bool equalsNoCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size()
+           && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+                  return std::toupper(x) == std::toupper(y);
+              });
+}
+
+int compareNoCase(std::string_view a, std::string_view b)
+{
+    const auto length = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < length; ++i) {
+        const int x = std::toupper(static_cast<unsigned char>(a[i]));
+        const int y = std::toupper(static_cast<unsigned char>(b[i]));
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+bool containsNoCase(std::string_view text, std::string_view value)
+{
+    if (value.size() > text.size()) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i + value.size() <= text.size(); ++i) {
+        if (equalsNoCase(text.substr(i, value.size()), value)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool compare(int result, Operator op)
+{
+    switch (op) {
+    case Operator::Equal:
+        return result == 0;
+    case Operator::NotEqual:
+        return result != 0;
+    case Operator::Less:
+        return result < 0;
+    case Operator::LessEqual:
+        return result <= 0;
+    case Operator::Greater:
+        return result > 0;
+    case Operator::GreaterEqual:
+        return result >= 0;
+    default:
+        return false;
+    }
+}
+
+bool parseOperator(Operator& op, const std::string& text)
+{
+    static const std::pair<const char*, Operator> operators[] = {
+        {"=", Operator::Equal},         {"==", Operator::Equal},
+        {"!=", Operator::NotEqual},     {"<", Operator::Less},
+        {"<=", Operator::LessEqual},    {">", Operator::Greater},
+        {">=", Operator::GreaterEqual}, {"~", Operator::Contains},
+    };
+
+    for (const auto& [name, value] : operators) {
+        if (text == name) {
+            op = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool matches(const DbfRecord& record, const Predicate& predicate)
+{
+    const auto& column = *predicate.column;
+
+    switch (column.type) {
+    case ColumnType::Character: {
+        std::string_view text;
+        record.value(text, column);
+        if (predicate.op == Operator::Contains) {
+            return containsNoCase(text, predicate.value);
+        }
+
+        return compare(compareNoCase(text, predicate.value), predicate.op);
+    }
+
+    case ColumnType::Number: {
+        int number{};
+        if (!record.value(number, column) || predicate.op == Operator::Contains) {
+            return false;
+        }
+
+        return compare(number < predicate.number ? -1 : (number > predicate.number ? 1 : 0),
+                       predicate.op);
+    }
+
+    case ColumnType::Logical: {
+        bool logical{};
+        record.value(logical, column);
+        const bool expected = predicate.number != 0;
+        return compare(logical == expected ? 0 : 1, predicate.op);
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool resolveColumns(std::vector<const DbfColumn*>& result,
+                    const DbfFile& dbf,
+                    const std::vector<std::string>& names)
+{
+    result.clear();
+
+    if (names.empty()) {
+        for (std::uint32_t i = 0; i < dbf.columnsTotal(); ++i) {
+            result.push_back(dbf.column(i));
+        }
+
+        return true;
+    }
+
+    for (const auto& name : names) {
+        const auto column = dbf.column(name);
+        if (!column) {
+            std::fprintf(stderr, "Unknown column '%s' in %s\n", name.c_str(),
+                         dbf.path().string().c_str());
+            return false;
+        }
+
+        result.push_back(column);
+    }
+
+    return true;
+}
+
+bool resolvePredicates(std::vector<Predicate>& result,
+                       const DbfFile& dbf,
+                       const std::vector<std::string>& where)
+{
+    result.clear();
+
+    for (std::size_t i = 0; i + 2 < where.size(); i += 3) {
+        Predicate predicate;
+        predicate.column = dbf.column(where[i]);
+        if (!predicate.column) {
+            std::fprintf(stderr, "Unknown column '%s'\n", where[i].c_str());
+            return false;
+        }
+
+        if (!parseOperator(predicate.op, where[i + 1])) {
+            std::fprintf(stderr, "Unknown operator '%s'\n", where[i + 1].c_str());
+            return false;
+        }
+
+        predicate.value = where[i + 2];
+        if (predicate.column->type == ColumnType::Number) {
+            predicate.number = std::atoi(predicate.value.c_str());
+        } else if (predicate.column->type == ColumnType::Logical) {
+            const auto c = std::toupper(static_cast<unsigned char>(predicate.value[0]));
+            predicate.number = c == 'T' || c == 'Y' || c == '1';
+        }
+
+        result.push_back(predicate);
+    }
+
+    return true;
+}
+
+bool matchesAll(const DbfRecord& record, const std::vector<Predicate>& predicates)
+{
+    return std::all_of(predicates.begin(), predicates.end(),
+                       [&record](const Predicate& predicate) {
+                           return matches(record, predicate);
+                       });
+}
+
+std::vector<std::string> splitNames(const std::string& text)
+{
+    std::vector<std::string> names;
+
+    std::size_t start{0};
+    while (start <= text.size()) {
+        const auto end = std::min(text.find(',', start), text.size());
+        if (end > start) {
+            names.push_back(text.substr(start, end - start));
+        }
+
+        start = end + 1;
+    }
+
+    return names;
+}
+
+bool openTable(DbfFile& dbf, const std::string& path)
+{
+    if (!dbf.open(path)) {
+        std::fprintf(stderr, "Could not open %s\n", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+int info(const Options& options)
+{
+    if (options.arguments.size() != 1) {
+        return -1;
+    }
+
+    DbfFile dbf;
+    if (!openTable(dbf, options.arguments[0])) {
+        return 1;
+    }
+
+    std::printf("Records: %u\nRecord length: %u\nCode page id: %u\nColumns: %u\n",
+                dbf.recordsTotal(), dbf.recordLength(), static_cast<unsigned>(dbf.language()),
+                dbf.columnsTotal());
+
+    for (std::uint32_t i = 0; i < dbf.columnsTotal(); ++i) {
+        const auto column = dbf.column(i);
+        std::printf("  %-10s %c %3u\n", column->name, static_cast<char>(column->type),
+                    column->length);
+    }
+
+    return 0;
+}
+
+int scan(const Options& options)
+{
+    if (options.arguments.size() != 1) {
+        return -1;
+    }
+
+    DbfFile dbf;
+    if (!openTable(dbf, options.arguments[0])) {
+        return 1;
+    }
+
+    std::vector<Predicate> predicates;
+    std::vector<const DbfColumn*> columns;
+    if (!resolvePredicates(predicates, dbf, options.where)
+        || !resolveColumns(columns, dbf, options.select)) {
+        return 1;
+    }
+
+    const TextDecoder decoder{dbf.language()};
+    const TextDecoder* textDecoder = options.utf8 ? &decoder : nullptr;
+
+    RecordWriter writer{options.format};
+    writer.header(columns);
+
+    const Throughput throughput{dbf.recordLength()};
+    std::uint64_t scanned{};
+    std::uint64_t matched{};
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    for (std::uint32_t i = 0; i < recordsTotal && matched < options.limit; ++i, ++scanned) {
+        DbfRecord record;
+        if (!dbf.record(record, i) || record.isDeleted() || !matchesAll(record, predicates)) {
+            continue;
+        }
+
+        ++matched;
+
+        writer.beginRecord();
+        for (const auto column : columns) {
+            writer.field(record, *column, textDecoder);
+        }
+
+        writer.endRecord();
+    }
+
+    std::fflush(stdout);
+    throughput.report("Scanned", scanned, "matched", matched);
+    return 0;
+}
+
+int join(const Options& options)
+{
+    if (options.arguments.size() != 4) {
+        return -1;
+    }
+
+    DbfFile left;
+    DbfFile right;
+    if (!openTable(left, options.arguments[0]) || !openTable(right, options.arguments[2])) {
+        return 1;
+    }
+
+    const auto leftKey = left.columnRef<std::string_view>(options.arguments[1]);
+    if (!leftKey.isValid()) {
+        std::fprintf(stderr, "Unknown character column '%s'\n", options.arguments[1].c_str());
+        return 1;
+    }
+
+    DbfIndex index;
+    if (!right.index(index, options.arguments[3])) {
+        std::fprintf(stderr, "Could not index column '%s'\n", options.arguments[3].c_str());
+        return 1;
+    }
+
+    std::vector<Predicate> predicates;
+    std::vector<const DbfColumn*> leftColumns;
+    std::vector<const DbfColumn*> rightColumns;
+    if (!resolvePredicates(predicates, left, options.where)
+        || !resolveColumns(leftColumns, left, options.select)
+        || !resolveColumns(rightColumns, right, options.joinSelect)) {
+        return 1;
+    }
+
+    std::vector<const DbfColumn*> columns{leftColumns};
+    columns.insert(columns.end(), rightColumns.begin(), rightColumns.end());
+
+    const TextDecoder leftDecoder{left.language()};
+    const TextDecoder rightDecoder{right.language()};
+    const TextDecoder* leftTextDecoder = options.utf8 ? &leftDecoder : nullptr;
+    const TextDecoder* rightTextDecoder = options.utf8 ? &rightDecoder : nullptr;
+
+    RecordWriter writer{options.format};
+    writer.header(columns);
+
+    const Throughput throughput{left.recordLength()};
+    std::uint64_t scanned{};
+    std::uint64_t matched{};
+
+    const auto recordsTotal{left.recordsTotal()};
+    for (std::uint32_t i = 0; i < recordsTotal && matched < options.limit; ++i, ++scanned) {
+        DbfRecord record;
+        if (!left.record(record, i) || record.isDeleted() || !matchesAll(record, predicates)) {
+            continue;
+        }
+
+        const auto row = index.find(leftKey.get(record));
+        DbfRecord joined;
+        if (!row || !right.record(joined, *row)) {
+            continue;
+        }
+
+        ++matched;
+
+        writer.beginRecord();
+        for (const auto column : leftColumns) {
+            writer.field(record, *column, leftTextDecoder);
+        }
+
+        for (const auto column : rightColumns) {
+            writer.field(joined, *column, rightTextDecoder);
+        }
+
+        writer.endRecord();
+    }
+
+    std::fflush(stdout);
+    throughput.report("Scanned", scanned, "matched", matched);
+    return 0;
+}
+
+bool fieldsEqual(const DbfRecord& a,
+                 const DbfColumn& aColumn,
+                 const DbfRecord& b,
+                 const DbfColumn& bColumn)
+{
+    if (aColumn.type != bColumn.type) {
+        return false;
+    }
+
+    switch (aColumn.type) {
+    case ColumnType::Character: {
+        std::string_view x;
+        std::string_view y;
+        a.value(x, aColumn);
+        b.value(y, bColumn);
+        return x == y;
+    }
+
+    case ColumnType::Number: {
+        int x{};
+        int y{};
+        const bool xParsed = a.value(x, aColumn);
+        const bool yParsed = b.value(y, bColumn);
+        return xParsed == yParsed && x == y;
+    }
+
+    case ColumnType::Logical: {
+        bool x{};
+        bool y{};
+        a.value(x, aColumn);
+        b.value(y, bColumn);
+        return x == y;
+    }
+
+    default:
+        return true;
+    }
+}
+
+int diff(const Options& options)
+{
+    if (options.arguments.size() != 3) {
+        return -1;
+    }
+
+    DbfFile before;
+    DbfFile after;
+    if (!openTable(before, options.arguments[0]) || !openTable(after, options.arguments[1])) {
+        return 1;
+    }
+
+    const auto& keyName = options.arguments[2];
+    const auto beforeKey = before.columnRef<std::string_view>(keyName);
+    const auto afterKey = after.columnRef<std::string_view>(keyName);
+
+    DbfIndex beforeIndex;
+    DbfIndex afterIndex;
+    if (!beforeKey.isValid() || !afterKey.isValid() || !before.index(beforeIndex, keyName)
+        || !after.index(afterIndex, keyName)) {
+        std::fprintf(stderr, "Could not index column '%s' in both tables\n", keyName.c_str());
+        return 1;
+    }
+
+    // Columns present in both tables, by name
+    std::vector<std::pair<const DbfColumn*, const DbfColumn*>> common;
+    for (std::uint32_t i = 0; i < before.columnsTotal(); ++i) {
+        const auto column = before.column(i);
+        const auto other = after.column(std::string(column->name));
+        if (other) {
+            common.emplace_back(column, other);
+        } else {
+            std::printf("- column %s\n", column->name);
+        }
+    }
+
+    for (std::uint32_t i = 0; i < after.columnsTotal(); ++i) {
+        const auto column = after.column(i);
+        if (!before.column(std::string(column->name))) {
+            std::printf("+ column %s\n", column->name);
+        }
+    }
+
+    std::uint64_t changes{};
+    std::uint64_t skipped{};
+    for (std::uint32_t i = 0; i < before.recordsTotal(); ++i) {
+        DbfRecord record;
+        if (!before.record(record, i) || record.isDeleted()) {
+            continue;
+        }
+
+        const auto id = beforeKey.get(record);
+        if (!DbfIndex::packId(id)) {
+            ++skipped;
+            continue;
+        }
+
+        if (!afterIndex.find(id)) {
+            std::printf("- %.*s\n", static_cast<int>(id.size()), id.data());
+            ++changes;
+        }
+    }
+
+    for (std::uint32_t i = 0; i < after.recordsTotal(); ++i) {
+        DbfRecord record;
+        if (!after.record(record, i) || record.isDeleted()) {
+            continue;
+        }
+
+        const auto id = afterKey.get(record);
+        if (!DbfIndex::packId(id)) {
+            ++skipped;
+            continue;
+        }
+
+        const auto row = beforeIndex.find(id);
+        DbfRecord old;
+        if (!row || !before.record(old, *row)) {
+            std::printf("+ %.*s\n", static_cast<int>(id.size()), id.data());
+            ++changes;
+            continue;
+        }
+
+        for (const auto& [beforeColumn, afterColumn] : common) {
+            if (!fieldsEqual(old, *beforeColumn, record, *afterColumn)) {
+                std::printf("~ %.*s %s\n", static_cast<int>(id.size()), id.data(),
+                            afterColumn->name);
+                ++changes;
+            }
+        }
+    }
+
+    if (skipped) {
+        std::fprintf(stderr, "Skipped %llu records without valid id\n",
+                     static_cast<unsigned long long>(skipped));
+    }
+
+    return changes ? 2 : 0;
+}
+
+/** Patches field of matching records in place, through writable mapping. */
+int update(const Options& options)
+{
+    if (options.arguments.size() != 3) {
+        return -1;
+    }
+
+    DbfFile dbf;
+    if (!dbf.open(options.arguments[0], true)) {
+        std::fprintf(stderr, "Could not open %s for writing\n", options.arguments[0].c_str());
+        return 1;
+    }
+
+    const auto column = dbf.column(options.arguments[1]);
+    if (!column) {
+        std::fprintf(stderr, "Unknown column '%s'\n", options.arguments[1].c_str());
+        return 1;
+    }
+
+    std::vector<Predicate> predicates;
+    if (!resolvePredicates(predicates, dbf, options.where)) {
+        return 1;
+    }
+
+    const auto& value = options.arguments[2];
+
+    const Throughput throughput{dbf.recordLength()};
+    std::uint64_t scanned{};
+    std::uint64_t updated{};
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    for (std::uint32_t i = 0; i < recordsTotal && updated < options.limit; ++i, ++scanned) {
+        DbfRecord record;
+        if (!dbf.record(record, i) || record.isDeleted() || !matchesAll(record, predicates)) {
+            continue;
+        }
+
+        if (!writeField(dbf.writableRecord(i), *column, value)) {
+            std::fprintf(stderr, "Value '%s' does not fit into column '%s'\n", value.c_str(),
+                         column->name);
+            return 1;
+        }
+
+        ++updated;
+    }
+
+    if (!dbf.flush()) {
+        std::fprintf(stderr, "Could not write changes to %s\n", options.arguments[0].c_str());
+        return 1;
+    }
+
+    throughput.report("Scanned", scanned, "updated", updated);
+    return 0;
+}
+
+bool parseColumnType(ColumnType& type, const std::string& text)
+{
+    if (text == "C" || text == "N" || text == "L") {
+        type = static_cast<ColumnType>(text[0]);
+        return true;
+    }
+
+    return false;
+}
+
+/** Copies table with new column appended, in a single sequential pass. */
+int addColumn(const Options& options)
+{
+    if (options.arguments.size() < 5 || options.arguments.size() > 6) {
+        return -1;
+    }
+
+    DbfColumnInfo info;
+    info.name = options.arguments[2];
+    const int length = std::atoi(options.arguments[4].c_str());
+    if (!parseColumnType(info.type, options.arguments[3]) || length <= 0 || length > 254) {
+        return -1;
+    }
+
+    info.length = static_cast<std::uint8_t>(length);
+
+    std::vector<std::string> defaults;
+    if (options.arguments.size() == 6) {
+        defaults.push_back(options.arguments[5]);
+    }
+
+    std::uint32_t recordLength{};
+    std::uint32_t recordsTotal{};
+    {
+        // Source is not kept open since it can be replaced by the copy
+        DbfFile source;
+        if (!openTable(source, options.arguments[0])) {
+            return 1;
+        }
+
+        recordLength = source.recordLength();
+        recordsTotal = source.recordsTotal();
+    }
+
+    const Throughput throughput{recordLength};
+    if (!addColumns(options.arguments[0], options.arguments[1], {info}, defaults)) {
+        std::fprintf(stderr, "Could not add column '%s'\n", info.name.c_str());
+        return 1;
+    }
+
+    throughput.report("Copied", recordsTotal, "added columns", 1);
+    return 0;
+}
+
+/** Writes synthetic table with unit-like records for benchmarking. */
+int generate(const Options& options)
+{
+    if (options.arguments.size() != 2) {
+        return -1;
+    }
+
+    const auto recordsTotal = std::strtoul(options.arguments[1].c_str(), nullptr, 10);
+
+    DbfWriter writer;
+    if (!writer.open(options.arguments[0], {{"UNIT_ID", ColumnType::Character, 10},
+                                            {"NAME_TXT", ColumnType::Character, 10},
+                                            {"LEVEL", ColumnType::Number, 3},
+                                            {"HIT_POINT", ColumnType::Number, 6},
+                                            {"SIZE_SMALL", ColumnType::Logical, 1},
+                                            {"DESCR", ColumnType::Character, 60}})) {
+        std::fprintf(stderr, "Could not create %s\n", options.arguments[0].c_str());
+        return 1;
+    }
+
+    const auto& columns = writer.columns();
+    static const char* words[] = {"goblin", "archer", "knight", "mage", "dragon", "wolf"};
+
+    const Throughput throughput{writer.recordLength()};
+
+    std::uint64_t random{0x9e3779b97f4a7c15ull};
+    char text[16];
+    for (unsigned long i = 0; i < recordsTotal; ++i) {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+
+        auto record = writer.newRecord();
+        std::snprintf(text, sizeof(text), "G%09lX", i);
+        writeField(record, columns[0], text);
+        std::snprintf(text, sizeof(text), "X%09lX", i % 1000000);
+        writeField(record, columns[1], text);
+        writeField(record, columns[2], static_cast<int>(random % 10 + 1));
+        writeField(record, columns[3], static_cast<int>(random % 3000 + 10));
+        writeField(record, columns[4], (random & 1) != 0);
+        writeField(record, columns[5], words[random % std::size(words)]);
+
+        if (!writer.writeRecord()) {
+            return 1;
+        }
+    }
+
+    if (!writer.close()) {
+        std::fprintf(stderr, "Could not write %s\n", options.arguments[0].c_str());
+        return 1;
+    }
+
+    throughput.report("Generated", recordsTotal, "written", recordsTotal);
+    return 0;
+}
+
+/** Writes table with fields that are hard to decode, deleted records are interleaved. */
+bool writeDecoderEdgeCases(const std::filesystem::path& path)
+{
+    DbfWriter writer;
+    if (!writer.open(path, {{"TEXT", ColumnType::Character, 8},
+                            {"NUMBER", ColumnType::Number, 12},
+                            {"SHORT", ColumnType::Number, 2},
+                            {"FLAG", ColumnType::Logical, 1}})) {
+        return false;
+    }
+
+    static const char* texts[] = {"", " ", "a", " a ", "a b", "  padded", "full8chr",
+                                  "\xc0\xe1 \xe2"};
+    static const char* numbers[] = {"", "-", "+", " -", "0", "-0", "42", "-42", "+42", "007",
+                                    "2147483647", "2147483648", "-2147483648", "-2147483649",
+                                    "99999999999", "1 2", "12a", "a12", " 7 ", "--1", "1.5"};
+    static const char* shorts[] = {"", "-", "-9", "99", " 1", "1 "};
+    static const char* flags[] = {"T", "F", "t", "f", "Y", "N", "?", " ", "1"};
+
+    const auto& columns = writer.columns();
+    const std::size_t recordsTotal{2 * std::size(numbers) * std::size(flags)};
+    for (std::size_t i = 0; i < recordsTotal; ++i) {
+        auto record = writer.newRecord(i / 7 % 2 != 0);
+        writeField(record, columns[0], texts[i % std::size(texts)]);
+        writeField(record, columns[1], numbers[i % std::size(numbers)]);
+        writeField(record, columns[2], shorts[i % std::size(shorts)]);
+        writeField(record, columns[3], flags[i % std::size(flags)]);
+
+        if (!writer.writeRecord()) {
+            return false;
+        }
+    }
+
+    return writer.close();
+}
+
+/** Compares batch column decoders with per-record access of every field. */
+class DecodersCheck
+{
+public:
+    void check(const DbfFile& dbf, const std::string& table)
+    {
+        for (std::uint32_t i = 0; i < dbf.columnsTotal(); ++i) {
+            const auto& column{*dbf.column(i)};
+
+            switch (column.type) {
+            case ColumnType::Character:
+                checkCharacters(dbf, table, column);
+                break;
+
+            case ColumnType::Number:
+                checkNumbers(dbf, table, column);
+                break;
+
+            case ColumnType::Logical:
+                checkLogicals(dbf, table, column);
+                break;
+            }
+        }
+    }
+
+    std::uint64_t fieldsChecked() const
+    {
+        return fields;
+    }
+
+    std::uint64_t mismatchesFound() const
+    {
+        return mismatches;
+    }
+
+private:
+    void report(const std::string& table,
+                const DbfColumn& column,
+                std::uint32_t index,
+                const std::string& decoded,
+                const std::string& expected)
+    {
+        // Large tables with broken decoder would flood the output otherwise
+        if (mismatches++ < 20) {
+            std::printf("%s %s record %u: decoded '%s', per-record '%s'\n", table.c_str(),
+                        column.name, index, decoded.c_str(), expected.c_str());
+        }
+    }
+
+    void checkCharacters(const DbfFile& dbf, const std::string& table, const DbfColumn& column)
+    {
+        std::vector<std::string_view> values;
+        if (!decodeColumn(values, dbf, column)) {
+            report(table, column, 0, "decoding failed", "");
+            return;
+        }
+
+        DbfRecord record;
+        for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i, ++fields) {
+            std::string_view expected;
+            if (!dbf.record(record, i) || !record.value(expected, column)
+                || expected != values[i]) {
+                report(table, column, i, std::string(values[i]), std::string(expected));
+            }
+        }
+    }
+
+    void checkNumbers(const DbfFile& dbf, const std::string& table, const DbfColumn& column)
+    {
+        std::vector<int> values;
+        std::vector<bool> parsed;
+        if (!decodeColumn(values, parsed, dbf, column)) {
+            report(table, column, 0, "decoding failed", "");
+            return;
+        }
+
+        DbfRecord record;
+        for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i, ++fields) {
+            int expected{};
+            const bool expectedParsed{dbf.record(record, i) && record.value(expected, column)};
+            if (expectedParsed != parsed[i] || (expectedParsed && expected != values[i])) {
+                report(table, column, i, parsed[i] ? std::to_string(values[i]) : "none",
+                       expectedParsed ? std::to_string(expected) : "none");
+            }
+        }
+    }
+
+    void checkLogicals(const DbfFile& dbf, const std::string& table, const DbfColumn& column)
+    {
+        std::vector<bool> values;
+        if (!decodeColumn(values, dbf, column)) {
+            report(table, column, 0, "decoding failed", "");
+            return;
+        }
+
+        DbfRecord record;
+        for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i, ++fields) {
+            bool expected{};
+            if (!dbf.record(record, i) || !record.value(expected, column)
+                || expected != values[i]) {
+                report(table, column, i, values[i] ? "T" : "F", expected ? "T" : "F");
+            }
+        }
+    }
+
+    std::uint64_t fields{};
+    std::uint64_t mismatches{};
+};
+
+/**
+ * Checks batch column decoders against per-record access
+ * on generated table with edge cases and on specified tables.
+ */
+int checkDecoders(const Options& options)
+{
+    const auto edgeCasesPath{std::filesystem::temp_directory_path() / "dbftoolDecoders.dbf"};
+    if (!writeDecoderEdgeCases(edgeCasesPath)) {
+        std::fprintf(stderr, "Could not create %s\n", edgeCasesPath.string().c_str());
+        return 1;
+    }
+
+    DecodersCheck check;
+    {
+        DbfFile dbf;
+        if (!openTable(dbf, edgeCasesPath.string())) {
+            return 1;
+        }
+
+        check.check(dbf, "edge cases");
+    }
+
+    std::error_code error;
+    std::filesystem::remove(edgeCasesPath, error);
+
+    for (const auto& path : options.arguments) {
+        DbfFile dbf;
+        if (!openTable(dbf, path)) {
+            return 1;
+        }
+
+        check.check(dbf, path);
+    }
+
+    std::printf("Checked %llu fields of %zu tables, %llu mismatches\n",
+                static_cast<unsigned long long>(check.fieldsChecked()),
+                options.arguments.size() + 1,
+                static_cast<unsigned long long>(check.mismatchesFound()));
+    return check.mismatchesFound() ? 1 : 0;
+}
+
+void printUsage()
+{
+    std::fputs(
+        "Usage:\n"
+        "  dbftool info <table.dbf>\n"
+        "  dbftool scan <table.dbf> [options]\n"
+        "  dbftool join <left.dbf> <column> <right.dbf> <id column> [options]\n"
+        "  dbftool diff <old.dbf> <new.dbf> <id column>\n"
+        "  dbftool update <table.dbf> <column> <value> [-w ...] [-l <count>]\n"
+        "  dbftool add-column <source.dbf> <destination.dbf> <name> C|N|L <length> [default]\n"
+        "  dbftool generate <table.dbf> <records>\n"
+        "  dbftool check-decoders [table.dbf ...]\n"
+        "Options:\n"
+        "  -w <column> <op> <value>  filter records, op is one of = != < <= > >= ~\n"
+        "  -s <column,...>           columns to output, all by default\n"
+        "  -j <column,...>           columns of joined table to output, all by default\n"
+        "  -f csv|json|none          output format, csv by default\n"
+        "  -l <count>                stop after specified number of matches\n"
+        "  -e utf8|raw               text encoding of output, utf8 by default\n"
+        "Throughput is reported to stderr for all commands except info and diff.\n",
+        stderr);
+}
+
+bool parseOptions(Options& options, int argc, char* argv[])
+{
+    for (int i = 2; i < argc; ++i) {
+        const std::string argument{argv[i]};
+
+        if (argument == "-w" && i + 3 < argc) {
+            options.where.insert(options.where.end(), {argv[i + 1], argv[i + 2], argv[i + 3]});
+            i += 3;
+        } else if (argument == "-s" && i + 1 < argc) {
+            options.select = splitNames(argv[++i]);
+        } else if (argument == "-j" && i + 1 < argc) {
+            options.joinSelect = splitNames(argv[++i]);
+        } else if (argument == "-f" && i + 1 < argc) {
+            const std::string format{argv[++i]};
+            if (format == "csv") {
+                options.format = Format::Csv;
+            } else if (format == "json") {
+                options.format = Format::Json;
+            } else if (format == "none") {
+                options.format = Format::None;
+            } else {
+                return false;
+            }
+        } else if (argument == "-e" && i + 1 < argc) {
+            const std::string encoding{argv[++i]};
+            if (encoding == "utf8") {
+                options.utf8 = true;
+            } else if (encoding == "raw") {
+                options.utf8 = false;
+            } else {
+                return false;
+            }
+        } else if (argument == "-l" && i + 1 < argc) {
+            options.limit = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argument.size() > 1 && argument[0] == '-'
+                   && !std::isdigit(static_cast<unsigned char>(argument[1]))) {
+            return false;
+        } else {
+            options.arguments.push_back(argument);
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (argc < 2 || !parseOptions(options, argc, argv)) {
+        printUsage();
+        return -1;
+    }
+
+    const std::string command{argv[1]};
+
+    int result{-1};
+    if (command == "info") {
+        result = info(options);
+    } else if (command == "scan") {
+        result = scan(options);
+    } else if (command == "join") {
+        result = join(options);
+    } else if (command == "diff") {
+        result = diff(options);
+    } else if (command == "update") {
+        result = update(options);
+    } else if (command == "add-column") {
+        result = addColumn(options);
+    } else if (command == "generate") {
+        result = generate(options);
+    } else if (command == "check-decoders") {
+        result = checkDecoders(options);
+    }
+
+    if (result == -1) {
+        printUsage();
+    }
+
+    return result;
+}
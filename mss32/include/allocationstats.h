@@ -0,0 +1,100 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOCATIONSTATS_H
+#define ALLOCATIONSTATS_H
+
+#include "mempool.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace hooks {
+
+/** Subsystems whose allocations are accounted separately. */
+enum class AllocationTag : std::uint8_t
+{
+    ModifiedUnits,   /**< Patched ModifiedUnitInfo arrays of BattleMsgData. */
+    CustomAttacks,   /**< Custom attack objects and attack implementation data. */
+    EventConditions, /**< Custom event conditions, their editor interfaces and tests. */
+    Images,          /**< Movement path images. */
+    MessageBoxes,    /**< Message boxes and their button handlers. */
+    Buildings,       /**< Building types and branches. */
+    Lua,             /**< Memory of Lua states, objects are allocated blocks. */
+    Scripts,         /**< Cached script chunks. */
+    Count
+};
+
+/** Snapshot of allocation counters of a single subsystem. */
+struct AllocationStats
+{
+    const char* name;
+    /** Bytes and objects alive, meaningful only if frees are visible to the proxy. */
+    std::int64_t bytes;
+    std::int64_t objects;
+    std::int64_t peakBytes;
+    std::int64_t allocations;
+    std::int64_t frees;
+    /** Allocations and allocated bytes since current turn started. */
+    std::int64_t turnAllocations;
+    std::int64_t turnBytes;
+    /** False for memory that is freed by the game. */
+    bool freesTracked;
+};
+
+void trackAllocation(AllocationTag tag, std::size_t bytes);
+void trackFree(AllocationTag tag, std::size_t bytes);
+
+/** Allocates memory for T with game allocator and accounts it under specified tag. */
+template <typename T>
+T* allocateTracked(AllocationTag tag)
+{
+    trackAllocation(tag, sizeof(T));
+    return static_cast<T*>(game::Memory::get().allocate(sizeof(T)));
+}
+
+/** Frees memory allocated with allocateTracked, pointer can be null. */
+template <typename T>
+void freeTracked(AllocationTag tag, T* ptr)
+{
+    if (ptr) {
+        trackFree(tag, sizeof(T));
+        game::Memory::get().freeNonZero(ptr);
+    }
+}
+
+/** Lua allocator function that accounts memory of the state under AllocationTag::Lua. */
+void* trackedLuaAlloc(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+
+/** Returns counters of all subsystems. */
+std::vector<AllocationStats> allocationStats();
+
+/** Writes churn of the finished turn to the debug log and resets per turn counters. */
+void finishAllocationTurn(int turn);
+
+/** Writes counters of all subsystems to the specified log file in debug mode. */
+void logAllocationStats(std::string_view logFile);
+
+/** Reports objects that remained alive to the error log, called on exit. */
+void reportAllocationLeaks();
+
+} // namespace hooks
+
+#endif // ALLOCATIONSTATS_H
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATTLECAPTURE_H
+#define BATTLECAPTURE_H
+
+#include "battlecaptureformat.h"
+#include "customattackutils.h"
+#include <string>
+
+namespace game {
+struct BattleMsgData;
+struct LAttackReach;
+enum class BattleAction : int;
+} // namespace game
+
+namespace hooks {
+
+/** Set once by startBattleCapture(), checked by capture points. */
+extern bool battleCapturing;
+
+/**
+ * Enables capture of battle actions.
+ * Each action is appended to 'battleCapture.bin' when its targets are chosen,
+ * see battlecaptureformat.h for the file layout.
+ */
+void startBattleCapture();
+
+/**
+ * Collects battle action of the calling thread and writes it to the capture file on finish.
+ * Does nothing if battle capture is disabled.
+ */
+class BattleCaptureScope
+{
+public:
+    BattleCaptureScope(const game::BattleMsgData* battleMsgData,
+                       game::BattleAction action,
+                       const game::LAttackReach* attackReach,
+                       const game::CMidgardID* targetUnitId);
+    ~BattleCaptureScope();
+
+    BattleCaptureScope(const BattleCaptureScope&) = delete;
+    BattleCaptureScope& operator=(const BattleCaptureScope&) = delete;
+
+    /** Writes action with its final targets. */
+    void finish(const game::IAttack* attack, const game::IdList* targets);
+
+private:
+    bool active;
+};
+
+/** Adds targeting script call to the action being captured by the calling thread. */
+void captureTargeting(const std::string& scriptFile,
+                      const bindings::UnitSlotView& attacker,
+                      const bindings::UnitSlotView& selected,
+                      const UnitSlots& allies,
+                      const UnitSlots& targets,
+                      bool targetsAreAllies,
+                      const bindings::BattleSnapshotView& battle,
+                      const UnitSlots& result);
+
+} // namespace hooks
+
+#endif // BATTLECAPTURE_H
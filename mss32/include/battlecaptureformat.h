@@ -0,0 +1,125 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATTLECAPTUREFORMAT_H
+#define BATTLECAPTUREFORMAT_H
+
+#include <cstdint>
+
+namespace hooks {
+
+/**
+ * Layout of battle capture files written by the proxy:
+ * BattleCaptureHeader, then BattleCaptureRecord for each captured battle action.
+ * Each record is followed by:
+ * - BattleMsgData and patched ModifiedUnitInfo arrays of all its units, the same bytes
+ *   serializeMsgWithBattleMsgData streams;
+ * - BattleCaptureTargeting, slot indices of allies, targets and script result,
+ *   script name as 32-bit length followed by characters, if record has Targeting flag;
+ * - 32-bit ids of the final targets;
+ * - damage ratios of the final targets as doubles.
+ * Slot indices are 1-based indices in BattleCaptureTargeting::units, 0 means no slot.
+ */
+static const char battleCaptureMagic[4] = {'D', '2', 'B', 'C'};
+static const std::uint32_t battleCaptureVersion = 1;
+static const std::uint32_t battleCaptureSlotsTotal = 12;
+
+enum class BattleCaptureFlag : std::uint8_t
+{
+    Targeting = 1,        /**< Targets were chosen by custom attack reach script. */
+    TargetsAreAllies = 2, /**< Script targeted allies of the attacker. */
+    DamageRatio = 4,      /**< Damage ratio fields are set. */
+};
+
+struct BattleCaptureHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t battleMsgDataSize;
+    std::uint32_t unitsInfoTotal;     /**< Number of patched arrays following BattleMsgData. */
+    std::uint32_t modifiedUnitsTotal; /**< Elements in each patched array. */
+    std::uint32_t modifiedUnitSize;
+    /** Distances between slots, see BattleSnapshotView::getDistanceTable. */
+    std::int32_t distances[battleCaptureSlotsTotal][battleCaptureSlotsTotal];
+};
+
+static_assert(sizeof(BattleCaptureHeader) == 600,
+              "Size of BattleCaptureHeader structure must be exactly 600 bytes");
+
+struct BattleCaptureRecord
+{
+    std::uint32_t size;         /**< Bytes following the record structure. */
+    std::int32_t action;        /**< BattleAction chosen by the player or AI. */
+    std::int32_t round;         /**< Battle round, starts from 1. */
+    std::int32_t attackReach;   /**< Id of LAttackReach category. */
+    std::uint32_t targetUnitId; /**< Unit chosen as target of the action. */
+    std::uint32_t targetsTotal; /**< Number of the final targets. */
+    std::uint32_t ratiosTotal;  /**< Number of damage ratios, 0 if damage is not changed. */
+    std::uint8_t flags;         /**< Combination of BattleCaptureFlag values. */
+    std::uint8_t damageRatio;   /**< DAM_RATIO of the attack. */
+    std::uint8_t damageRatioPerTarget;
+    std::uint8_t damageSplit;
+};
+
+static_assert(sizeof(BattleCaptureRecord) == 32,
+              "Size of BattleCaptureRecord structure must be exactly 32 bytes");
+
+/** State of the unit in battle slot, fields are zero for empty slots. */
+struct BattleCaptureUnit
+{
+    std::uint32_t unitId; /**< 0 if slot is empty or unit is not visible to the script. */
+    std::int32_t hp;
+    std::int32_t hpMax;
+    std::int32_t xp;
+    std::int32_t level;
+    std::int32_t xpNext;
+    std::int32_t xpKilled;
+    std::int32_t armor;
+    std::int32_t regen;
+    std::int32_t race;
+    std::int32_t subrace;
+    std::uint8_t small;
+    std::uint8_t male;
+    std::uint8_t waterOnly;
+    std::uint8_t attacksTwice;
+    std::uint64_t statuses; /**< Bitmask of BattleStatus values. */
+};
+
+static_assert(sizeof(BattleCaptureUnit) == 56,
+              "Size of BattleCaptureUnit structure must be exactly 56 bytes");
+
+/** Arguments and result of the targeting script call. */
+struct BattleCaptureTargeting
+{
+    /** Slots 1-6 are positions of the attacker's group, 7-12 of the opposing group. */
+    BattleCaptureUnit units[battleCaptureSlotsTotal];
+    std::uint8_t attacker;
+    std::uint8_t selected;
+    std::uint8_t alliesTotal;
+    std::uint8_t targetsTotal;
+    std::uint8_t resultTotal;
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(BattleCaptureTargeting) == 680,
+              "Size of BattleCaptureTargeting structure must be exactly 680 bytes");
+
+} // namespace hooks
+
+#endif // BATTLECAPTUREFORMAT_H
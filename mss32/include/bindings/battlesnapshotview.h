@@ -0,0 +1,95 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATTLESNAPSHOTVIEW_H
+#define BATTLESNAPSHOTVIEW_H
+
+#include "midgardid.h"
+#include <array>
+#include <cstdint>
+
+namespace sol {
+class state;
+}
+
+namespace game {
+struct IMidgardObjectMap;
+struct BattleMsgData;
+} // namespace game
+
+namespace bindings {
+
+class UnitSlotView;
+
+/**
+ * Packed state of both battle groups, collected once per targeting script call.
+ * Slots 1-6 are positions 0-5 of the attacker's group, slots 7-12 of the opposing group.
+ */
+class BattleSnapshotView
+{
+public:
+    static constexpr std::size_t groupSize{6};
+    static constexpr std::size_t slotsTotal{groupSize * 2};
+
+    template <typename T>
+    using SlotArray = std::array<T, slotsTotal>;
+    using DistanceTable = std::array<SlotArray<int>, slotsTotal>;
+
+    BattleSnapshotView(const game::IMidgardObjectMap* objectMap,
+                       const game::BattleMsgData* battleMsgData,
+                       const game::CMidgardID* unitGroupId);
+
+    static void bind(sol::state& lua);
+
+    const SlotArray<int>& getHp() const;
+    const SlotArray<int>& getHpMax() const;
+    const SlotArray<int>& getLevel() const;
+    const SlotArray<std::int64_t>& getStatuses() const;
+    const SlotArray<bool>& getSmall() const;
+    const SlotArray<int>& getRace() const;
+    /** Returns 1-based slot index of specified unit slot or 0 if slot is not in battle. */
+    int getSlotIndex(const UnitSlotView& slot) const;
+    /** Returns distance between 1-based slot indices or 0 if indices are out of range. */
+    int getDistance(int fromSlot, int toSlot) const;
+    bool hasStatus(int slot, int status) const;
+
+    /**
+     * Returns distances between all slot pairs.
+     * Table does not depend on battle state and is computed once per game session.
+     */
+    static const DistanceTable& getDistanceTable();
+
+private:
+    void readGroup(const game::IMidgardObjectMap* objectMap,
+                   const game::BattleMsgData* battleMsgData,
+                   const game::CMidgardID* groupId,
+                   std::size_t firstSlot);
+
+    game::CMidgardID groupIds[2];
+    SlotArray<int> hp{};
+    SlotArray<int> hpMax{};
+    SlotArray<int> level{};
+    SlotArray<std::int64_t> statuses{};
+    SlotArray<bool> small{};
+    SlotArray<int> race{};
+};
+
+} // namespace bindings
+
+#endif // BATTLESNAPSHOTVIEW_H
@@ -0,0 +1,59 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FORTVIEW_H
+#define FORTVIEW_H
+
+#include "idview.h"
+#include "point.h"
+
+namespace sol {
+class state;
+}
+
+namespace game {
+struct CFortification;
+}
+
+namespace bindings {
+
+/** Lightweight view of a capital or village returned from scenario queries. */
+class FortView
+{
+public:
+    FortView(const game::CFortification* fort);
+
+    static void bind(sol::state& lua);
+
+    IdView getId() const;
+    Point getPosition() const;
+    IdView getOwnerId() const;
+    /** Returns fortification category. See FortCategory enumeration for all possible values. */
+    int getCategory() const;
+    /** Returns village tier level, capitals have zero tier. */
+    int getTier() const;
+    bool isCapital() const;
+
+private:
+    const game::CFortification* fort;
+};
+
+} // namespace bindings
+
+#endif // FORTVIEW_H
@@ -20,8 +20,10 @@
 #ifndef SCENARIOVIEW_H
 #define SCENARIOVIEW_H
 
+#include "midgardid.h"
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace sol {
 class state;
@@ -39,6 +41,30 @@ struct Point;
 class LocationView;
 class ScenVariablesView;
 class TileView;
+class FortView;
+class StackView;
+
+/**
+ * Predicates for scenario object queries.
+ * Filter is evaluated on native side, so scripts pay for a single call per query.
+ */
+struct ObjectFilter
+{
+    std::optional<game::CMidgardID> ownerId;
+    std::optional<int> race;
+    std::optional<int> category;
+    std::optional<int> minTier;
+    std::optional<int> maxTier;
+
+    struct Area
+    {
+        int x1;
+        int y1;
+        int x2;
+        int y2;
+    };
+    std::optional<Area> area;
+};
 
 class ScenarioView
 {
@@ -59,6 +85,11 @@ public:
     /** Returns tile by specified point. */
     std::optional<TileView> getTileByPoint(const Point& p) const;
 
+    /** Returns capitals and villages that pass specified filter. */
+    std::vector<FortView> findFortifications(const ObjectFilter& filter) const;
+    /** Returns stacks that pass specified filter. */
+    std::vector<StackView> findStacks(const ObjectFilter& filter) const;
+
     int getCurrentDay() const;
     int getSize() const;
 
@@ -22,7 +22,6 @@
 
 #include <optional>
 #include <string>
-#include <unordered_map>
 
 namespace sol {
 class state;
@@ -30,7 +29,6 @@ class state;
 
 namespace game {
 struct CMidScenVariables;
-struct ScenarioVariable;
 } // namespace game
 
 namespace bindings {
@@ -47,7 +45,6 @@ public:
     std::optional<ScenarioVariableView> getScenarioVariable(const std::string& name) const;
 
 private:
-    std::unordered_map<std::string, const game::ScenarioVariable*> variables;
     const game::CMidScenVariables* scenVariables;
 };
 
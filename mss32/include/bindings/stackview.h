@@ -0,0 +1,57 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STACKVIEW_H
+#define STACKVIEW_H
+
+#include "idview.h"
+#include "point.h"
+
+namespace sol {
+class state;
+}
+
+namespace game {
+struct CMidStack;
+}
+
+namespace bindings {
+
+/** Lightweight view of a stack returned from scenario queries. */
+class StackView
+{
+public:
+    StackView(const game::CMidStack* stack);
+
+    static void bind(sol::state& lua);
+
+    IdView getId() const;
+    Point getPosition() const;
+    IdView getOwnerId() const;
+    IdView getLeaderId() const;
+    /** Returns id of fortification or ruin the stack is currently inside. */
+    IdView getInsideId() const;
+
+private:
+    const game::CMidStack* stack;
+};
+
+} // namespace bindings
+
+#endif // STACKVIEW_H
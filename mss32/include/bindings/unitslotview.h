@@ -52,6 +52,7 @@ public:
     int getDistance(const UnitSlotView& to) const;
 
     game::CMidgardID getUnitId() const;
+    game::CMidgardID getGroupId() const;
     const game::CMidUnit* getUnit() const;
 
 private:
@@ -20,6 +20,7 @@
 #ifndef CUSTOMATTACKUTILS_H
 #define CUSTOMATTACKUTILS_H
 
+#include "damageratio.h"
 #include "idlist.h"
 #include "targetslist.h"
 #include <filesystem>
@@ -34,6 +35,7 @@ struct IBatAttack;
 
 namespace bindings {
 class UnitSlotView;
+class BattleSnapshotView;
 } // namespace bindings
 
 namespace hooks {
@@ -51,7 +53,8 @@ UnitSlots getTargetsToSelectOrAttack(const std::string& scriptFile,
                                      const bindings::UnitSlotView& selected,
                                      const UnitSlots& allies,
                                      const UnitSlots& targets,
-                                     bool targetsAreAllies);
+                                     bool targetsAreAllies,
+                                     const bindings::BattleSnapshotView& battle);
 
 UnitSlots getTargets(const game::IMidgardObjectMap* objectMap,
                      const game::BattleMsgData* battleMsgData,
@@ -126,8 +129,6 @@ void initializeAttackDamageRatio();
 
 void fillCustomDamageRatios(const game::IAttack* attack, const game::IdList* targets);
 
-int applyAttackDamageRatio(int damage, double ratio);
-
 std::vector<double> computeAttackDamageRatio(const game::IAttack* attack, int targetCount);
 
 double computeTotalDamageRatio(const game::IAttack* attack, int targetCount);
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAMAGERATIO_H
+#define DAMAGERATIO_H
+
+#include <cstdint>
+#include <vector>
+
+namespace hooks {
+
+/** Damage ratio of attack, see DAM_RATIO, DR_REPEAT and DAM_SPLIT columns of Gattacks.dbf. */
+struct DamageRatio
+{
+    /** Damage of additional targets in percents, 0-255. */
+    std::uint8_t ratio;
+    /** Ratio is applied repeatedly to each next target. */
+    bool perTarget;
+    /** Total damage is split between targets. */
+    bool split;
+};
+
+int applyAttackDamageRatio(int damage, double ratio);
+
+/** Returns ratio for each target or empty vector if damage is not changed. */
+std::vector<double> computeDamageRatios(const DamageRatio& damageRatio, int targetCount);
+
+/** Returns sum of ratios of all targets. */
+double computeTotalDamageRatio(const DamageRatio& damageRatio, int targetCount);
+
+} // namespace hooks
+
+#endif // DAMAGERATIO_H
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASERELOAD_H
+#define DATABASERELOAD_H
+
+#include <filesystem>
+
+namespace hooks {
+
+/** Databases whose changes can be partially applied without game restart. */
+enum class ReloadableDatabase
+{
+    AttackSources, /**< LAttS.dbf */
+    AttackReaches, /**< LAttR.dbf */
+    Races,         /**< Grace.dbf */
+};
+
+/**
+ * Remembers current contents of database, so its later changes can be detected.
+ * Does nothing unless 'reloadDatabases' setting is enabled.
+ */
+void watchDatabase(ReloadableDatabase database, const std::filesystem::path& dbfPath);
+
+/**
+ * Checks watched databases for changes and applies safe ones:
+ * targeting scripts and maximum targets of custom attack reaches,
+ * AI immunity ratings of custom attack sources and units for hire in cities.
+ * Other changes are logged, game restart is required to apply them.
+ * Databases are not reloaded in online multiplayer games, only in single player and hotseat.
+ * Files are checked at most once per second, should be called when custom attack tables
+ * and hire lists are not in use.
+ */
+void reloadChangedDatabases();
+
+} // namespace hooks
+
+#endif // DATABASERELOAD_H
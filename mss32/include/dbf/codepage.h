@@ -0,0 +1,67 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CODEPAGE_H
+#define CODEPAGE_H
+
+#include "dbfheader.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/** Returns true if text in specified code page can be decoded to UTF-8. */
+bool isCodePageSupported(CodePage codePage);
+
+/**
+ * Returns code page to decode text with.
+ * Many game databases do not declare code page, system ANSI code page is used for them.
+ */
+CodePage textCodePage(CodePage declared);
+
+/**
+ * Table driven decoder of single byte code pages 437, 850, 866, 1251 and 1252 to UTF-8.
+ * ASCII characters are copied as is, others are replaced with precomputed UTF-8 sequences.
+ */
+class TextDecoder
+{
+public:
+    struct Utf8Char
+    {
+        char bytes[3];
+        std::uint8_t length;
+    };
+
+    using Utf8Table = std::array<Utf8Char, 128>;
+
+    /** Unsupported code pages are replaced according to textCodePage(). */
+    explicit TextDecoder(CodePage codePage);
+
+    void append(std::string& result, std::string_view text) const;
+    std::string toUtf8(std::string_view text) const;
+
+private:
+    const Utf8Table* table;
+};
+
+} // namespace utils
+
+#endif // CODEPAGE_H
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFCATALOG_H
+#define DBFCATALOG_H
+
+#include "dbftable.h"
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+/**
+ * Process-wide storage of DBF tables that opens each file at most once
+ * and shares parsed table between all consumers.
+ * Tables can be prefetched on worker threads, consumer that requests a table
+ * waits only for that table or loads it itself if no worker has started it yet.
+ */
+class DbfCatalog
+{
+public:
+    using TablePtr = std::shared_ptr<const DbfTable>;
+
+    explicit DbfCatalog(const std::filesystem::path& cacheFolder);
+
+    DbfCatalog(const DbfCatalog&) = delete;
+    DbfCatalog& operator=(const DbfCatalog&) = delete;
+
+    /**
+     * Starts loading of specified tables on detached worker threads.
+     * Workers created from DllMain start only after it returns,
+     * until then requested tables are loaded by the calling thread.
+     */
+    void prefetch(const std::vector<std::filesystem::path>& dbfPaths, std::uint32_t threadsTotal);
+
+    /** Returns shared table or nullptr if it could not be opened. */
+    TablePtr table(const std::filesystem::path& dbfPath);
+
+    /**
+     * Drops loaded table, so the next request reads the file again.
+     * Tables already returned to consumers stay valid.
+     */
+    void refresh(const std::filesystem::path& dbfPath);
+
+private:
+    enum class State
+    {
+        Pending,
+        Loading,
+        Loaded,
+    };
+
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::mutex mutex;
+        std::condition_variable loaded;
+        State state{State::Pending};
+        TablePtr table;
+    };
+
+    Entry& entry(const std::filesystem::path& dbfPath);
+    /**
+     * Loads table if entry is still pending.
+     * Returns false if table is being loaded by another thread.
+     */
+    bool tryLoad(Entry& entry, bool worker);
+
+    std::filesystem::path cacheFolder;
+    std::mutex entriesMutex;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+};
+
+} // namespace utils
+
+#endif // DBFCATALOG_H
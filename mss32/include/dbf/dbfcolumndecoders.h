@@ -0,0 +1,59 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFCOLUMNDECODERS_H
+#define DBFCOLUMNDECODERS_H
+
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+class DbfFile;
+struct DbfColumn;
+
+/*
+ * Batch decoders read single column of all records in one pass over records buffer.
+ * Results match DbfRecord::value() of each record, deleted records are decoded as well.
+ * Decoders fail if column type does not match value type.
+ */
+
+/**
+ * Decodes character column, leading and trailing spaces are trimmed.
+ * Views point to DbfFile memory and must not outlive it.
+ */
+bool decodeColumn(std::vector<std::string_view>& values,
+                  const DbfFile& dbf,
+                  const DbfColumn& column);
+
+/**
+ * Decodes numeric column.
+ * Values that could not be parsed are set to 0 with corresponding flag in parsed cleared.
+ */
+bool decodeColumn(std::vector<int>& values,
+                  std::vector<bool>& parsed,
+                  const DbfFile& dbf,
+                  const DbfColumn& column);
+
+/** Decodes logical column. */
+bool decodeColumn(std::vector<bool>& values, const DbfFile& dbf, const DbfColumn& column);
+
+} // namespace utils
+
+#endif // DBFCOLUMNDECODERS_H
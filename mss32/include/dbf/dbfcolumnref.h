@@ -0,0 +1,87 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFCOLUMNREF_H
+#define DBFCOLUMNREF_H
+
+#include "dbfcolumn.h"
+#include "dbfrecord.h"
+#include <string_view>
+#include <type_traits>
+
+namespace utils {
+
+/**
+ * Typed handle to a column resolved once by name.
+ * Values are read straight from record memory without allocations,
+ * character fields are returned as views with leading and trailing spaces trimmed.
+ * Handle must not outlive DbfFile object that created it.
+ * @tparam T one of std::string_view, int or bool.
+ */
+template <typename T>
+class DbfColumnRef
+{
+    static_assert(std::is_same_v<T, std::string_view> || std::is_same_v<T, int>
+                      || std::is_same_v<T, bool>,
+                  "DbfColumnRef supports only std::string_view, int and bool values");
+
+public:
+    DbfColumnRef() = default;
+
+    /** Creates handle to specified column, handle is invalid if column type does not match T. */
+    explicit DbfColumnRef(const DbfColumn* dbfColumn)
+        : column{dbfColumn && dbfColumn->type == columnType() ? dbfColumn : nullptr}
+    { }
+
+    bool isValid() const
+    {
+        return column != nullptr;
+    }
+
+    /** @returns false if handle is invalid or value can not be read. */
+    bool read(T& result, const DbfRecord& record) const
+    {
+        return column && record.value(result, *column);
+    }
+
+    /** Returns column value or default one if handle is invalid or value can not be read. */
+    T get(const DbfRecord& record, T def = T{}) const
+    {
+        T result{};
+        return read(result, record) ? result : def;
+    }
+
+private:
+    static constexpr ColumnType columnType()
+    {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return ColumnType::Character;
+        } else if constexpr (std::is_same_v<T, int>) {
+            return ColumnType::Number;
+        } else {
+            return ColumnType::Logical;
+        }
+    }
+
+    const DbfColumn* column{};
+};
+
+} // namespace utils
+
+#endif // DBFCOLUMNREF_H
@@ -21,37 +21,76 @@
 #define DBFFILE_H
 
 #include "dbfcolumn.h"
+#include "dbfcolumnref.h"
 #include "dbfheader.h"
 #include "dbfrecord.h"
+#include "mappedfile.h"
 #include <filesystem>
-#include <fstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace utils {
 
+class DbfIndex;
+
 class DbfFile
 {
 public:
     DbfFile() = default;
 
-    bool open(const std::filesystem::path& file);
+    /**
+     * Opens DBF file.
+     * Writable files are mapped for in-place patching of record fields,
+     * file size and layout can not be changed this way.
+     */
+    bool open(const std::filesystem::path& file, bool writable = false);
+    /** Opens DBF file from its contents that are already mapped or read. */
+    bool open(MappedFile&& fileContents, const std::filesystem::path& file);
+    /** Writes patched records to the file. */
+    bool flush();
     bool isValid() const
     {
         return valid;
     }
 
+    /** Returns path to the opened file. */
+    const std::filesystem::path& path() const
+    {
+        return filePath;
+    }
+
     CodePage language() const;
 
     std::uint32_t columnsTotal() const;
     std::uint32_t recordsTotal() const;
+    /** Returns length of a record in bytes, including leading deletion flag. */
+    std::uint32_t recordLength() const;
+
+    /**
+     * Returns start of the first record, records follow each other without gaps.
+     * Returns nullptr if file is not opened.
+     */
+    const std::uint8_t* recordsBuffer() const
+    {
+        return recordsData;
+    }
 
     /** Returns nullptr in case of invalid index. */
     const DbfColumn* column(std::uint32_t index) const;
     /** Returns nullptr if column with specified name can not be found. */
     const DbfColumn* column(const std::string& name) const;
 
+    /**
+     * Resolves typed column handle by name once, to be used for reading all records.
+     * Returned handle is invalid if column does not exist or its type does not match T.
+     */
+    template <typename T>
+    DbfColumnRef<T> columnRef(const std::string& name) const
+    {
+        return DbfColumnRef<T>(column(name));
+    }
+
     /**
      * Creates thin wrapper for record data access.
      * Created records must not outlive DbfFile object that created them.
@@ -59,18 +98,33 @@ public:
      */
     bool record(DbfRecord& result, std::uint32_t index) const;
 
+    /**
+     * Returns start of the record for patching, including deletion flag.
+     * Returns nullptr in case of invalid index or if file is not opened as writable.
+     */
+    std::uint8_t* writableRecord(std::uint32_t index);
+
+    /**
+     * Builds hash index of id column for lookups of record numbers by id.
+     * Persistent index is saved next to the DBF as '<file>.<column>.idx'
+     * and reused until DBF modification time or size changes.
+     */
+    bool index(DbfIndex& result, const std::string& columnName, bool persistent = false) const;
+
 private:
-    bool readHeader(std::ifstream& stream);
-    bool readColumns(std::ifstream& stream);
-    bool readColumn(std::ifstream& stream, DbfColumn& column);
+    bool readHeader(const std::uint8_t* data);
+    bool readColumns(const std::uint8_t* data);
 
     using Columns = std::vector<DbfColumn>;
     using ColumnIndexMap = std::unordered_map<std::string, std::uint32_t>;
 
+    std::filesystem::path filePath;
     DbfHeader header{};
     Columns columns;
     ColumnIndexMap columnIndices;
-    std::vector<std::uint8_t> recordsData;
+    MappedFile contents;
+    /** Points to the first record inside file contents. */
+    const std::uint8_t* recordsData{};
     bool valid{};
 };
 
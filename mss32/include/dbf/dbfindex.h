@@ -0,0 +1,87 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFINDEX_H
+#define DBFINDEX_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+class DbfFile;
+
+/**
+ * Open addressing hash index from Midgard id column values to record numbers.
+ * Ids are packed into integers, so lookups do not allocate or compare strings.
+ * Rows with values that are not ids, deleted rows and duplicates are not indexed.
+ */
+class DbfIndex
+{
+public:
+    DbfIndex() = default;
+
+    /** Builds index of specified character column. */
+    bool build(const DbfFile& dbf, const std::string& columnName);
+
+    /**
+     * Loads index saved by save().
+     * Fails if index was built for other column or source DBF was modified since then.
+     */
+    bool load(const std::filesystem::path& indexPath,
+              const std::filesystem::path& dbfPath,
+              const std::string& columnName);
+    bool save(const std::filesystem::path& indexPath, const std::filesystem::path& dbfPath) const;
+
+    /** Returns record number of specified id or empty optional if id is not indexed. */
+    std::optional<std::uint32_t> find(std::string_view id) const;
+
+    std::uint32_t size() const
+    {
+        return keysTotal;
+    }
+
+    /**
+     * Packs 10 character id string into integer, case insensitive.
+     * Returns 0 if string is not a valid id.
+     */
+    static std::uint64_t packId(std::string_view id);
+
+private:
+    struct Slot
+    {
+        std::uint64_t key; /**< Packed id, 0 for empty slot. */
+        std::uint32_t row;
+        std::uint32_t padding;
+    };
+
+    bool insert(std::uint64_t key, std::uint32_t row);
+
+    std::vector<Slot> slots;
+    std::string column;
+    std::uint32_t keysTotal{};
+};
+
+} // namespace utils
+
+#endif // DBFINDEX_H
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <gsl/span>
 #include <string>
+#include <string_view>
 
 namespace utils {
 
@@ -42,6 +43,12 @@ public:
     bool value(std::string& result, const std::string& columnName) const;
     bool value(std::string& result, const DbfColumn& column) const;
 
+    // Characters fields access without copying, leading and trailing spaces are trimmed.
+    // Returned view points to DbfFile memory and must not outlive it.
+    bool value(std::string_view& result, std::uint32_t columnIndex) const;
+    bool value(std::string_view& result, const std::string& columnName) const;
+    bool value(std::string_view& result, const DbfColumn& column) const;
+
     // Numeric fields access
     bool value(int& result, std::uint32_t columnIndex) const;
     bool value(int& result, const std::string& columnName) const;
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFSNAPSHOT_H
+#define DBFSNAPSHOT_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+class DbfFile;
+
+/** Keys of records that differ between two snapshots of the same DBF file. */
+struct DbfChanges
+{
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> changed;
+
+    bool empty() const
+    {
+        return added.empty() && removed.empty() && changed.empty();
+    }
+};
+
+/**
+ * Per-record hashes of DBF file contents.
+ * Records are identified by values of key column, so snapshots of the same file
+ * can be compared even if records were reordered, inserted or deleted.
+ * Deleted records and records with duplicate or empty keys are ignored.
+ */
+class DbfSnapshot
+{
+public:
+    DbfSnapshot() = default;
+
+    /** Hashes records of opened DBF file. */
+    bool take(const DbfFile& dbf, const std::string& keyColumnName);
+
+    bool isValid() const
+    {
+        return valid;
+    }
+
+    /**
+     * Checks if source file size or modification time differs from snapshot ones.
+     * Does not read file contents.
+     */
+    bool isOutdated() const;
+
+    /** Returns keys of records that were added, removed or changed in newer snapshot. */
+    DbfChanges compare(const DbfSnapshot& newer) const;
+
+private:
+    std::unordered_map<std::string, std::uint64_t> records;
+    std::filesystem::path sourcePath;
+    std::uint64_t sourceSize{};
+    std::int64_t sourceTime{};
+    bool valid{};
+};
+
+} // namespace utils
+
+#endif // DBFSNAPSHOT_H
@@ -0,0 +1,68 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFSOURCESTATE_H
+#define DBFSOURCESTATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <system_error>
+
+namespace utils {
+
+/** Computes 64-bit FNV-1a hash of DBF file contents or its parts. */
+inline std::uint64_t computeHash(const std::uint8_t* data, std::size_t size)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/**
+ * Reads size and modification time of DBF file.
+ * Caches and snapshots store them to find out that their source has changed.
+ * @returns false if file is missing or can not be accessed.
+ */
+inline bool sourceState(const std::filesystem::path& dbfPath,
+                        std::uint64_t& size,
+                        std::int64_t& time)
+{
+    std::error_code error;
+    size = std::filesystem::file_size(dbfPath, error);
+    if (error) {
+        return false;
+    }
+
+    const auto writeTime = std::filesystem::last_write_time(dbfPath, error);
+    if (error) {
+        return false;
+    }
+
+    time = static_cast<std::int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+} // namespace utils
+
+#endif // DBFSOURCESTATE_H
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFTABLE_H
+#define DBFTABLE_H
+
+#include "dbfcolumn.h"
+#include "mappedfile.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+class DbfFile;
+
+/**
+ * Read-only DBF table with all values parsed beforehand and stored by columns:
+ * integers and logicals as numbers, characters as trimmed strings in a shared pool.
+ * Parsed table is saved to binary cache file and loaded with a single mapping next time.
+ * Cache is used without reading the source when its size and modification time match,
+ * otherwise source contents hash is compared, so touched but unchanged source is not parsed.
+ */
+class DbfTable
+{
+public:
+    /** Table cell, for character columns value is an offset in string pool. */
+    struct Cell
+    {
+        std::int32_t value;
+        /** String length for character columns, 0 for numbers that could not be parsed. */
+        std::uint32_t length;
+    };
+
+    /** Binary cache layout parts. */
+    struct CacheHeader;
+    struct CacheColumn;
+
+    template <typename T>
+    class Column;
+
+    DbfTable() = default;
+
+    /**
+     * Opens DBF table using binary cache from specified folder.
+     * Falls back to parsing source DBF when cache is missing or outdated,
+     * empty cache folder disables caching.
+     */
+    bool open(const std::filesystem::path& dbfPath, const std::filesystem::path& cacheFolder);
+
+    std::uint32_t columnsTotal() const;
+    std::uint32_t recordsTotal() const;
+
+    bool isDeleted(std::uint32_t row) const;
+
+    /** Returns true if column with specified name exists, regardless of its type. */
+    bool hasColumn(const std::string& name) const;
+
+    /**
+     * Resolves typed column by name.
+     * Returned column is invalid if it does not exist or its type does not match T.
+     */
+    template <typename T>
+    Column<T> column(const std::string& name) const;
+
+private:
+    bool load(const std::filesystem::path& cachePath,
+              const CacheHeader& expected,
+              bool compareHash);
+    bool build(MappedFile&& source,
+               const std::filesystem::path& dbfPath,
+               const CacheHeader& expected);
+    bool writeCache(const std::filesystem::path& cachePath) const;
+    bool readContents(const std::uint8_t* data, std::size_t size);
+
+    const CacheColumn* findColumn(const std::string& name, ColumnType type) const;
+    const Cell* cells(const CacheColumn* column) const;
+    std::string_view string(const Cell& cell) const;
+
+    MappedFile cache;
+    /** Contents of newly built cache when it is not loaded from disk. */
+    std::vector<std::uint8_t> builtContents;
+
+    const CacheHeader* header{};
+    const CacheColumn* columns{};
+    const std::uint8_t* deleted{};
+    const Cell* cellsData{};
+    const char* stringPool{};
+};
+
+template <typename T>
+class DbfTable::Column
+{
+    static_assert(std::is_same_v<T, std::string_view> || std::is_same_v<T, int>
+                      || std::is_same_v<T, bool>,
+                  "DbfTable::Column supports only std::string_view, int and bool values");
+
+public:
+    Column() = default;
+
+    Column(const DbfTable* table, const Cell* cells)
+        : table{table}
+        , cells{cells}
+    { }
+
+    bool isValid() const
+    {
+        return cells != nullptr;
+    }
+
+    /** Returns value in specified row or default one if column is invalid or value is absent. */
+    T get(std::uint32_t row, T def = T{}) const
+    {
+        if (!cells || row >= table->recordsTotal()) {
+            return def;
+        }
+
+        const Cell& cell = cells[row];
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            return table->string(cell);
+        } else if constexpr (std::is_same_v<T, int>) {
+            return cell.length ? cell.value : def;
+        } else {
+            return cell.value != 0;
+        }
+    }
+
+private:
+    const DbfTable* table{};
+    const Cell* cells{};
+};
+
+template <typename T>
+DbfTable::Column<T> DbfTable::column(const std::string& name) const
+{
+    ColumnType type{ColumnType::Logical};
+    if constexpr (std::is_same_v<T, std::string_view>) {
+        type = ColumnType::Character;
+    } else if constexpr (std::is_same_v<T, int>) {
+        type = ColumnType::Number;
+    }
+
+    return Column<T>(this, cells(findColumn(name, type)));
+}
+
+} // namespace utils
+
+#endif // DBFTABLE_H
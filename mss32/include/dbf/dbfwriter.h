@@ -0,0 +1,120 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBFWRITER_H
+#define DBFWRITER_H
+
+#include "dbfcolumn.h"
+#include "dbfheader.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+class DbfFile;
+
+/** Column description for creating DBF files, data address is computed by writer. */
+struct DbfColumnInfo
+{
+    std::string name; /**< At most 10 characters. */
+    ColumnType type;
+    std::uint8_t length;
+    std::uint8_t decimalCount{};
+};
+
+/*
+ * Field formatting for new and patched records.
+ * Record points to the record start, including deletion flag.
+ * Character values are left-aligned, numbers are right-aligned, logical values are 'T' or 'F'.
+ * Returns false if value does not fit into the field or column type does not match.
+ */
+bool writeField(std::uint8_t* record, const DbfColumn& column, std::string_view value);
+/** Keeps string literals from being converted to bool. */
+bool writeField(std::uint8_t* record, const DbfColumn& column, const char* value);
+bool writeField(std::uint8_t* record, const DbfColumn& column, int value);
+bool writeField(std::uint8_t* record, const DbfColumn& column, bool value);
+
+/**
+ * Writes DBF file record by record, keeping at most one buffer of records in memory.
+ * Records count in header is updated on close.
+ */
+class DbfWriter
+{
+public:
+    DbfWriter() = default;
+    ~DbfWriter();
+
+    DbfWriter(const DbfWriter&) = delete;
+    DbfWriter& operator=(const DbfWriter&) = delete;
+
+    bool open(const std::filesystem::path& file,
+              const std::vector<DbfColumnInfo>& columnInfos,
+              CodePage language = CodePage::RussianWin);
+    /** Writes remaining records, records count and end of file marker. */
+    bool close();
+
+    const std::vector<DbfColumn>& columns() const
+    {
+        return tableColumns;
+    }
+
+    /** Starts new record with all fields filled with spaces. */
+    std::uint8_t* newRecord(bool deleted = false);
+    /** Appends record started by newRecord(). */
+    bool writeRecord();
+
+    std::uint32_t recordsTotal() const
+    {
+        return header.recordsTotal;
+    }
+
+    std::uint32_t recordLength() const
+    {
+        return header.recordLength;
+    }
+
+private:
+    bool flushBuffer();
+
+    std::ofstream stream;
+    DbfHeader header{};
+    std::vector<DbfColumn> tableColumns;
+    std::vector<std::uint8_t> buffer;
+    /** Offset of the current record in buffer. */
+    std::size_t recordOffset{};
+    bool recordStarted{};
+};
+
+/**
+ * Creates copy of DBF file with new columns appended to each record, in a single pass.
+ * Fields of new columns are set to specified default values.
+ * Destination may be the source itself, it is replaced only when copy is complete.
+ */
+bool addColumns(const std::filesystem::path& source,
+                const std::filesystem::path& destination,
+                const std::vector<DbfColumnInfo>& columnInfos,
+                const std::vector<std::string>& defaultValues);
+
+} // namespace utils
+
+#endif // DBFWRITER_H
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace utils {
+
+/**
+ * View of the whole file contents.
+ * File is memory-mapped when possible, otherwise its contents are read in a single call.
+ * Writable views are always mapped, changes are written to the file by the system.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::filesystem::path& path, bool writable = false);
+    void close();
+    /** Writes changes of writable view to the file. */
+    bool flush();
+
+    const std::uint8_t* data() const
+    {
+        return view;
+    }
+
+    /** Returns nullptr if view is not writable. */
+    std::uint8_t* writableData()
+    {
+        return writable ? const_cast<std::uint8_t*>(view) : nullptr;
+    }
+
+    std::size_t size() const
+    {
+        return viewSize;
+    }
+
+    bool isMapped() const
+    {
+        return mapped;
+    }
+
+private:
+    bool map(const std::filesystem::path& path, bool writable);
+    bool read(const std::filesystem::path& path);
+
+    std::vector<std::uint8_t> buffer;
+    const std::uint8_t* view{};
+    std::size_t viewSize{};
+    bool mapped{};
+    bool writable{};
+};
+
+} // namespace utils
+
+#endif // MAPPEDFILE_H
@@ -20,7 +20,9 @@
 #ifndef DBFACCESS_H
 #define DBFACCESS_H
 
+#include "dbf/dbftable.h"
 #include <string>
+#include <string_view>
 
 namespace game {
 struct CMidgardID;
@@ -29,6 +31,10 @@ struct CMidgardID;
 namespace utils {
 
 class DbfFile;
+class DbfRecord;
+
+template <typename T>
+class DbfColumnRef;
 
 /**
  * Reads identifier from game database.
@@ -53,6 +59,28 @@ bool dbRead(game::CMidgardID& id,
  */
 bool dbRead(int& result, const DbfFile& database, size_t row, const std::string& columnName);
 
+/**
+ * Reads identifier from database record without allocations.
+ * @param[inout] id identifier to store results.
+ * @param[in] record database record to read from.
+ * @param[in] column handle of character column resolved beforehand.
+ * @returns false in case of invalid column handle or invalid identifier.
+ */
+bool dbRead(game::CMidgardID& id,
+            const DbfRecord& record,
+            const DbfColumnRef<std::string_view>& column);
+
+/**
+ * Reads identifier from parsed database table without allocations.
+ * @param[inout] id identifier to store results.
+ * @param[in] column character column of the table.
+ * @param row row number to access
+ * @returns false in case of invalid column, row or identifier.
+ */
+bool dbRead(game::CMidgardID& id,
+            const DbfTable::Column<std::string_view>& column,
+            std::uint32_t row);
+
 } // namespace utils
 
 #endif // DBFACCESS_H
@@ -35,6 +35,9 @@ game::CMidUnitGroup* getAllyOrEnemyGroup(const game::IMidgardObjectMap* objectMa
                                          const game::CMidgardID* unitId,
                                          bool ally);
 
+/** Returns current turn of the scenario or -1 if scenario info is not found. */
+int getScenarioTurn(const game::IMidgardObjectMap* objectMap);
+
 } // namespace hooks
 
 #endif // GAMEUTILS_H
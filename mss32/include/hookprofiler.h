@@ -0,0 +1,45 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HOOKPROFILER_H
+#define HOOKPROFILER_H
+
+namespace hooks {
+
+/**
+ * Returns thunk that counts calls of the hook and measures their duration in CPU cycles,
+ * then passes control to the hook. Thunk is installed instead of the hook itself.
+ * Thunk also records hook calls to trace if trace recording is started.
+ * Should be used only when 'profileHooks' or 'recordTrace' setting is enabled,
+ * so hooks have no overhead otherwise. Returns hook unchanged if thunk could not be created.
+ * @param target hooked function or vftable entry, used in report only.
+ */
+void* profileHook(void* target, void* hook);
+
+/**
+ * Writes call counts and duration percentiles of profiled hooks to 'hookProfile.log',
+ * sorted by total duration. Report is written on exit and when Ctrl+Shift+P is pressed.
+ * @param processExit set when called on process exit under loader lock,
+ * report is not written if a terminated hotkey thread holds the lock.
+ */
+void writeHookProfile(bool processExit = false);
+
+} // namespace hooks
+
+#endif // HOOKPROFILER_H
@@ -24,6 +24,8 @@
 #include "attacktypepairvector.h"
 #include "idlist.h"
 #include "targetslist.h"
+#include <array>
+#include <initializer_list>
 #include <string>
 #include <utility>
 #include <vector>
@@ -66,7 +68,70 @@ struct HookInfo
     void* hook;
     void** original;
 };
-using Hooks = std::vector<HookInfo>;
+
+/**
+ * Hooks to setup, stored in place so hook setup does not allocate.
+ * Capacity covers all hooks of the game with every optional setting enabled.
+ */
+class Hooks
+{
+public:
+    static constexpr std::size_t capacity{160};
+
+    Hooks() = default;
+
+    Hooks(std::initializer_list<HookInfo> list)
+    {
+        for (const auto& hook : list) {
+            emplace_back(hook);
+        }
+    }
+
+    /** Hooks that do not fit are dropped and reported by overflowed(). */
+    void emplace_back(const HookInfo& hook)
+    {
+        if (total < capacity) {
+            hooks[total++] = hook;
+        } else {
+            overflow = true;
+        }
+    }
+
+    bool overflowed() const
+    {
+        return overflow;
+    }
+
+    std::size_t size() const
+    {
+        return total;
+    }
+
+    HookInfo* begin()
+    {
+        return hooks.data();
+    }
+
+    HookInfo* end()
+    {
+        return hooks.data() + total;
+    }
+
+    const HookInfo* begin() const
+    {
+        return hooks.data();
+    }
+
+    const HookInfo* end() const
+    {
+        return hooks.data() + total;
+    }
+
+private:
+    std::array<HookInfo, capacity> hooks;
+    std::size_t total{};
+    bool overflow{};
+};
 
 /** Returns array of hooks to setup. */
 Hooks getHooks();
@@ -20,15 +20,42 @@
 #ifndef LOG_H
 #define LOG_H
 
-#include <string>
+#include <fmt/format.h>
+#include <string_view>
+#include <utility>
 
 namespace hooks {
 
+/** Returns true if debug mode setting is enabled. */
+bool debugLogEnabled();
+
 /** Prints message to the file only if debug mode setting is enabled. */
-void logDebug(const std::string& logFile, const std::string& message);
+void logDebug(std::string_view logFile, std::string_view message);
+
+/**
+ * Formats message and prints it to the file only if debug mode setting is enabled.
+ * Arguments are formatted after the check, so disabled debug logging does not allocate.
+ * Defining DISABLE_DEBUG_LOGS removes such messages at compile time.
+ */
+template <typename Format, typename Arg, typename... Args>
+inline void logDebug(std::string_view logFile, const Format& format, Arg&& arg, Args&&... args)
+{
+#ifndef DISABLE_DEBUG_LOGS
+    if (debugLogEnabled()) {
+        logDebug(logFile, fmt::format(format, std::forward<Arg>(arg), std::forward<Args>(args)...));
+    }
+#endif
+}
 
-/** Prints message to the file. */
-void logError(const std::string& logFile, const std::string& message);
+/** Prints message to the file, queued messages are written along with it. */
+void logError(std::string_view logFile, std::string_view message);
+
+/**
+ * Writes queued messages to files on the calling thread.
+ * Messages are written by background thread, this is needed only on exit or crash.
+ * Does nothing if nothing was logged yet.
+ */
+void flushLogs();
 
 } // namespace hooks
 
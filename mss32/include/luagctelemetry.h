@@ -0,0 +1,69 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LUAGCTELEMETRY_H
+#define LUAGCTELEMETRY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+struct lua_State;
+
+namespace hooks {
+
+/**
+ * Collects garbage collector statistics of a long-lived lua state.
+ * Completed collection cycles are detected with a finalizer sentinel object
+ * that recreates itself each time it is collected.
+ * Statistics are written to 'luaGc.log' only in debug mode.
+ */
+class LuaGcTelemetry
+{
+public:
+    explicit LuaGcTelemetry(const char* category);
+
+    /** Installs cycle sentinel in lua state. Telemetry must outlive the state. */
+    void attach(lua_State* lua);
+
+    /** Marks start of script call, should be paired with callFinished. */
+    void callStarted(lua_State* lua);
+    /** Marks end of script call and logs statistics if collection cycle was finished during it. */
+    void callFinished(lua_State* lua);
+
+private:
+    static int sentinelFinalizer(lua_State* lua);
+    void createSentinel(lua_State* lua);
+
+    using Clock = std::chrono::steady_clock;
+
+    std::string category;
+    Clock::time_point callStart;
+    std::uint32_t cyclesAtCallStart{};
+    std::uint32_t cycles{};
+    std::uint32_t calls{};
+    std::uint32_t callsWithCollection{};
+    std::int64_t collectionCallsTimeUs{};
+    std::int64_t maxCollectionCallTimeUs{};
+    std::size_t peakHeapSize{};
+};
+
+} // namespace hooks
+
+#endif // LUAGCTELEMETRY_H
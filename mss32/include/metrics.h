@@ -0,0 +1,119 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace game {
+struct IMidgardObjectMap;
+}
+
+namespace hooks {
+
+/** Runtime performance metrics populated by proxy subsystems. */
+enum class Metric : std::uint8_t
+{
+    Scripts,                  /**< Timer of Lua script calls. */
+    ScriptCacheHits,          /**< Script chunks found in cache. */
+    ScriptCacheMisses,        /**< Script chunks read and compiled. */
+    DbfLoads,                 /**< Timer of database loads. */
+    DbfBytesLoaded,           /**< Size of loaded database files. */
+    BattleMessagesSerialized, /**< Network messages with BattleMsgData read or written. */
+    CustomDamageRatios,       /**< Gauge, damage ratios of units kept for the current attack. */
+    Turn,                     /**< Gauge, current scenario turn. */
+    Count
+};
+
+enum class MetricType : std::uint8_t
+{
+    Counter, /**< Sum of increments. */
+    Gauge,   /**< Last set value. */
+    Timer,   /**< Number and total duration of measurements. */
+};
+
+/** Snapshot of a single metric. */
+struct MetricValue
+{
+    const char* name;
+    MetricType type;
+    /** Counter sum, gauge value or number of timer measurements. */
+    std::int64_t value;
+    /** Same as value, but since current turn started. Equals value for gauges. */
+    std::int64_t turnValue;
+    /** Total duration of timer measurements. */
+    double milliseconds;
+    double turnMilliseconds;
+};
+
+void addMetric(Metric metric, std::int64_t value = 1);
+void setMetric(Metric metric, std::int64_t value);
+
+/** Returns current time in ticks used by timers. */
+std::int64_t metricTicks();
+void addMetricTime(Metric metric, std::int64_t ticks);
+
+/** Measures duration of the scope. */
+class MetricTimer
+{
+public:
+    MetricTimer(Metric metric)
+        : metric{metric}
+        , start{metricTicks()}
+    { }
+
+    ~MetricTimer()
+    {
+        addMetricTime(metric, metricTicks() - start);
+    }
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+private:
+    Metric metric;
+    std::int64_t start;
+};
+
+std::vector<MetricValue> metricValues();
+std::optional<MetricValue> findMetric(std::string_view name);
+
+/**
+ * Checks current turn of the scenario.
+ * When turn changes, metrics of the previous turn are written to the debug log
+ * and to 'metrics.csv' if enabled, then per turn values are reset.
+ * Allocation churn of the previous turn is reported as well.
+ * Called before attacks and script conditions, where Lua can read per turn values.
+ * Native event conditions call it only if metricsWriteEnabled() returns true.
+ */
+void updateMetricsTurn(const game::IMidgardObjectMap* objectMap);
+
+/** Returns true if metrics of finished turns are written to the debug log or 'metrics.csv'. */
+bool metricsWriteEnabled();
+
+/** Writes metrics of the unfinished turn, called on exit. */
+void flushMetrics();
+
+} // namespace hooks
+
+#endif // METRICS_H
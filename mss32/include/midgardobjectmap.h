@@ -41,9 +41,15 @@ struct IMidgardObjectMapVftable
     using GetObjectsTotal = int(__thiscall*)(const IMidgardObjectMap* thisptr);
     GetObjectsTotal getObjectsTotal;
 
+    /**
+     * Creates iterator over all scenario objects, iterator data is IMidgardObjectMap::Iterator.
+     * Smart pointer owns iterator after creation and must be freed after use.
+     */
     using CreateIterator = SmartPointer*(__thiscall*)(IMidgardObjectMap* thisptr,
                                                       SmartPointer* iterator);
+    /** Creates iterator pointing to the first object. */
     CreateIterator createIterator;
+    /** Creates iterator pointing past the last object. */
     CreateIterator createIterator2;
 
     /**
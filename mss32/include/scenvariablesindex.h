@@ -0,0 +1,78 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENVARIABLESINDEX_H
+#define SCENVARIABLESINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+struct CMidScenVariables;
+struct ScenarioVariable;
+} // namespace game
+
+namespace hooks {
+
+/**
+ * Flat index of scenario variables.
+ * Variables list is created once per scenario load and variables are never added or deleted
+ * during the game, so pointers to list nodes remain valid while the list itself is alive.
+ */
+class ScenarioVariablesIndex
+{
+public:
+    ScenarioVariablesIndex(const game::CMidScenVariables* variables, std::uint32_t generation);
+
+    /**
+     * Returns true if index was built from specified variables object
+     * and no variables object was destroyed since then.
+     */
+    bool isBuiltFor(const game::CMidScenVariables* variables, std::uint32_t generation) const;
+
+    /** Returns variable with specified id or nullptr if there is no such variable. */
+    const game::ScenarioVariable* findById(int variableId) const;
+    /** Returns variable with specified name in uppercase or nullptr if not found. */
+    const game::ScenarioVariable* findByName(const std::string& name) const;
+
+    /** Returns all variables in the same order as they are stored in scenario. */
+    const std::vector<const game::ScenarioVariable*>& getVariables() const;
+
+private:
+    std::vector<const game::ScenarioVariable*> variables;
+    /** Variables indexed by their ids, nullptr for missing ids. */
+    std::vector<const game::ScenarioVariable*> variablesById;
+    std::unordered_map<std::string, const game::ScenarioVariable*> variablesByName;
+    const game::CMidScenVariables* scenVariables;
+    std::uint32_t generation;
+};
+
+/**
+ * Returns index for specified scenario variables.
+ * Index is built on first access and rebuilt after variables object is destroyed,
+ * which happens when scenario is unloaded or another save is loaded.
+ * Must be called only from the game main thread, index is not guarded by a lock.
+ */
+const ScenarioVariablesIndex& getScenarioVariablesIndex(const game::CMidScenVariables* variables);
+
+} // namespace hooks
+
+#endif // SCENVARIABLESINDEX_H
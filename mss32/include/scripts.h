@@ -21,10 +21,12 @@
 #define SCRIPTS_H
 
 #include "log.h"
+#include "settings.h"
 #include <filesystem>
 #include <fmt/format.h>
 #include <lua.hpp>
 #include <optional>
+#include <vector>
 #include <sol/sol.hpp>
 
 namespace hooks {
@@ -72,6 +74,12 @@ static inline std::optional<T> getScriptFunction(const sol::environment& env, co
     return getFunction<T>(env[name], name);
 }
 
+/**
+ * Reads and compiles scripts that are loaded with api bound, so their first call is faster.
+ * Can be called from any thread, calls of loadScriptFile wait for scripts being compiled.
+ */
+void preloadScriptFiles(const std::vector<std::filesystem::path>& paths);
+
 /** Returns lua state wrapper with specified script loaded in it and api bound. */
 std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
                                          bool alwaysExists = false,
@@ -80,6 +88,9 @@ std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
 /** Returns lua state wrapper with optionally bound api. */
 sol::state createLuaState(bool bindApi = false);
 
+/** Switches lua state garbage collector to mode and parameters from settings. */
+void configureGarbageCollector(lua_State* lua, const Settings::LuaGarbageCollector& settings);
+
 } // namespace hooks
 
 #endif // SCRIPTS_H
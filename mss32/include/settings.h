@@ -80,6 +80,33 @@ struct Settings
         bool realMovementCost{};
     } movementCost;
 
+    struct LuaGarbageCollector
+    {
+        bool generational{};
+        // Incremental mode parameters
+        int pause{};
+        int stepMultiplier{};
+        int stepSize{};
+        // Generational mode parameters
+        int minorMultiplier{};
+        int majorMultiplier{};
+    };
+
+    struct LuaGarbageCollectors
+    {
+        /** Short-lived states created for each script call. */
+        LuaGarbageCollector scripts;
+        /** Long-lived state shared by all scriptable event conditions. */
+        LuaGarbageCollector eventConditions;
+    } luaGc;
+
+    bool cacheDatabases;
+    bool reloadDatabases;
+    bool profileHooks;
+    bool recordTrace;
+    bool captureBattles;
+    bool writeMetrics;
+
     bool debugMode;
 };
 
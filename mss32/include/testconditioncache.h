@@ -0,0 +1,61 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTCONDITIONCACHE_H
+#define TESTCONDITIONCACHE_H
+
+#include <functional>
+
+namespace game {
+struct IMidgardObjectMap;
+struct CMidgardID;
+} // namespace game
+
+namespace hooks {
+
+/**
+ * Caches inputs and results of custom event condition tests that do not change
+ * during a game session: game mode, player types, players affected by events.
+ * Results are keyed by condition addresses and player ids, they are dropped
+ * when session generation changes.
+ */
+
+/**
+ * Starts new session generation.
+ * Called when custom event conditions are created or destroyed, this happens only
+ * when scenario or saved game is loaded and unloaded, or when events are edited.
+ */
+void nextTestConditionGeneration();
+
+/** Returns cached test result that depends only on static session properties. */
+bool getSessionTestResult(const void* condition, const std::function<bool()>& test);
+
+/** Returns cached test result that depends only on static session properties of a player. */
+bool getPlayerTestResult(const void* condition,
+                         const game::CMidgardID* playerId,
+                         const std::function<bool()>& test);
+
+/** Cached version of CMidEventApi::affectsPlayer. */
+bool eventAffectsPlayer(const game::IMidgardObjectMap* objectMap,
+                        const game::CMidgardID* playerId,
+                        const game::CMidgardID* eventId);
+
+} // namespace hooks
+
+#endif // TESTCONDITIONCACHE_H
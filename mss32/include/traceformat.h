@@ -0,0 +1,77 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACEFORMAT_H
+#define TRACEFORMAT_H
+
+#include <cstdint>
+
+namespace hooks {
+
+/**
+ * Layout of trace files written by the proxy:
+ * TraceFileHeader, names as 32-bit length followed by characters, name ids are their indices,
+ * then for each thread its 32-bit id, 32-bit number of records and TraceRecord array.
+ * Records of each thread are ordered by time.
+ */
+static const char traceMagic[4] = {'D', '2', 'T', 'R'};
+static const std::uint32_t traceVersion = 1;
+
+enum class TraceEvent : std::uint16_t
+{
+    Hook,               /**< Payload is hook address. */
+    LuaCall,            /**< Name is script file. */
+    EventConditionTest, /**< Name is condition type. */
+    DbfLoad,            /**< Name is database file, end payload is 1 if table was loaded. */
+    BattleMsgSerialize, /**< Payload is 1 when message is read, 0 when written. */
+};
+
+enum class TracePhase : std::uint8_t
+{
+    Begin,
+    End,
+};
+
+struct TraceRecord
+{
+    std::uint64_t timestamp; /**< In ticks, see TraceFileHeader::ticksPerSecond. */
+    std::uint32_t name;
+    std::uint16_t event;
+    std::uint8_t phase;
+    std::uint8_t reserved;
+    std::uint64_t payload;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "Size of TraceRecord structure must be exactly 24 bytes");
+
+struct TraceFileHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t ticksPerSecond;
+    std::uint32_t namesTotal;
+    std::uint32_t threadsTotal;
+};
+
+static_assert(sizeof(TraceFileHeader) == 24,
+              "Size of TraceFileHeader structure must be exactly 24 bytes");
+
+} // namespace hooks
+
+#endif // TRACEFORMAT_H
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include "traceformat.h"
+#include <cstdint>
+#include <string_view>
+
+namespace hooks {
+
+/** Set once by startTraceRecording(), checked by instrumentation points. */
+extern bool traceRecording;
+
+/**
+ * Enables trace recording, must be called before hooks are installed.
+ * Each thread records into its own ring buffer that keeps the latest events,
+ * buffers are written to 'mss32Trace.bin' on exit and when Ctrl+Shift+T is pressed.
+ */
+void startTraceRecording();
+
+/** Id of the empty name, used by records without name. */
+constexpr std::uint32_t emptyTraceName{0};
+
+/**
+ * Returns id of the name, equal names have equal ids.
+ * Takes a lock, call sites intern their names once and keep ids.
+ */
+std::uint32_t traceName(std::string_view name);
+
+/** Returns id of the name for rarely recorded events, does not intern it if recording is off. */
+inline std::uint32_t traceNameIfRecording(std::string_view name)
+{
+    return traceRecording ? traceName(name) : emptyTraceName;
+}
+
+/** Appends record to the buffer of the calling thread. */
+void traceRecord(TraceEvent event, TracePhase phase, std::uint32_t name, std::uint64_t payload);
+
+/**
+ * Writes recorded events of all threads to the trace file.
+ * @param processExit set when called on process exit under loader lock.
+ * Other threads are already terminated then and never release their locks,
+ * so trace is not written if any of them is held.
+ */
+void writeTrace(bool processExit = false);
+
+/**
+ * Records begin and end of the scope, does nothing if trace recording is disabled.
+ * Takes id of the interned name, so recording does not lock or allocate.
+ */
+class TraceScope
+{
+public:
+    TraceScope(TraceEvent event, std::uint32_t nameId, std::uint64_t payload = 0)
+        : event{event}
+        , active{traceRecording}
+        , nameId{nameId}
+    {
+        if (active) {
+            traceRecord(event, TracePhase::Begin, nameId, payload);
+        }
+    }
+
+    ~TraceScope()
+    {
+        if (active) {
+            traceRecord(event, TracePhase::End, nameId, endPayload);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /** Sets payload of the end record. */
+    void setPayload(std::uint64_t payload)
+    {
+        endPayload = payload;
+    }
+
+private:
+    TraceEvent event;
+    bool active;
+    std::uint32_t nameId;
+    std::uint64_t endPayload{};
+};
+
+} // namespace hooks
+
+#endif // TRACERECORDER_H
@@ -21,6 +21,7 @@
 #define UTILS_H
 
 #include "midgardid.h"
+#include <cstddef>
 #include <filesystem>
 #include <functional>
 #include <string>
@@ -32,6 +33,10 @@ struct CMidScenVariables;
 struct ScenarioVariable;
 } // namespace game
 
+namespace utils {
+class DbfCatalog;
+}
+
 namespace hooks {
 
 std::string trimSpaces(const std::string& str);
@@ -42,6 +47,15 @@ const std::filesystem::path& gameFolder();
 /** Returns full path to the scripts folder. */
 const std::filesystem::path& scriptsFolder();
 
+/**
+ * Returns full path to the folder with binary caches of game databases.
+ * Returns empty path if caching is disabled in settings.
+ */
+std::filesystem::path dbfCacheFolder();
+
+/** Returns process-wide catalog of DBF tables read by the proxy. */
+utils::DbfCatalog& dbfCatalog();
+
 /** Returns full path to the executable that is currently running. */
 const std::filesystem::path& exePath();
 
@@ -75,6 +89,15 @@ void showMessageBox(const std::string& message,
 /** Shows windows style message box that does not depend on game rendering and resources. */
 void showErrorMessageBox(const std::string& message);
 
+/**
+ * Writes data to memory protected from writing, such as vftables.
+ * @returns false if memory protection could not be changed.
+ */
+bool writeProtectedMemory(void* address, const void* data, std::size_t size);
+
+/** Returns true if foreground window belongs to the game process, so hotkeys are meant for it. */
+bool isGameWindowActive();
+
 game::CMidgardID createScenarioVariablesId(const game::IMidgardObjectMap* objectMap);
 
 /** Calls specified function on each scenario variable. */
@@ -34,8 +34,17 @@ enum class GameVersion
     ScenarioEditor
 };
 
-/** Returns determined game version. */
-GameVersion gameVersion();
+/** Game version determined once at startup, use gameVersion() to read it. */
+extern GameVersion currentGameVersion;
+
+/**
+ * Returns determined game version.
+ * Inlined since every game function and variable lookup indexes its address table with it.
+ */
+inline GameVersion gameVersion()
+{
+    return currentGameVersion;
+}
 
 /** Returns true if dll loaded from game executable. */
 bool executableIsGame();
@@ -0,0 +1,210 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocationstats.h"
+#include "log.h"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <fmt/format.h>
+
+namespace hooks {
+
+struct AllocationTagInfo
+{
+    const char* name;
+    bool freesTracked;
+    /** Objects of subsystem should not outlive the game. */
+    bool checkLeaks;
+};
+
+static constexpr std::array<AllocationTagInfo, (std::size_t)AllocationTag::Count> tagInfos{{
+    {"modifiedUnits", true, true},
+    {"customAttacks", false, false},
+    {"eventConditions", true, true},
+    {"images", false, false},
+    {"messageBoxes", false, false},
+    {"buildings", false, false},
+    // Lua states of condition scripts live until static destructors are called
+    {"lua", true, false},
+    {"scripts", false, false},
+}};
+
+struct AllocationCounters
+{
+    std::atomic<std::int64_t> bytes{};
+    std::atomic<std::int64_t> objects{};
+    std::atomic<std::int64_t> peakBytes{};
+    std::atomic<std::int64_t> allocations{};
+    std::atomic<std::int64_t> frees{};
+    std::atomic<std::int64_t> turnAllocations{};
+    std::atomic<std::int64_t> turnBytes{};
+};
+
+static std::array<AllocationCounters, (std::size_t)AllocationTag::Count> counters;
+
+static AllocationCounters& getCounters(AllocationTag tag)
+{
+    return counters[static_cast<std::size_t>(tag)];
+}
+
+static void addBytes(AllocationCounters& tagCounters, std::int64_t bytes)
+{
+    const auto total{tagCounters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+
+    auto peak{tagCounters.peakBytes.load(std::memory_order_relaxed)};
+    while (total > peak
+           && !tagCounters.peakBytes.compare_exchange_weak(peak, total,
+                                                           std::memory_order_relaxed)) { }
+}
+
+void trackAllocation(AllocationTag tag, std::size_t bytes)
+{
+    auto& tagCounters = getCounters(tag);
+    const auto size{static_cast<std::int64_t>(bytes)};
+
+    addBytes(tagCounters, size);
+    tagCounters.objects.fetch_add(1, std::memory_order_relaxed);
+    tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+    tagCounters.turnAllocations.fetch_add(1, std::memory_order_relaxed);
+    tagCounters.turnBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void trackFree(AllocationTag tag, std::size_t bytes)
+{
+    auto& tagCounters = getCounters(tag);
+
+    tagCounters.bytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+    tagCounters.objects.fetch_sub(1, std::memory_order_relaxed);
+    tagCounters.frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* trackedLuaAlloc(void*, void* ptr, std::size_t osize, std::size_t nsize)
+{
+    // For new blocks osize holds type of the object being created
+    const std::size_t oldSize{ptr ? osize : 0};
+
+    if (nsize == 0) {
+        if (ptr) {
+            trackFree(AllocationTag::Lua, oldSize);
+            std::free(ptr);
+        }
+
+        return nullptr;
+    }
+
+    void* block = std::realloc(ptr, nsize);
+    if (!block) {
+        return nullptr;
+    }
+
+    if (!ptr) {
+        trackAllocation(AllocationTag::Lua, nsize);
+    } else {
+        auto& tagCounters = getCounters(AllocationTag::Lua);
+        const auto delta{static_cast<std::int64_t>(nsize) - static_cast<std::int64_t>(oldSize)};
+
+        addBytes(tagCounters, delta);
+        if (delta > 0) {
+            tagCounters.turnBytes.fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    return block;
+}
+
+std::vector<AllocationStats> allocationStats()
+{
+    std::vector<AllocationStats> stats;
+    stats.reserve(counters.size());
+
+    for (std::size_t i = 0; i < counters.size(); ++i) {
+        const auto& tagCounters = counters[i];
+
+        stats.push_back(AllocationStats{tagInfos[i].name,
+                                        tagCounters.bytes.load(std::memory_order_relaxed),
+                                        tagCounters.objects.load(std::memory_order_relaxed),
+                                        tagCounters.peakBytes.load(std::memory_order_relaxed),
+                                        tagCounters.allocations.load(std::memory_order_relaxed),
+                                        tagCounters.frees.load(std::memory_order_relaxed),
+                                        tagCounters.turnAllocations.load(std::memory_order_relaxed),
+                                        tagCounters.turnBytes.load(std::memory_order_relaxed),
+                                        tagInfos[i].freesTracked});
+    }
+
+    return stats;
+}
+
+void finishAllocationTurn(int turn)
+{
+    for (std::size_t i = 0; i < counters.size(); ++i) {
+        auto& tagCounters = counters[i];
+
+        const auto allocations{tagCounters.turnAllocations.exchange(0, std::memory_order_relaxed)};
+        const auto bytes{tagCounters.turnBytes.exchange(0, std::memory_order_relaxed)};
+        if (allocations) {
+            logDebug("allocations.log", "Turn {:d}, {:s}: {:d} allocations, {:d} bytes", turn,
+                     tagInfos[i].name, allocations, bytes);
+        }
+    }
+
+    logAllocationStats("allocations.log");
+}
+
+void logAllocationStats(std::string_view logFile)
+{
+    if (!debugLogEnabled()) {
+        return;
+    }
+
+    for (const auto& stats : allocationStats()) {
+        if (!stats.allocations) {
+            continue;
+        }
+
+        if (stats.freesTracked) {
+            logDebug(logFile,
+                     "{:s}: {:d} objects, {:d} bytes alive, peak {:d} bytes, "
+                     "{:d} allocations, {:d} frees",
+                     stats.name, stats.objects, stats.bytes, stats.peakBytes, stats.allocations,
+                     stats.frees);
+        } else {
+            logDebug(logFile, "{:s}: {:d} allocations, {:d} bytes, freed by the game",
+                     stats.name, stats.allocations, stats.bytes);
+        }
+    }
+}
+
+void reportAllocationLeaks()
+{
+    logAllocationStats("allocations.log");
+
+    const auto stats{allocationStats()};
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        if (!tagInfos[i].checkLeaks || !stats[i].objects) {
+            continue;
+        }
+
+        logError("mssProxyError.log",
+                 fmt::format("{:d} objects of {:s} ({:d} bytes) remained on finalization",
+                             stats[i].objects, stats[i].name, stats[i].bytes));
+    }
+}
+
+} // namespace hooks
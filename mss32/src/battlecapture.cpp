@@ -0,0 +1,287 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "battlecapture.h"
+#include "attackimpl.h"
+#include "attackreachcat.h"
+#include "attackutils.h"
+#include "battlemsgdata.h"
+#include "battlesnapshotview.h"
+#include "customattacks.h"
+#include "log.h"
+#include "unitimplview.h"
+#include "unitslotview.h"
+#include "unitview.h"
+#include "utils.h"
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace hooks {
+
+bool battleCapturing{};
+
+/** Action being captured by the thread, filled between scope creation and finish. */
+struct PendingCapture
+{
+    bool open;
+    const game::BattleMsgData* battleMsgData;
+    BattleCaptureRecord record;
+    std::vector<char> targeting;
+};
+
+static thread_local PendingCapture pendingCapture{};
+
+static std::mutex fileMutex;
+static std::ofstream captureFile;
+static bool captureFileFailed{};
+
+template <typename T>
+static void append(std::vector<char>& buffer, const T& value)
+{
+    const auto data = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+static bool openCaptureFile()
+{
+    using namespace game;
+
+    if (captureFile.is_open()) {
+        return true;
+    }
+
+    if (captureFileFailed) {
+        return false;
+    }
+
+    const auto path{gameFolder() / "battleCapture.bin"};
+    captureFile.open(path.c_str(), std::ios_base::binary);
+    if (!captureFile) {
+        captureFileFailed = true;
+        logError("mssProxyError.log", fmt::format("Could not create {:s}", path.string()));
+        return false;
+    }
+
+    BattleCaptureHeader header{};
+    std::memcpy(header.magic, battleCaptureMagic, sizeof(battleCaptureMagic));
+    header.version = battleCaptureVersion;
+    header.battleMsgDataSize = sizeof(BattleMsgData);
+    header.unitsInfoTotal = sizeof(BattleMsgData::unitsInfo) / sizeof(UnitInfo);
+    header.modifiedUnitsTotal = ModifiedUnitCountPatched;
+    header.modifiedUnitSize = sizeof(ModifiedUnitInfo);
+
+    const auto& distances = bindings::BattleSnapshotView::getDistanceTable();
+    for (std::uint32_t from = 0; from < battleCaptureSlotsTotal; ++from) {
+        for (std::uint32_t to = 0; to < battleCaptureSlotsTotal; ++to) {
+            header.distances[from][to] = distances[from][to];
+        }
+    }
+
+    captureFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    logDebug("mss32Proxy.log", "Battle capture started, writing to {:s}", path.string());
+    return true;
+}
+
+void startBattleCapture()
+{
+    battleCapturing = true;
+}
+
+BattleCaptureScope::BattleCaptureScope(const game::BattleMsgData* battleMsgData,
+                                       game::BattleAction action,
+                                       const game::LAttackReach* attackReach,
+                                       const game::CMidgardID* targetUnitId)
+    : active{battleCapturing}
+{
+    if (!active) {
+        return;
+    }
+
+    // Buffer is reused by the next actions of the thread
+    pendingCapture.open = true;
+    pendingCapture.battleMsgData = battleMsgData;
+    pendingCapture.record = {};
+    pendingCapture.targeting.clear();
+
+    auto& record = pendingCapture.record;
+    record.action = static_cast<std::int32_t>(action);
+    record.round = battleMsgData->currentRound;
+    record.attackReach = static_cast<std::int32_t>(attackReach->id);
+    record.targetUnitId = static_cast<std::uint32_t>(targetUnitId->value);
+}
+
+BattleCaptureScope::~BattleCaptureScope()
+{
+    if (active) {
+        pendingCapture.open = false;
+    }
+}
+
+void BattleCaptureScope::finish(const game::IAttack* attack, const game::IdList* targets)
+{
+    using namespace game;
+
+    if (!active) {
+        return;
+    }
+
+    const auto& listApi = IdListApi::get();
+
+    auto& pending = pendingCapture;
+    auto& record = pending.record;
+
+    std::vector<char> tail;
+    IdListIterator it, end;
+    for (listApi.begin(targets, &it), listApi.end(targets, &end); !listApi.equals(&it, &end);
+         listApi.preinc(&it)) {
+        append(tail, static_cast<std::uint32_t>(listApi.dereference(&it)->value));
+        ++record.targetsTotal;
+    }
+
+    auto attackImpl = attack ? getAttackImpl(attack) : nullptr;
+    if (attackImpl) {
+        const auto data = attackImpl->data;
+        record.flags |= static_cast<std::uint8_t>(BattleCaptureFlag::DamageRatio);
+        record.damageRatio = data->damageRatio;
+        record.damageRatioPerTarget = data->damageRatioPerTarget;
+        record.damageSplit = data->damageSplit;
+    }
+
+    if (attack && getCustomAttacks().damageRatio.enabled) {
+        const auto ratios{computeAttackDamageRatio(attack, record.targetsTotal)};
+        for (double ratio : ratios) {
+            append(tail, ratio);
+        }
+
+        record.ratiosTotal = static_cast<std::uint32_t>(ratios.size());
+    }
+
+    const auto battleMsgData = pending.battleMsgData;
+    const std::uint32_t modifiedUnitsSize = sizeof(ModifiedUnitInfo) * ModifiedUnitCountPatched;
+    record.size = static_cast<std::uint32_t>(
+        sizeof(BattleMsgData) + std::size(battleMsgData->unitsInfo) * modifiedUnitsSize
+        + pending.targeting.size() + tail.size());
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (!openCaptureFile()) {
+        return;
+    }
+
+    captureFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    captureFile.write(reinterpret_cast<const char*>(battleMsgData), sizeof(BattleMsgData));
+    for (const auto& unitInfo : battleMsgData->unitsInfo) {
+        captureFile.write(reinterpret_cast<const char*>(unitInfo.modifiedUnits.patched),
+                          modifiedUnitsSize);
+    }
+
+    captureFile.write(pending.targeting.data(), pending.targeting.size());
+    captureFile.write(tail.data(), tail.size());
+    // Keep captured actions in case the game crashes later
+    captureFile.flush();
+}
+
+static void captureUnit(BattleCaptureUnit& value, const bindings::UnitSlotView& slot)
+{
+    const auto unitView{slot.getUnitView()};
+    if (!unitView) {
+        return;
+    }
+
+    value.unitId = static_cast<std::uint32_t>(slot.getUnitId().value);
+    value.xp = unitView->getXp();
+
+    const auto impl{unitView->getImpl()};
+    if (!impl) {
+        return;
+    }
+
+    value.xpNext = impl->getXpNext();
+    value.xpKilled = impl->getXpKilled();
+    value.armor = impl->getArmor();
+    value.regen = impl->getRegen();
+    value.subrace = impl->getSubRace();
+    value.male = impl->isMale();
+    value.waterOnly = impl->isWaterOnly();
+    value.attacksTwice = impl->attacksTwice();
+}
+
+void captureTargeting(const std::string& scriptFile,
+                      const bindings::UnitSlotView& attacker,
+                      const bindings::UnitSlotView& selected,
+                      const UnitSlots& allies,
+                      const UnitSlots& targets,
+                      bool targetsAreAllies,
+                      const bindings::BattleSnapshotView& battle,
+                      const UnitSlots& result)
+{
+    if (!pendingCapture.open) {
+        return;
+    }
+
+    BattleCaptureTargeting targeting{};
+    for (std::uint32_t i = 0; i < battleCaptureSlotsTotal; ++i) {
+        auto& unit = targeting.units[i];
+        unit.hp = battle.getHp()[i];
+        unit.hpMax = battle.getHpMax()[i];
+        unit.level = battle.getLevel()[i];
+        unit.race = battle.getRace()[i];
+        unit.small = battle.getSmall()[i];
+        unit.statuses = static_cast<std::uint64_t>(battle.getStatuses()[i]);
+    }
+
+    auto slotIndex = [&](const bindings::UnitSlotView& slot) {
+        const int index = battle.getSlotIndex(slot);
+        if (index > 0) {
+            captureUnit(targeting.units[index - 1], slot);
+        }
+
+        return static_cast<std::uint8_t>(index);
+    };
+
+    std::vector<std::uint8_t> indices;
+    for (const auto& slots : {&allies, &targets, &result}) {
+        for (const auto& slot : *slots) {
+            indices.push_back(slotIndex(slot));
+        }
+    }
+
+    targeting.attacker = slotIndex(attacker);
+    targeting.selected = slotIndex(selected);
+    targeting.alliesTotal = static_cast<std::uint8_t>(allies.size());
+    targeting.targetsTotal = static_cast<std::uint8_t>(targets.size());
+    targeting.resultTotal = static_cast<std::uint8_t>(result.size());
+
+    auto& pending = pendingCapture;
+    pending.record.flags |= static_cast<std::uint8_t>(BattleCaptureFlag::Targeting);
+    if (targetsAreAllies) {
+        pending.record.flags |= static_cast<std::uint8_t>(BattleCaptureFlag::TargetsAreAllies);
+    }
+
+    auto& buffer = pending.targeting;
+    buffer.clear();
+    append(buffer, targeting);
+    buffer.insert(buffer.end(), indices.begin(), indices.end());
+    append(buffer, static_cast<std::uint32_t>(scriptFile.size()));
+    buffer.insert(buffer.end(), scriptFile.begin(), scriptFile.end());
+}
+
+} // namespace hooks
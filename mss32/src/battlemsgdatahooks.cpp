@@ -18,44 +18,34 @@
  */
 
 #include "battlemsgdatahooks.h"
-#include "log.h"
+#include "allocationstats.h"
 #include "modifierutils.h"
 #include "originalfunctions.h"
-#include <atomic>
-#include <fmt/format.h>
+#include <cstring>
 
 namespace hooks {
 
+/** Leaks are reported by reportAllocationLeaks on exit. */
 class ModifiedUnitsPatchedFactory
 {
 public:
-    ModifiedUnitsPatchedFactory()
-        : count(0)
-    { }
-
-    ~ModifiedUnitsPatchedFactory()
-    {
-        if (count != 0) {
-            logError("mssProxyError.log",
-                     fmt::format("{:d} instances of ModifiedUnitsPatched remained on finalization",
-                                 count));
-        }
-    }
-
     game::ModifiedUnitInfo* create()
     {
-        count++;
+        trackAllocation(AllocationTag::ModifiedUnits, arraySize);
         return new game::ModifiedUnitInfo[game::ModifiedUnitCountPatched];
     }
 
     void destroy(game::ModifiedUnitInfo* value)
     {
-        count--;
-        delete[] value;
+        if (value) {
+            trackFree(AllocationTag::ModifiedUnits, arraySize);
+            delete[] value;
+        }
     }
 
 private:
-    std::atomic<int> count;
+    static constexpr std::size_t arraySize{sizeof(game::ModifiedUnitInfo)
+                                           * game::ModifiedUnitCountPatched};
 } modifiedUnitsPatchedFactory;
 
 void resetUnitInfo(game::UnitInfo* unitInfo)
@@ -0,0 +1,205 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "battlesnapshotview.h"
+#include "battlemsgdata.h"
+#include "game.h"
+#include "globaldata.h"
+#include "midunit.h"
+#include "midunitgroup.h"
+#include "racetype.h"
+#include "unitslotview.h"
+#include "unitutils.h"
+#include "ussoldier.h"
+#include <sol/sol.hpp>
+
+namespace bindings {
+
+BattleSnapshotView::BattleSnapshotView(const game::IMidgardObjectMap* objectMap,
+                                       const game::BattleMsgData* battleMsgData,
+                                       const game::CMidgardID* unitGroupId)
+{
+    const auto& otherGroupId = *unitGroupId == battleMsgData->attackerGroupId
+                                   ? battleMsgData->defenderGroupId
+                                   : battleMsgData->attackerGroupId;
+
+    groupIds[0] = *unitGroupId;
+    groupIds[1] = otherGroupId;
+
+    readGroup(objectMap, battleMsgData, &groupIds[0], 0);
+    readGroup(objectMap, battleMsgData, &groupIds[1], groupSize);
+}
+
+void BattleSnapshotView::bind(sol::state& lua)
+{
+    auto snapshot = lua.new_usertype<BattleSnapshotView>("BattleSnapshot");
+    snapshot["hp"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getHp()); });
+    snapshot["hpMax"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getHpMax()); });
+    snapshot["level"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getLevel()); });
+    snapshot["statuses"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getStatuses()); });
+    snapshot["small"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getSmall()); });
+    snapshot["race"] = sol::property(
+        [](const BattleSnapshotView& view) { return sol::as_table(view.getRace()); });
+    snapshot["distances"] = sol::property(
+        [](const BattleSnapshotView&) { return sol::as_nested(getDistanceTable()); });
+    snapshot["slotIndex"] = &BattleSnapshotView::getSlotIndex;
+    snapshot["distance"] = &BattleSnapshotView::getDistance;
+    snapshot["hasStatus"] = &BattleSnapshotView::hasStatus;
+}
+
+const BattleSnapshotView::SlotArray<int>& BattleSnapshotView::getHp() const
+{
+    return hp;
+}
+
+const BattleSnapshotView::SlotArray<int>& BattleSnapshotView::getHpMax() const
+{
+    return hpMax;
+}
+
+const BattleSnapshotView::SlotArray<int>& BattleSnapshotView::getLevel() const
+{
+    return level;
+}
+
+const BattleSnapshotView::SlotArray<std::int64_t>& BattleSnapshotView::getStatuses() const
+{
+    return statuses;
+}
+
+const BattleSnapshotView::SlotArray<bool>& BattleSnapshotView::getSmall() const
+{
+    return small;
+}
+
+const BattleSnapshotView::SlotArray<int>& BattleSnapshotView::getRace() const
+{
+    return race;
+}
+
+int BattleSnapshotView::getSlotIndex(const UnitSlotView& slot) const
+{
+    const int position = slot.getPosition();
+    if (position < 0 || position >= (int)groupSize)
+        return 0;
+
+    const auto groupId = slot.getGroupId();
+    if (groupId == groupIds[0])
+        return position + 1;
+
+    if (groupId == groupIds[1])
+        return position + 1 + (int)groupSize;
+
+    return 0;
+}
+
+int BattleSnapshotView::getDistance(int fromSlot, int toSlot) const
+{
+    if (fromSlot < 1 || fromSlot > (int)slotsTotal || toSlot < 1 || toSlot > (int)slotsTotal)
+        return 0;
+
+    return getDistanceTable()[fromSlot - 1][toSlot - 1];
+}
+
+bool BattleSnapshotView::hasStatus(int slot, int status) const
+{
+    if (slot < 1 || slot > (int)slotsTotal || status < 0 || status >= 64)
+        return false;
+
+    return (statuses[slot - 1] & (std::int64_t{1} << status)) != 0;
+}
+
+const BattleSnapshotView::DistanceTable& BattleSnapshotView::getDistanceTable()
+{
+    static const DistanceTable table = []() {
+        using namespace game;
+
+        const auto& fn = gameFunctions();
+
+        DistanceTable value{};
+        for (std::size_t from = 0; from < slotsTotal; ++from) {
+            for (std::size_t to = 0; to < slotsTotal; ++to) {
+                const bool sameGroup = from / groupSize == to / groupSize;
+                value[from][to] = fn.getUnitPositionDistance((int)(from % groupSize),
+                                                             (int)(to % groupSize), sameGroup);
+            }
+        }
+
+        return value;
+    }();
+
+    return table;
+}
+
+void BattleSnapshotView::readGroup(const game::IMidgardObjectMap* objectMap,
+                                   const game::BattleMsgData* battleMsgData,
+                                   const game::CMidgardID* groupId,
+                                   std::size_t firstSlot)
+{
+    using namespace game;
+
+    if (*groupId == emptyId)
+        return;
+
+    const auto& fn = gameFunctions();
+    const auto& battle = BattleMsgDataApi::get();
+    const auto& globalApi = GlobalDataApi::get();
+    const auto races = (*globalApi.getGlobalData())->races;
+
+    void* tmp{};
+    auto group = fn.getStackFortRuinGroup(tmp, objectMap, groupId);
+    if (!group)
+        return;
+
+    for (std::size_t i = 0; i < groupSize; ++i) {
+        const CMidgardID unitId = group->positions[i];
+        if (unitId == emptyId)
+            continue;
+
+        auto unit = fn.findUnitById(objectMap, &unitId);
+        if (!unit)
+            continue;
+
+        const std::size_t slot = firstSlot + i;
+        hp[slot] = unit->currentHp;
+        hpMax[slot] = CMidUnitApi::get().getHpMax(unit);
+        small[slot] = hooks::isUnitSmall(unit);
+
+        auto info = battle.getUnitInfoById(battleMsgData, &unitId);
+        if (info)
+            statuses[slot] = (std::int64_t)info->unitStatuses;
+
+        auto soldier = hooks::castUnitImplToSoldierWithLogging(unit->unitImpl);
+        if (!soldier)
+            continue;
+
+        level[slot] = soldier->vftable->getLevel(soldier);
+
+        auto raceType = (TRaceType*)globalApi.findById(races, soldier->vftable->getRaceId(soldier));
+        if (raceType)
+            race[slot] = (int)raceType->data->raceType.id;
+    }
+}
+
+} // namespace bindings
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fortview.h"
+#include "fortcategory.h"
+#include "fortification.h"
+#include "midvillage.h"
+#include <sol/sol.hpp>
+
+namespace bindings {
+
+FortView::FortView(const game::CFortification* fort)
+    : fort(fort)
+{ }
+
+void FortView::bind(sol::state& lua)
+{
+    auto fortView = lua.new_usertype<FortView>("Fort");
+    fortView["id"] = sol::property(&FortView::getId);
+    fortView["position"] = sol::property(&FortView::getPosition);
+    fortView["owner"] = sol::property(&FortView::getOwnerId);
+    fortView["category"] = sol::property(&FortView::getCategory);
+    fortView["tier"] = sol::property(&FortView::getTier);
+    fortView["capital"] = sol::property(&FortView::isCapital);
+}
+
+IdView FortView::getId() const
+{
+    return IdView{fort->cityId};
+}
+
+Point FortView::getPosition() const
+{
+    return Point{fort->mapElement.position};
+}
+
+IdView FortView::getOwnerId() const
+{
+    return IdView{fort->ownerId};
+}
+
+int FortView::getCategory() const
+{
+    using namespace game;
+
+    auto vftable = static_cast<const CFortificationVftable*>(fort->vftable);
+    auto category = vftable->getCategory(const_cast<CFortification*>(fort));
+
+    return static_cast<int>(category->id);
+}
+
+int FortView::getTier() const
+{
+    if (isCapital()) {
+        return 0;
+    }
+
+    return static_cast<const game::CMidVillage*>(fort)->tierLevel;
+}
+
+bool FortView::isCapital() const
+{
+    return getCategory() == static_cast<int>(game::FortCategories::get().capital->id);
+}
+
+} // namespace bindings
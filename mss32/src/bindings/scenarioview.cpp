@@ -19,18 +19,205 @@
 
 #include "scenarioview.h"
 #include "dynamiccast.h"
+#include "fortification.h"
+#include "fortview.h"
+#include "iterators.h"
 #include "locationview.h"
+#include "log.h"
+#include "midgardid.h"
 #include "midgardmapblock.h"
 #include "midgardobjectmap.h"
+#include "midplayer.h"
 #include "midscenvariables.h"
+#include "midstack.h"
+#include "racetype.h"
 #include "scenarioinfo.h"
 #include "scenvariablesview.h"
+#include "stackview.h"
 #include "tileview.h"
 #include "utils.h"
+#include <functional>
 #include <sol/sol.hpp>
+#include <utility>
 
 namespace bindings {
 
+static void readOptional(std::optional<int>& result, const sol::table& table, const char* name)
+{
+    auto value = table.get<sol::optional<int>>(name);
+    if (value.has_value()) {
+        result = value.value();
+    }
+}
+
+static ObjectFilter readObjectFilter(const sol::optional<sol::table>& table)
+{
+    ObjectFilter filter;
+    if (!table.has_value()) {
+        return filter;
+    }
+
+    const auto& value = table.value();
+
+    const sol::object owner = value["owner"];
+    if (owner.is<IdView>()) {
+        filter.ownerId = owner.as<IdView>().id;
+    } else if (owner.is<std::string>()) {
+        filter.ownerId = IdView{owner.as<std::string>()}.id;
+    }
+
+    readOptional(filter.race, value, "race");
+    readOptional(filter.category, value, "category");
+    readOptional(filter.minTier, value, "minTier");
+    readOptional(filter.maxTier, value, "maxTier");
+
+    auto area = value.get<sol::optional<sol::table>>("area");
+    if (area.has_value()) {
+        const auto& box = area.value();
+        filter.area = ObjectFilter::Area{box.get_or("x1", 0), box.get_or("y1", 0),
+                                         box.get_or("x2", 0), box.get_or("y2", 0)};
+    }
+
+    return filter;
+}
+
+/** Calls specified function on each object traversed by typed iterator. */
+static bool forEachObject(const game::IMidgardObjectMap* objectMap,
+                          game::Iterators::Api::CreateIterator createIterator,
+                          game::Iterators::Api::CreateIterator createEndIterator,
+                          std::function<void(const game::IMidScenarioObject*)> f)
+{
+    using namespace game;
+
+    if (!createIterator || !createEndIterator) {
+        // Iterator is not known for current game version
+        return false;
+    }
+
+    auto map = const_cast<IMidgardObjectMap*>(objectMap);
+
+    IteratorPtr iteratorPtr;
+    createIterator(&iteratorPtr, map);
+    IteratorPtr endIteratorPtr;
+    createEndIterator(&endIteratorPtr, map);
+
+    auto iterator = iteratorPtr.data;
+    while (!iterator->vftable->end(iterator, endIteratorPtr.data)) {
+        auto id = iterator->vftable->getObjectId(iterator);
+        auto obj = objectMap->vftable->findScenarioObjectById(objectMap, id);
+        if (obj) {
+            f(obj);
+        }
+
+        iterator->vftable->advance(iterator);
+    }
+
+    auto& freeSmartPtr = SmartPointerApi::get().createOrFree;
+    freeSmartPtr((SmartPointer*)&iteratorPtr, nullptr);
+    freeSmartPtr((SmartPointer*)&endIteratorPtr, nullptr);
+    return true;
+}
+
+/**
+ * Calls specified function on each object with specified id type.
+ * Walks all scenario objects with object map iterators that exist in every game version,
+ * unlike typed iterators.
+ */
+static void forEachObjectOfType(const game::IMidgardObjectMap* objectMap,
+                                game::IdType type,
+                                std::function<void(const game::IMidScenarioObject*)> f)
+{
+    using namespace game;
+
+    const auto& idApi = CMidgardIDApi::get();
+    auto map = const_cast<IMidgardObjectMap*>(objectMap);
+
+    IteratorPtr iteratorPtr{};
+    map->vftable->createIterator(map, (SmartPointer*)&iteratorPtr);
+    IteratorPtr endIteratorPtr{};
+    map->vftable->createIterator2(map, (SmartPointer*)&endIteratorPtr);
+
+    auto iterator = iteratorPtr.data;
+    while (!iterator->vftable->end(iterator, endIteratorPtr.data)) {
+        auto id = iterator->vftable->getObjectId(iterator);
+        if (idApi.getType(id) == type) {
+            auto obj = objectMap->vftable->findScenarioObjectById(objectMap, id);
+            if (obj) {
+                f(obj);
+            }
+        }
+
+        iterator->vftable->advance(iterator);
+    }
+
+    auto& freeSmartPtr = SmartPointerApi::get().createOrFree;
+    freeSmartPtr((SmartPointer*)&iteratorPtr, nullptr);
+    freeSmartPtr((SmartPointer*)&endIteratorPtr, nullptr);
+}
+
+/**
+ * Checks owner related predicates of the filter.
+ * Owner races are cached per query since there are only a few players in scenario.
+ */
+class OwnerMatcher
+{
+public:
+    OwnerMatcher(const game::IMidgardObjectMap* objectMap, const ObjectFilter& filter)
+        : objectMap{objectMap}
+        , filter{filter}
+    { }
+
+    bool matches(const game::CMidgardID& ownerId)
+    {
+        if (filter.ownerId && *filter.ownerId != ownerId) {
+            return false;
+        }
+
+        if (filter.race && *filter.race != getRace(ownerId)) {
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    int getRace(const game::CMidgardID& ownerId)
+    {
+        using namespace game;
+
+        for (const auto& [id, race] : races) {
+            if (id == ownerId) {
+                return race;
+            }
+        }
+
+        int race{-1};
+        auto playerObj = objectMap->vftable->findScenarioObjectById(objectMap, &ownerId);
+        if (playerObj) {
+            auto player = static_cast<const CMidPlayer*>(playerObj);
+            race = static_cast<int>(player->raceType->data->raceType.id);
+        }
+
+        races.emplace_back(ownerId, race);
+        return race;
+    }
+
+    const game::IMidgardObjectMap* objectMap;
+    const ObjectFilter& filter;
+    std::vector<std::pair<game::CMidgardID, int>> races;
+};
+
+static bool isInsideArea(const ObjectFilter& filter, const game::CMqPoint& position)
+{
+    if (!filter.area) {
+        return true;
+    }
+
+    const auto& area = *filter.area;
+    return position.x >= area.x1 && position.x <= area.x2 && position.y >= area.y1
+           && position.y <= area.y2;
+}
+
 ScenarioView::ScenarioView(const game::IMidgardObjectMap* objectMap)
     : objectMap(objectMap)
 { }
@@ -42,6 +229,13 @@ void ScenarioView::bind(sol::state& lua)
                                               &ScenarioView::getLocationById);
     scenario["variables"] = sol::property(&ScenarioView::getScenVariables);
     scenario["getTile"] = sol::overload<>(&ScenarioView::getTile, &ScenarioView::getTileByPoint);
+    scenario["findFortifications"] = [](const ScenarioView& view,
+                                        sol::optional<sol::table> filter) {
+        return sol::as_table(view.findFortifications(readObjectFilter(filter)));
+    };
+    scenario["findStacks"] = [](const ScenarioView& view, sol::optional<sol::table> filter) {
+        return sol::as_table(view.findStacks(readObjectFilter(filter)));
+    };
     scenario["day"] = sol::property(&ScenarioView::getCurrentDay);
     scenario["size"] = sol::property(&ScenarioView::getSize);
 }
@@ -131,6 +325,74 @@ std::optional<TileView> ScenarioView::getTileByPoint(const Point& p) const
     return getTile(p.x, p.y);
 }
 
+std::vector<FortView> ScenarioView::findFortifications(const ObjectFilter& filter) const
+{
+    using namespace game;
+
+    std::vector<FortView> result;
+    OwnerMatcher owner{objectMap, filter};
+
+    const auto& iterators = Iterators::get();
+    const bool traversed = forEachObject(
+        objectMap, iterators.createFortificationsIterator,
+        iterators.createFortificationsEndIterator,
+        [&filter, &owner, &result](const IMidScenarioObject* obj) {
+            auto fortification = static_cast<const CFortification*>(obj);
+
+            if (!isInsideArea(filter, fortification->mapElement.position)
+                || !owner.matches(fortification->ownerId)) {
+                return;
+            }
+
+            const FortView fort{fortification};
+
+            if (filter.category && *filter.category != fort.getCategory()) {
+                return;
+            }
+
+            if (filter.minTier || filter.maxTier) {
+                const int tier = fort.getTier();
+                if ((filter.minTier && tier < *filter.minTier)
+                    || (filter.maxTier && tier > *filter.maxTier)) {
+                    return;
+                }
+            }
+
+            result.push_back(fort);
+        });
+
+    if (!traversed) {
+        hooks::logError("mssProxyError.log",
+                        "Fortifications iterator is not supported in current game version");
+    }
+
+    return result;
+}
+
+std::vector<StackView> ScenarioView::findStacks(const ObjectFilter& filter) const
+{
+    using namespace game;
+
+    std::vector<StackView> result;
+    OwnerMatcher owner{objectMap, filter};
+
+    // Stacks iterator is known only for Scenario Editor, scripts are called in the game
+    forEachObjectOfType(objectMap, IdType::Stack,
+                        [&filter, &owner, &result](const IMidScenarioObject* obj) {
+                            auto stack = static_cast<const CMidStack*>(obj);
+
+                            if (!isInsideArea(filter,
+                                              static_cast<const IMapElement*>(stack)->position)
+                                || !owner.matches(stack->ownerId)) {
+                                return;
+                            }
+
+                            result.emplace_back(stack);
+                        });
+
+    return result;
+}
+
 int ScenarioView::getCurrentDay() const
 {
     auto info = getScenarioInfo();
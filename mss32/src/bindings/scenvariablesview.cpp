@@ -21,6 +21,7 @@
 #include "log.h"
 #include "midscenvariables.h"
 #include "scenariovariableview.h"
+#include "scenvariablesindex.h"
 #include "utils.h"
 #include <algorithm>
 #include <fmt/format.h>
@@ -30,17 +31,7 @@ namespace bindings {
 
 ScenVariablesView::ScenVariablesView(const game::CMidScenVariables* scenVariables)
     : scenVariables(scenVariables)
-{
-    // Game does not have functions for search variables by name,
-    // but accessing them using it is convenient for scripts.
-    // Cache scenario variables for our own fast search by name.
-    // This is safe because variables list is created once
-    // and there are no additions or deletions of them during the game.
-    hooks::forEachScenarioVariable(scenVariables,
-                                   [this](const game::ScenarioVariable* variable, std::uint32_t) {
-                                       variables[variable->data.name] = variable;
-                                   });
-}
+{ }
 
 void ScenVariablesView::bind(sol::state& lua)
 {
@@ -55,12 +46,14 @@ std::optional<ScenarioVariableView> ScenVariablesView::getScenarioVariable(
     // Game stores variable names in uppercase
     std::transform(ingameName.begin(), ingameName.end(), ingameName.begin(), toupper);
 
-    const auto it = variables.find(ingameName);
-    if (it == variables.end()) {
+    // Game does not have functions for search variables by name,
+    // use our own index that is built once per scenario
+    const auto variable = hooks::getScenarioVariablesIndex(scenVariables).findByName(ingameName);
+    if (!variable) {
         return std::nullopt;
     }
 
-    return ScenarioVariableView{it->second};
+    return ScenarioVariableView{variable};
 }
 
 } // namespace bindings
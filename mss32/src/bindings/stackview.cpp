@@ -0,0 +1,65 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stackview.h"
+#include "midstack.h"
+#include <sol/sol.hpp>
+
+namespace bindings {
+
+StackView::StackView(const game::CMidStack* stack)
+    : stack(stack)
+{ }
+
+void StackView::bind(sol::state& lua)
+{
+    auto stackView = lua.new_usertype<StackView>("Stack");
+    stackView["id"] = sol::property(&StackView::getId);
+    stackView["position"] = sol::property(&StackView::getPosition);
+    stackView["owner"] = sol::property(&StackView::getOwnerId);
+    stackView["leader"] = sol::property(&StackView::getLeaderId);
+    stackView["inside"] = sol::property(&StackView::getInsideId);
+}
+
+IdView StackView::getId() const
+{
+    return IdView{stack->stackId};
+}
+
+Point StackView::getPosition() const
+{
+    return Point{static_cast<const game::IMapElement*>(stack)->position};
+}
+
+IdView StackView::getOwnerId() const
+{
+    return IdView{stack->ownerId};
+}
+
+IdView StackView::getLeaderId() const
+{
+    return IdView{stack->leaderId};
+}
+
+IdView StackView::getInsideId() const
+{
+    return IdView{stack->insideId};
+}
+
+} // namespace bindings
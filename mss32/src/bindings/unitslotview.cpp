@@ -40,15 +40,17 @@ bool UnitSlotView::operator==(const UnitSlotView& value) const
 
 void UnitSlotView::bind(sol::state& lua)
 {
-    auto slot = lua.new_usertype<UnitSlotView>("UnitSlot", "distance", &getDistance,
-                                               sol::meta_function::equal_to, &operator==);
-    slot["unit"] = sol::property(&getUnitView);
-    slot["position"] = sol::property(&getPosition);
-    slot["line"] = sol::property(&getLine);
-    slot["column"] = sol::property(&getColumn);
-    slot["frontline"] = sol::property(&isFrontline);
-    slot["backline"] = sol::property(&isBackline);
-    lua.set_function("distance", &getDistance);
+    auto slot = lua.new_usertype<UnitSlotView>("UnitSlot", "distance",
+                                               &UnitSlotView::getDistance,
+                                               sol::meta_function::equal_to,
+                                               &UnitSlotView::operator==);
+    slot["unit"] = sol::property(&UnitSlotView::getUnitView);
+    slot["position"] = sol::property(&UnitSlotView::getPosition);
+    slot["line"] = sol::property(&UnitSlotView::getLine);
+    slot["column"] = sol::property(&UnitSlotView::getColumn);
+    slot["frontline"] = sol::property(&UnitSlotView::isFrontline);
+    slot["backline"] = sol::property(&UnitSlotView::isBackline);
+    lua.set_function("distance", &UnitSlotView::getDistance);
 }
 
 std::optional<UnitView> UnitSlotView::getUnitView() const
@@ -99,6 +101,11 @@ game::CMidgardID UnitSlotView::getUnitId() const
     return unit ? unit->unitId : emptyId;
 }
 
+game::CMidgardID UnitSlotView::getGroupId() const
+{
+    return groupId;
+}
+
 const game::CMidUnit* UnitSlotView::getUnit() const
 {
     return unit;
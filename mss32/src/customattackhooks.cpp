@@ -18,14 +18,17 @@
  */
 
 #include "customattackhooks.h"
+#include "allocationstats.h"
 #include "attackclasscat.h"
 #include "attackimpl.h"
 #include "attackutils.h"
 #include "batattacktransformself.h"
+#include "battlecapture.h"
 #include "customattack.h"
 #include "customattacks.h"
 #include "customattackutils.h"
-#include "dbf/dbffile.h"
+#include "databasereload.h"
+#include "dbf/dbfcatalog.h"
 #include "dbtable.h"
 #include "dynamiccast.h"
 #include "game.h"
@@ -65,20 +68,13 @@ game::LAttackClassTable* __fastcall attackClassTableCtorHooked(game::LAttackClas
     logDebug("newAttackType.log", "LAttackClassTable c-tor hook started");
 
     {
-        utils::DbfFile dbf;
         std::filesystem::path globals{globalsFolderPath};
-        if (!dbf.open(globals / dbfFileName)) {
+        const auto dbf{dbfCatalog().table(globals / dbfFileName)};
+        if (!dbf) {
             logError("mssProxyError.log", fmt::format("Could not open {:s}", dbfFileName));
-        } else {
-            utils::DbfRecord record;
-            if (dbf.recordsTotal() > 26 && dbf.record(record, 26)) {
-                std::string categoryName;
-                if (record.value(categoryName, "TEXT")
-                    && trimSpaces(categoryName) == customCategoryName) {
-                    customAttackExists = true;
-                    logDebug("newAttackType.log", "Found custom attack category");
-                }
-            }
+        } else if (dbf->column<std::string_view>("TEXT").get(26) == customCategoryName) {
+            customAttackExists = true;
+            logDebug("newAttackType.log", "Found custom attack category");
         }
     }
 
@@ -136,7 +132,9 @@ game::LAttackSourceTable* __fastcall attackSourceTableCtorHooked(game::LAttackSo
     logDebug("customAttacks.log", "LAttackSourceTable c-tor hook started");
 
     static const char dbfFileName[] = "LAttS.dbf";
-    fillCustomAttackSources(std::filesystem::path(globalsFolderPath) / dbfFileName);
+    const auto dbfFilePath{std::filesystem::path(globalsFolderPath) / dbfFileName};
+    fillCustomAttackSources(dbfFilePath);
+    watchDatabase(ReloadableDatabase::AttackSources, dbfFilePath);
 
     thisptr->bgn = nullptr;
     thisptr->end = nullptr;
@@ -158,8 +156,7 @@ game::LAttackSourceTable* __fastcall attackSourceTableCtorHooked(game::LAttackSo
     table.readCategory(sources.earth, thisptr, "L_EARTH", dbfFileName);
 
     for (auto& custom : getCustomAttacks().sources) {
-        logDebug("customAttacks.log",
-                 fmt::format("Reading custom attack source {:s}", custom.text));
+        logDebug("customAttacks.log", "Reading custom attack source {:s}", custom.text);
         table.readCategory(&custom.source, thisptr, custom.text.c_str(), dbfFileName);
     }
 
@@ -177,7 +174,9 @@ game::LAttackReachTable* __fastcall attackReachTableCtorHooked(game::LAttackReac
     logDebug("customAttacks.log", "LAttackReachTable c-tor hook started");
 
     static const char dbfFileName[] = "LAttR.dbf";
-    fillCustomAttackReaches(std::filesystem::path(globalsFolderPath) / dbfFileName);
+    const auto dbfFilePath{std::filesystem::path(globalsFolderPath) / dbfFileName};
+    fillCustomAttackReaches(dbfFilePath);
+    watchDatabase(ReloadableDatabase::AttackReaches, dbfFilePath);
 
     thisptr->bgn = nullptr;
     thisptr->end = nullptr;
@@ -194,7 +193,7 @@ game::LAttackReachTable* __fastcall attackReachTableCtorHooked(game::LAttackReac
     table.readCategory(reaches.adjacent, thisptr, "L_ADJACENT", dbfFileName);
 
     for (auto& custom : getCustomAttacks().reaches) {
-        logDebug("customAttacks.log", fmt::format("Reading custom attack reach {:s}", custom.text));
+        logDebug("customAttacks.log", "Reading custom attack reach {:s}", custom.text);
         table.readCategory(&custom.reach, thisptr, custom.text.c_str(), dbfFileName);
     }
 
@@ -212,7 +211,7 @@ game::CAttackImpl* __fastcall attackImplCtorHooked(game::CAttackImpl* thisptr,
 
     const auto& attackImpl = CAttackImplApi::get();
 
-    thisptr->data = (CAttackImplData*)Memory::get().allocate(sizeof(CAttackImplData));
+    thisptr->data = allocateTracked<CAttackImplData>(AllocationTag::CustomAttacks);
 
     attackImpl.initData(thisptr->data);
     thisptr->vftable = CAttackImplApi::vftable();
@@ -348,7 +347,7 @@ game::IBatAttack* __stdcall createBatAttackHooked(game::IMidgardObjectMap* objec
     using namespace game;
 
     if (attackClass->id == customAttackClass.id) {
-        CustomAttack* customAttack = (CustomAttack*)Memory::get().allocate(sizeof(CustomAttack));
+        auto customAttack = allocateTracked<CustomAttack>(AllocationTag::CustomAttacks);
         customAttackCtor(customAttack, objectMap, id1, id2, attackNumber);
 
         return customAttack;
@@ -624,6 +623,8 @@ void __stdcall getTargetsToAttackHooked(game::IdList* value,
 
     const auto& listApi = IdListApi::get();
 
+    BattleCaptureScope capture{battleMsgData, action, attackReach, targetUnitId};
+
     if (!getTargetsToAttackForAllOrCustomReach(value, objectMap, attack, batAttack, attackReach,
                                                battleMsgData, action, targetUnitId)) {
         listApi.pushBack(value, targetUnitId);
@@ -631,6 +632,8 @@ void __stdcall getTargetsToAttackHooked(game::IdList* value,
 
     if (getCustomAttacks().damageRatio.enabled)
         fillCustomDamageRatios(attack, value);
+
+    capture.finish(attack, value);
 }
 
 void __stdcall fillTargetsListHooked(const game::IMidgardObjectMap* objectMap,
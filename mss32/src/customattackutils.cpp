@@ -24,24 +24,29 @@
 #include "attackutils.h"
 #include "batattack.h"
 #include "batattacktransformself.h"
+#include "battlecapture.h"
+#include "battlesnapshotview.h"
 #include "battlemsgdata.h"
 #include "customattacks.h"
-#include "dbffile.h"
+#include "dbfcatalog.h"
 #include "dynamiccast.h"
 #include "game.h"
 #include "idlistutils.h"
 #include "log.h"
+#include "metrics.h"
 #include "midgardobjectmap.h"
 #include "midplayer.h"
 #include "midunit.h"
 #include "midunitgroup.h"
 #include "scripts.h"
 #include "targetslistutils.h"
+#include "tracerecorder.h"
 #include "unitslotview.h"
 #include "unitutils.h"
 #include "ussoldier.h"
 #include "utils.h"
 #include <fmt/format.h>
+#include <unordered_map>
 
 namespace hooks {
 
@@ -49,8 +54,8 @@ void fillCustomAttackSources(const std::filesystem::path& dbfFilePath)
 {
     using namespace game;
 
-    utils::DbfFile dbf;
-    if (!dbf.open(dbfFilePath)) {
+    const auto dbf{dbfCatalog().table(dbfFilePath)};
+    if (!dbf) {
         logError("mssProxyError.log",
                  fmt::format("Could not open {:s}", dbfFilePath.filename().string()));
         return;
@@ -60,41 +65,34 @@ void fillCustomAttackSources(const std::filesystem::path& dbfFilePath)
     static const std::array<const char*, 8> baseSources = {
         {"L_WEAPON", "L_MIND", "L_LIFE", "L_DEATH", "L_FIRE", "L_WATER", "L_AIR", "L_EARTH"}};
 
+    const auto textColumn{dbf->column<std::string_view>("TEXT")};
+    const auto nameTxtColumn{dbf->column<std::string_view>("NAME_TXT")};
+    const auto immuAiRatingColumn{dbf->column<int>("IMMU_AI_R")};
+
     auto& customSources = getCustomAttacks().sources;
     std::uint32_t wardFlagPosition = lastBaseSourceWardFlagPosition;
-    const auto recordsTotal{dbf.recordsTotal()};
+    const auto recordsTotal{dbf->recordsTotal()};
     for (std::uint32_t i = 0; i < recordsTotal; ++i) {
-        utils::DbfRecord record;
-        if (!dbf.record(record, i)) {
-            logError("mssProxyError.log", fmt::format("Could not read record {:d} from {:s}", i,
-                                                      dbfFilePath.filename().string()));
-            return;
-        }
-
-        if (record.isDeleted()) {
+        if (dbf->isDeleted(i)) {
             continue;
         }
 
-        std::string text;
-        record.value(text, "TEXT");
-        text = trimSpaces(text);
+        const auto text{textColumn.get(i)};
 
         if (std::none_of(std::begin(baseSources), std::end(baseSources),
                          [&text](const char* baseText) { return text == baseText; })) {
-            std::string nameId;
-            record.value(nameId, "NAME_TXT");
+            const auto nameId{nameTxtColumn.get(i)};
 
-            int immunityAiRating = 5; // 5 is the default
-            record.value(immunityAiRating, "IMMU_AI_R");
+            const int immunityAiRating = immuAiRatingColumn.get(i, 5); // 5 is the default
 
             logDebug("customAttacks.log",
-                     fmt::format(
-                         "Found custom attack source {:s}, name id {:s}, immunity ai rating {:d}",
-                         text, nameId, immunityAiRating));
+                     "Found custom attack source {:s}, name id {:s}, immunity ai rating {:d}", text,
+                     nameId, immunityAiRating);
 
             customSources.push_back(
                 {LAttackSource{AttackSourceCategories::vftable(), nullptr, (AttackSourceId)-1},
-                 text, nameId, (double)immunityAiRating, ++wardFlagPosition});
+                 std::string(text), std::string(nameId), (double)immunityAiRating,
+                 ++wardFlagPosition});
         }
     }
 }
@@ -103,8 +101,8 @@ void fillCustomAttackReaches(const std::filesystem::path& dbfFilePath)
 {
     using namespace game;
 
-    utils::DbfFile dbf;
-    if (!dbf.open(dbfFilePath)) {
+    const auto dbf{dbfCatalog().table(dbfFilePath)};
+    if (!dbf) {
         logError("mssProxyError.log",
                  fmt::format("Could not open {:s}", dbfFilePath.filename().string()));
         return;
@@ -112,63 +110,69 @@ void fillCustomAttackReaches(const std::filesystem::path& dbfFilePath)
 
     static const std::array<const char*, 3> baseReaches = {{"L_ALL", "L_ANY", "L_ADJACENT"}};
 
+    const auto textColumn{dbf->column<std::string_view>("TEXT")};
+    const auto reachTxtColumn{dbf->column<std::string_view>("REACH_TXT")};
+    const auto targetsTxtColumn{dbf->column<std::string_view>("TARGET_TXT")};
+    const auto selectionScriptColumn{dbf->column<std::string_view>("SEL_SCRIPT")};
+    const auto attackScriptColumn{dbf->column<std::string_view>("ATT_SCRIPT")};
+    const auto markTargetsColumn{dbf->column<bool>("MRK_TARGTS")};
+    const auto meleeColumn{dbf->column<bool>("MELEE")};
+    const auto maxTargetsColumn{dbf->column<int>("MAX_TARGTS")};
+
     auto& customReaches = getCustomAttacks().reaches;
-    const auto recordsTotal{dbf.recordsTotal()};
+    const auto recordsTotal{dbf->recordsTotal()};
     for (std::uint32_t i = 0; i < recordsTotal; ++i) {
-        utils::DbfRecord record;
-        if (!dbf.record(record, i)) {
-            logError("mssProxyError.log", fmt::format("Could not read record {:d} from {:s}", i,
-                                                      dbfFilePath.filename().string()));
-            return;
-        }
-
-        if (record.isDeleted()) {
+        if (dbf->isDeleted(i)) {
             continue;
         }
 
-        std::string text;
-        record.value(text, "TEXT");
-        text = trimSpaces(text);
+        const auto text{textColumn.get(i)};
 
         if (std::none_of(std::begin(baseReaches), std::end(baseReaches),
                          [&text](const char* baseText) { return text == baseText; })) {
-            std::string reachTxt;
-            record.value(reachTxt, "REACH_TXT");
-
-            std::string targetsTxt;
-            record.value(targetsTxt, "TARGET_TXT");
-
-            std::string selectionScript;
-            record.value(selectionScript, "SEL_SCRIPT");
-
-            std::string attackScript;
-            record.value(attackScript, "ATT_SCRIPT");
-
-            bool markAttackTargets = false;
-            record.value(markAttackTargets, "MRK_TARGTS");
+            const auto reachTxt{reachTxtColumn.get(i)};
+            const auto targetsTxt{targetsTxtColumn.get(i)};
+            const auto selectionScript{selectionScriptColumn.get(i)};
+            const auto attackScript{attackScriptColumn.get(i)};
+            const bool markAttackTargets = markTargetsColumn.get(i, false);
+            const bool melee = meleeColumn.get(i, false);
+            const int maxTargets = maxTargetsColumn.get(i, 1); // 1 is the default
 
-            bool melee = false;
-            record.value(melee, "MELEE");
-
-            int maxTargets = 1; // 1 is the default
-            record.value(maxTargets, "MAX_TARGTS");
-
-            logDebug("customAttacks.log", fmt::format("Found custom attack reach {:s}", text));
+            logDebug("customAttacks.log", "Found custom attack reach {:s}", text);
 
             customReaches.push_back(
-                {LAttackReach{AttackReachCategories::vftable(), nullptr, (AttackReachId)-1}, text,
-                 reachTxt, targetsTxt, trimSpaces(selectionScript), trimSpaces(attackScript),
+                {LAttackReach{AttackReachCategories::vftable(), nullptr, (AttackReachId)-1},
+                 std::string(text), std::string(reachTxt), std::string(targetsTxt),
+                 std::string(selectionScript), std::string(attackScript),
                  markAttackTargets, melee, (std::uint32_t)maxTargets});
         }
     }
 }
 
+/** Returns trace name id of the script, names are interned once per script and thread. */
+static std::uint32_t scriptTraceName(const std::string& scriptFile)
+{
+    if (!traceRecording) {
+        return emptyTraceName;
+    }
+
+    thread_local std::unordered_map<std::string, std::uint32_t> ids;
+
+    auto it = ids.find(scriptFile);
+    if (it == ids.end()) {
+        it = ids.emplace(scriptFile, traceName(scriptFile)).first;
+    }
+
+    return it->second;
+}
+
 UnitSlots getTargetsToSelectOrAttack(const std::string& scriptFile,
                                      const bindings::UnitSlotView& attacker,
                                      const bindings::UnitSlotView& selected,
                                      const UnitSlots& allies,
                                      const UnitSlots& targets,
-                                     bool targetsAreAllies)
+                                     bool targetsAreAllies,
+                                     const bindings::BattleSnapshotView& battle)
 {
     const auto path{scriptsFolder() / scriptFile};
     const auto lua{loadScriptFile(path, true, true)};
@@ -178,7 +182,8 @@ UnitSlots getTargetsToSelectOrAttack(const std::string& scriptFile,
 
     using GetTargets = std::function<sol::table(const bindings::UnitSlotView&,
                                                 const bindings::UnitSlotView&, const UnitSlots&,
-                                                const UnitSlots&, bool)>;
+                                                const UnitSlots&, bool,
+                                                const bindings::BattleSnapshotView&)>;
     auto getTargets = getScriptFunction<GetTargets>(*lua, "getTargets");
     if (!getTargets) {
         showErrorMessageBox(fmt::format("Could not find function 'getTargets' in script '{:s}'.\n"
@@ -188,7 +193,10 @@ UnitSlots getTargetsToSelectOrAttack(const std::string& scriptFile,
     }
 
     try {
-        return (*getTargets)(attacker, selected, allies, targets, targetsAreAllies).as<UnitSlots>();
+        TraceScope trace{TraceEvent::LuaCall, scriptTraceName(scriptFile)};
+        MetricTimer timer{Metric::Scripts};
+        return (*getTargets)(attacker, selected, allies, targets, targetsAreAllies, battle)
+            .as<UnitSlots>();
     } catch (const std::exception& e) {
         showErrorMessageBox(fmt::format("Failed to run '{:s}' script.\n"
                                         "Reason: '{:s}'",
@@ -313,10 +321,11 @@ void fillTargetsListForCustomAttackReach(const game::IMidgardObjectMap* objectMa
 
     auto targets = getTargets(objectMap, battleMsgData, batAttack, targetGroupId, unitId, &emptyId);
     auto allies = getAllies(objectMap, battleMsgData, unitGroupId, unitId);
+    bindings::BattleSnapshotView battle(objectMap, battleMsgData, unitGroupId);
 
     auto targetsToSelect = getTargetsToSelectOrAttack(attackReach.selectionScript, attacker,
                                                       selected, allies, targets,
-                                                      *unitGroupId == *targetGroupId);
+                                                      *unitGroupId == *targetGroupId, battle);
 
     bool isSummonAttack = batAttack->vftable->method17(batAttack, battleMsgData);
     for (const auto& target : targetsToSelect) {
@@ -405,9 +414,17 @@ UnitSlots getTargetsToAttackForCustomAttackReach(const game::IMidgardObjectMap*
     auto targets = getTargets(objectMap, battleMsgData, batAttack, targetGroupId, unitId,
                               targetUnitId);
     auto allies = getAllies(objectMap, battleMsgData, unitGroupId, unitId);
+    bindings::BattleSnapshotView battle(objectMap, battleMsgData, unitGroupId);
+
+    const bool targetsAreAllies = *unitGroupId == *targetGroupId;
+    auto result = getTargetsToSelectOrAttack(attackReach.attackScript, attacker, selected, allies,
+                                             targets, targetsAreAllies, battle);
+    if (battleCapturing) {
+        captureTargeting(attackReach.attackScript, attacker, selected, allies, targets,
+                         targetsAreAllies, battle, result);
+    }
 
-    return getTargetsToSelectOrAttack(attackReach.attackScript, attacker, selected, allies, targets,
-                                      *unitGroupId == *targetGroupId);
+    return result;
 }
 
 UnitSlots getTargetsToAttackForCustomAttackReach(const game::IMidgardObjectMap* objectMap,
@@ -523,17 +540,17 @@ void excludeImmuneTargets(const game::IMidgardObjectMap* objectMap,
 
 void initializeAttackDamageRatio()
 {
-    utils::DbfFile dbf;
     const std::filesystem::path dbfFilePath{gameFolder() / "globals" / "Gattacks.dbf"};
-    if (!dbf.open(dbfFilePath)) {
+    const auto dbf{dbfCatalog().table(dbfFilePath)};
+    if (!dbf) {
         logError("mssProxyError.log",
                  fmt::format("Could not open {:s}", dbfFilePath.filename().string()));
         return;
     }
 
-    getCustomAttacks().damageRatio.enabled = dbf.column(damageRatioColumnName)
-                                             && dbf.column(damageRatioPerTargetColumnName)
-                                             && dbf.column(damageSplitColumnName);
+    getCustomAttacks().damageRatio.enabled = dbf->hasColumn(damageRatioColumnName)
+                                             && dbf->hasColumn(damageRatioPerTargetColumnName)
+                                             && dbf->hasColumn(damageSplitColumnName);
 }
 
 void fillCustomDamageRatios(const game::IAttack* attack, const game::IdList* targets)
@@ -554,50 +571,26 @@ void fillCustomDamageRatios(const game::IAttack* attack, const game::IdList* tar
         CMidgardID unitId = *listApi.dereference(&it);
         customRatios[unitId] = *(ratioIt++);
     }
+
+    setMetric(Metric::CustomDamageRatios, static_cast<std::int64_t>(customRatios.size()));
 }
 
-int applyAttackDamageRatio(int damage, double ratio)
+static DamageRatio getDamageRatio(const game::CAttackImpl* attackImpl)
 {
-    if (damage == 0)
-        return 0;
-
-    int result = lround(ratio * damage);
-    return result > 0 ? result : 1;
+    const auto data = attackImpl->data;
+    return {data->damageRatio, data->damageRatioPerTarget, data->damageSplit};
 }
 
 std::vector<double> computeAttackDamageRatio(const game::IAttack* attack, int targetCount)
 {
-    std::vector<double> result;
-
     if (targetCount < 2)
-        return result;
+        return {};
 
     auto attackImpl = getAttackImpl(attack);
     if (!attackImpl)
-        return result;
-
-    if (attackImpl->data->damageRatio == 100 && !attackImpl->data->damageSplit)
-        return result;
-
-    const double ratio = (double)attackImpl->data->damageRatio / 100;
-
-    double currentRatio = ratio;
-    double totalRatio = 1.0;
-    result.push_back(1.0);
-    for (int i = 1; i < targetCount; i++) {
-        result.push_back(currentRatio);
-        totalRatio += currentRatio;
-        if (attackImpl->data->damageRatioPerTarget)
-            currentRatio *= ratio;
-    }
+        return {};
 
-    if (attackImpl->data->damageSplit) {
-        for (auto it = result.begin(); it != result.end(); ++it) {
-            *it = *it / totalRatio;
-        }
-    }
-
-    return result;
+    return computeDamageRatios(getDamageRatio(attackImpl), targetCount);
 }
 
 double computeTotalDamageRatio(const game::IAttack* attack, int targetCount)
@@ -609,21 +602,7 @@ double computeTotalDamageRatio(const game::IAttack* attack, int targetCount)
     if (!attackImpl)
         return targetCount;
 
-    auto damageRatio = attackImpl->data->damageRatio;
-    if (attackImpl->data->damageSplit) {
-        return 1.0;
-    } else if (damageRatio != 100) {
-        double ratio = (double)damageRatio / 100;
-
-        double value = 1.0;
-        for (int i = 1; i < targetCount; i++) {
-            value += attackImpl->data->damageRatioPerTarget ? pow(ratio, i) : ratio;
-        }
-
-        return value;
-    }
-
-    return targetCount;
+    return computeTotalDamageRatio(getDamageRatio(attackImpl), targetCount);
 }
 
 int computeAverageTotalDamage(const game::IAttack* attack, int damage)
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damageratio.h"
+#include <cmath>
+
+namespace hooks {
+
+int applyAttackDamageRatio(int damage, double ratio)
+{
+    if (damage == 0)
+        return 0;
+
+    int result = lround(ratio * damage);
+    return result > 0 ? result : 1;
+}
+
+std::vector<double> computeDamageRatios(const DamageRatio& damageRatio, int targetCount)
+{
+    std::vector<double> result;
+
+    if (targetCount < 2)
+        return result;
+
+    if (damageRatio.ratio == 100 && !damageRatio.split)
+        return result;
+
+    const double ratio = (double)damageRatio.ratio / 100;
+
+    double currentRatio = ratio;
+    double totalRatio = 1.0;
+    result.push_back(1.0);
+    for (int i = 1; i < targetCount; i++) {
+        result.push_back(currentRatio);
+        totalRatio += currentRatio;
+        if (damageRatio.perTarget)
+            currentRatio *= ratio;
+    }
+
+    if (damageRatio.split) {
+        for (auto it = result.begin(); it != result.end(); ++it) {
+            *it = *it / totalRatio;
+        }
+    }
+
+    return result;
+}
+
+double computeTotalDamageRatio(const DamageRatio& damageRatio, int targetCount)
+{
+    if (damageRatio.split) {
+        return 1.0;
+    } else if (damageRatio.ratio != 100) {
+        double ratio = (double)damageRatio.ratio / 100;
+
+        double value = 1.0;
+        for (int i = 1; i < targetCount; i++) {
+            value += damageRatio.perTarget ? pow(ratio, i) : ratio;
+        }
+
+        return value;
+    }
+
+    return targetCount;
+}
+
+} // namespace hooks
@@ -0,0 +1,276 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "databasereload.h"
+#include "customattacks.h"
+#include "dbf/dbfcatalog.h"
+#include "dbf/dbffile.h"
+#include "dbf/dbfsnapshot.h"
+#include "log.h"
+#include "midgard.h"
+#include "settings.h"
+#include "unitsforhire.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <fmt/format.h>
+#include <string_view>
+#include <vector>
+
+namespace hooks {
+
+struct WatchedDatabase
+{
+    ReloadableDatabase database;
+    std::filesystem::path path;
+    utils::DbfSnapshot snapshot;
+};
+
+using WatchedDatabases = std::vector<WatchedDatabase>;
+
+static WatchedDatabases& watchedDatabases()
+{
+    static WatchedDatabases databases;
+    return databases;
+}
+
+static const char* keyColumnName(ReloadableDatabase database)
+{
+    return database == ReloadableDatabase::Races ? "RACE_ID" : "TEXT";
+}
+
+static void logRestartRequired(const std::filesystem::path& dbfPath,
+                               const char* what,
+                               const std::string& key)
+{
+    logError("mssProxyError.log",
+             fmt::format("{:s} {:s} {:s}, restart the game to apply this change",
+                         dbfPath.filename().string(), what, key));
+}
+
+/** Searches for record with specified key, tables are small so linear search is fine. */
+static bool findRecord(utils::DbfRecord& result,
+                       const utils::DbfFile& dbf,
+                       const utils::DbfColumnRef<std::string_view>& keyColumn,
+                       const std::string& key)
+{
+    for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i) {
+        if (dbf.record(result, i) && !result.isDeleted() && keyColumn.get(result) == key) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void applyAttackSourceChanges(const utils::DbfFile& dbf, const utils::DbfChanges& changes)
+{
+    const auto textColumn{dbf.columnRef<std::string_view>("TEXT")};
+    const auto nameTxtColumn{dbf.columnRef<std::string_view>("NAME_TXT")};
+    const auto immuAiRatingColumn{dbf.columnRef<int>("IMMU_AI_R")};
+
+    auto& sources = getCustomAttacks().sources;
+    for (const auto& text : changes.changed) {
+        auto source = std::find_if(sources.begin(), sources.end(),
+                                   [&text](const CustomAttackSource& custom) {
+                                       return custom.text == text;
+                                   });
+        utils::DbfRecord record;
+        if (source == sources.end() || !findRecord(record, dbf, textColumn, text)) {
+            logRestartRequired(dbf.path(), "changed attack source", text);
+            continue;
+        }
+
+        source->immunityAiRating = immuAiRatingColumn.get(record, 5); // 5 is the default
+        if (source->nameId != nameTxtColumn.get(record)) {
+            logRestartRequired(dbf.path(), "changed name of attack source", text);
+        }
+
+        logDebug("databaseReload.log", "Reloaded attack source {:s}, immunity ai rating {:d}", text,
+                 (int)source->immunityAiRating);
+    }
+}
+
+static void applyAttackReachChanges(const utils::DbfFile& dbf, const utils::DbfChanges& changes)
+{
+    const auto textColumn{dbf.columnRef<std::string_view>("TEXT")};
+    const auto reachTxtColumn{dbf.columnRef<std::string_view>("REACH_TXT")};
+    const auto targetsTxtColumn{dbf.columnRef<std::string_view>("TARGET_TXT")};
+    const auto selectionScriptColumn{dbf.columnRef<std::string_view>("SEL_SCRIPT")};
+    const auto attackScriptColumn{dbf.columnRef<std::string_view>("ATT_SCRIPT")};
+    const auto markTargetsColumn{dbf.columnRef<bool>("MRK_TARGTS")};
+    const auto meleeColumn{dbf.columnRef<bool>("MELEE")};
+    const auto maxTargetsColumn{dbf.columnRef<int>("MAX_TARGTS")};
+
+    auto& reaches = getCustomAttacks().reaches;
+    for (const auto& text : changes.changed) {
+        auto reach = std::find_if(reaches.begin(), reaches.end(),
+                                  [&text](const CustomAttackReach& custom) {
+                                      return custom.text == text;
+                                  });
+        utils::DbfRecord record;
+        if (reach == reaches.end() || !findRecord(record, dbf, textColumn, text)) {
+            logRestartRequired(dbf.path(), "changed attack reach", text);
+            continue;
+        }
+
+        reach->selectionScript = std::string(selectionScriptColumn.get(record));
+        reach->attackScript = std::string(attackScriptColumn.get(record));
+        reach->maxTargets = (std::uint32_t)maxTargetsColumn.get(record, 1); // 1 is the default
+
+        if (reach->reachTxt != reachTxtColumn.get(record)
+            || reach->targetsTxt != targetsTxtColumn.get(record)
+            || reach->markAttackTargets != markTargetsColumn.get(record, false)
+            || reach->melee != meleeColumn.get(record, false)) {
+            logRestartRequired(dbf.path(), "changed texts or flags of attack reach", text);
+        }
+
+        logDebug("databaseReload.log",
+                 "Reloaded attack reach {:s}, selection script {:s}, "
+                 "attack script {:s}, max targets {:d}",
+                 text, reach->selectionScript, reach->attackScript, reach->maxTargets);
+    }
+}
+
+static void applyChanges(const WatchedDatabase& watched,
+                         const utils::DbfFile& dbf,
+                         const utils::DbfChanges& changes)
+{
+    if (watched.database == ReloadableDatabase::Races) {
+        // Hire lists are rebuilt as a whole, races are identified by ids so order does not matter
+        dbfCatalog().refresh(watched.path);
+        if (!loadUnitsForHire(gameFolder())) {
+            logError("mssProxyError.log",
+                     "Could not reload units for hire, previous lists are kept");
+            return;
+        }
+
+        logDebug("databaseReload.log", "Reloaded units for hire from {:s}",
+                 watched.path.filename().string());
+        return;
+    }
+
+    // New categories are registered in game tables only once, at startup
+    for (const auto& key : changes.added) {
+        logRestartRequired(watched.path, "added", key);
+    }
+
+    for (const auto& key : changes.removed) {
+        logRestartRequired(watched.path, "removed", key);
+    }
+
+    if (watched.database == ReloadableDatabase::AttackSources) {
+        applyAttackSourceChanges(dbf, changes);
+    } else {
+        applyAttackReachChanges(dbf, changes);
+    }
+}
+
+void watchDatabase(ReloadableDatabase database, const std::filesystem::path& dbfPath)
+{
+    if (!userSettings().reloadDatabases) {
+        return;
+    }
+
+    WatchedDatabase watched{database, dbfPath};
+
+    utils::DbfFile dbf;
+    if (!dbf.open(dbfPath) || !watched.snapshot.take(dbf, keyColumnName(database))) {
+        logError("mssProxyError.log",
+                 fmt::format("Could not watch {:s} for changes", dbfPath.filename().string()));
+        return;
+    }
+
+    auto& databases = watchedDatabases();
+    auto it = std::find_if(databases.begin(), databases.end(),
+                           [database](const WatchedDatabase& existing) {
+                               return existing.database == database;
+                           });
+    if (it != databases.end()) {
+        *it = std::move(watched);
+    } else {
+        databases.push_back(std::move(watched));
+    }
+}
+
+/** Returns true if online multiplayer game is played, hotseat is not considered online. */
+static bool isOnlineGame()
+{
+    const auto midgard = game::CMidgardApi::get().instance();
+    if (!midgard || !midgard->data) {
+        return false;
+    }
+
+    return midgard->data->multiplayerGame && !midgard->data->hotseatGame;
+}
+
+void reloadChangedDatabases()
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto& databases = watchedDatabases();
+    if (databases.empty()) {
+        return;
+    }
+
+    // Targeting and hire lists of each client must match in online games,
+    // changes are picked up after returning to single player or hotseat game
+    if (isOnlineGame()) {
+        return;
+    }
+
+    static Clock::time_point nextCheck{};
+    const auto now{Clock::now()};
+    if (now < nextCheck) {
+        return;
+    }
+
+    nextCheck = now + std::chrono::seconds(1);
+
+    for (auto& watched : databases) {
+        if (!watched.snapshot.isOutdated()) {
+            continue;
+        }
+
+        // File can be opened while it is still being written, it will be checked again later
+        utils::DbfFile dbf;
+        utils::DbfSnapshot snapshot;
+        if (!dbf.open(watched.path) || !snapshot.take(dbf, keyColumnName(watched.database))) {
+            continue;
+        }
+
+        // Snapshot is replaced even if changes were not applied,
+        // so broken file is reported only once and fixed one is picked up again
+        const auto changes{watched.snapshot.compare(snapshot)};
+        if (!changes.empty()) {
+            applyChanges(watched, dbf, changes);
+        }
+
+        watched.snapshot = std::move(snapshot);
+
+        using namespace std::chrono;
+        const auto elapsed{duration_cast<microseconds>(Clock::now() - now)};
+        logDebug("databaseReload.log",
+                 "{:s} reloaded in {:d} us, {:d} added, {:d} removed, {:d} changed",
+                 watched.path.filename().string(), elapsed.count(), changes.added.size(),
+                 changes.removed.size(), changes.changed.size());
+    }
+}
+
+} // namespace hooks
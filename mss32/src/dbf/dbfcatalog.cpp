@@ -0,0 +1,177 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbfcatalog.h"
+#include "log.h"
+#include "metrics.h"
+#include "tracerecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <fmt/format.h>
+#include <thread>
+
+namespace utils {
+
+using Clock = std::chrono::steady_clock;
+
+static long long microsecondsSince(const Clock::time_point& start)
+{
+    using namespace std::chrono;
+
+    return duration_cast<microseconds>(Clock::now() - start).count();
+}
+
+/** Paths are compared case insensitive, as file system does. */
+static std::string catalogKey(const std::filesystem::path& dbfPath)
+{
+    std::error_code error;
+    auto path = std::filesystem::absolute(dbfPath, error);
+    if (error) {
+        path = dbfPath;
+    }
+
+    auto key{path.lexically_normal().string()};
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+DbfCatalog::DbfCatalog(const std::filesystem::path& cacheFolder)
+    : cacheFolder{cacheFolder}
+{ }
+
+void DbfCatalog::prefetch(const std::vector<std::filesystem::path>& dbfPaths,
+                          std::uint32_t threadsTotal)
+{
+    struct Queue
+    {
+        std::vector<Entry*> entries;
+        std::atomic<std::size_t> next{0};
+    };
+
+    auto queue = std::make_shared<Queue>();
+    for (const auto& path : dbfPaths) {
+        queue->entries.push_back(&entry(path));
+    }
+
+    const auto workersTotal = std::min<std::size_t>(threadsTotal, queue->entries.size());
+    for (std::size_t i = 0; i < workersTotal; ++i) {
+        std::thread([this, queue]() {
+            for (auto index = queue->next++; index < queue->entries.size();
+                 index = queue->next++) {
+                tryLoad(*queue->entries[index], true);
+            }
+        }).detach();
+    }
+}
+
+DbfCatalog::TablePtr DbfCatalog::table(const std::filesystem::path& dbfPath)
+{
+    auto& tableEntry = entry(dbfPath);
+    if (tryLoad(tableEntry, false)) {
+        std::lock_guard<std::mutex> lock(tableEntry.mutex);
+        return tableEntry.table;
+    }
+
+    const auto start{Clock::now()};
+
+    std::unique_lock<std::mutex> lock(tableEntry.mutex);
+    if (tableEntry.state != State::Loaded) {
+        tableEntry.loaded.wait(lock, [&tableEntry]() { return tableEntry.state == State::Loaded; });
+
+        hooks::logDebug("dbfCatalog.log", "Waited for {:s} {:d} us",
+                        tableEntry.path.filename().string(), microsecondsSince(start));
+    }
+
+    return tableEntry.table;
+}
+
+void DbfCatalog::refresh(const std::filesystem::path& dbfPath)
+{
+    auto& tableEntry = entry(dbfPath);
+
+    std::lock_guard<std::mutex> lock(tableEntry.mutex);
+    // Table that is being loaded right now is fresh enough
+    if (tableEntry.state == State::Loaded) {
+        tableEntry.table.reset();
+        tableEntry.state = State::Pending;
+    }
+}
+
+DbfCatalog::Entry& DbfCatalog::entry(const std::filesystem::path& dbfPath)
+{
+    const auto key{catalogKey(dbfPath)};
+
+    std::lock_guard<std::mutex> lock(entriesMutex);
+
+    auto& tableEntry = entries[key];
+    if (!tableEntry) {
+        tableEntry = std::make_unique<Entry>();
+        tableEntry->path = dbfPath;
+    }
+
+    return *tableEntry;
+}
+
+bool DbfCatalog::tryLoad(Entry& entry, bool worker)
+{
+    {
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        if (entry.state != State::Pending) {
+            return entry.state == State::Loaded;
+        }
+
+        entry.state = State::Loading;
+    }
+
+    const auto start{Clock::now()};
+    hooks::TraceScope trace{hooks::TraceEvent::DbfLoad,
+                            hooks::traceNameIfRecording(entry.path.filename().string())};
+    hooks::MetricTimer timer{hooks::Metric::DbfLoads};
+
+    auto table = std::make_shared<DbfTable>();
+    if (!table->open(entry.path, cacheFolder)) {
+        table.reset();
+    }
+
+    trace.setPayload(table ? 1 : 0);
+
+    std::error_code error;
+    const auto fileSize{std::filesystem::file_size(entry.path, error)};
+    if (table && !error) {
+        hooks::addMetric(hooks::Metric::DbfBytesLoaded, static_cast<std::int64_t>(fileSize));
+    }
+
+    hooks::logDebug("dbfCatalog.log", "{:s} {:s} in {:d} us by {:s}",
+                    entry.path.filename().string(), table ? "loaded" : "failed to load",
+                    microsecondsSince(start), worker ? "worker" : "consumer");
+
+    {
+        std::lock_guard<std::mutex> lock(entry.mutex);
+        entry.table = std::move(table);
+        entry.state = State::Loaded;
+    }
+
+    entry.loaded.notify_all();
+    return true;
+}
+
+} // namespace utils
@@ -0,0 +1,222 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbfcolumndecoders.h"
+#include "dbffile.h"
+#include <cstdint>
+#include <limits>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define DBF_DECODERS_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace utils {
+
+#ifdef DBF_DECODERS_SSE2
+static unsigned int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+static unsigned int highestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return index;
+#else
+    return 31 - __builtin_clz(mask);
+#endif
+}
+
+/** Returns mask of bytes that are not spaces among 16 bytes starting at data. */
+static unsigned int nonSpacesMask(const char* data)
+{
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+    return ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces))) & 0xffff;
+}
+#endif
+
+/** Returns offset of the first character that is not a space, or length if there is none. */
+static std::size_t skipLeadingSpaces(const char* data, std::size_t length)
+{
+    std::size_t offset{0};
+
+#ifdef DBF_DECODERS_SSE2
+    for (; offset + 16 <= length; offset += 16) {
+        const auto mask = nonSpacesMask(data + offset);
+        if (mask) {
+            return offset + lowestBit(mask);
+        }
+    }
+#endif
+
+    while (offset < length && data[offset] == ' ') {
+        ++offset;
+    }
+
+    return offset;
+}
+
+/** Returns length of data without trailing spaces. */
+static std::size_t skipTrailingSpaces(const char* data, std::size_t length)
+{
+#ifdef DBF_DECODERS_SSE2
+    for (; length >= 16; length -= 16) {
+        const auto mask = nonSpacesMask(data + length - 16);
+        if (mask) {
+            return length - 16 + highestBit(mask) + 1;
+        }
+    }
+#endif
+
+    while (length && data[length - 1] == ' ') {
+        --length;
+    }
+
+    return length;
+}
+
+/**
+ * Parses integer the same way std::from_chars does after leading spaces are skipped:
+ * optional minus sign followed by at least one digit, parsing stops at first non-digit.
+ */
+static bool parseInt(int& result, const char* data, std::size_t length)
+{
+    std::size_t offset = skipLeadingSpaces(data, length);
+
+    const bool negative = offset < length && data[offset] == '-';
+    if (negative) {
+        ++offset;
+    }
+
+    const std::uint64_t intMax{static_cast<std::uint64_t>(std::numeric_limits<int>::max())};
+    const std::uint64_t limit = negative ? intMax + 1 : intMax;
+
+    const std::size_t digitsStart{offset};
+    std::uint64_t value{};
+    bool overflow{};
+    for (; offset < length; ++offset) {
+        const unsigned int digit = static_cast<unsigned char>(data[offset]) - '0';
+        if (digit > 9) {
+            break;
+        }
+
+        value = value * 10 + digit;
+        if (value > limit) {
+            // Keep consuming digits, out of range value is an error as a whole
+            overflow = true;
+            value = limit;
+        }
+    }
+
+    if (offset == digitsStart || overflow) {
+        return false;
+    }
+
+    result = negative ? static_cast<int>(0 - value) : static_cast<int>(value);
+    return true;
+}
+
+/** Returns pointer to the field of the first record, skipping deletion flag. */
+static const char* firstField(const DbfFile& dbf, const DbfColumn& column)
+{
+    return reinterpret_cast<const char*>(dbf.recordsBuffer()) + 1 + column.dataAddress;
+}
+
+bool decodeColumn(std::vector<std::string_view>& values,
+                  const DbfFile& dbf,
+                  const DbfColumn& column)
+{
+    if (column.type != ColumnType::Character || !dbf.recordsBuffer()) {
+        return false;
+    }
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    const std::size_t stride{dbf.recordLength()};
+    const char* field = firstField(dbf, column);
+
+    values.resize(recordsTotal);
+    for (std::uint32_t i = 0; i < recordsTotal; ++i, field += stride) {
+        const auto first = skipLeadingSpaces(field, column.length);
+        const auto last = first + skipTrailingSpaces(field + first, column.length - first);
+
+        values[i] = std::string_view(field + first, last - first);
+    }
+
+    return true;
+}
+
+bool decodeColumn(std::vector<int>& values,
+                  std::vector<bool>& parsed,
+                  const DbfFile& dbf,
+                  const DbfColumn& column)
+{
+    if (column.type != ColumnType::Number || !dbf.recordsBuffer()) {
+        return false;
+    }
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    const std::size_t stride{dbf.recordLength()};
+    const char* field = firstField(dbf, column);
+
+    values.assign(recordsTotal, 0);
+    parsed.assign(recordsTotal, false);
+    for (std::uint32_t i = 0; i < recordsTotal; ++i, field += stride) {
+        int value{};
+        if (parseInt(value, field, column.length)) {
+            values[i] = value;
+            parsed[i] = true;
+        }
+    }
+
+    return true;
+}
+
+bool decodeColumn(std::vector<bool>& values, const DbfFile& dbf, const DbfColumn& column)
+{
+    if (column.type != ColumnType::Logical || !dbf.recordsBuffer()) {
+        return false;
+    }
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    const std::size_t stride{dbf.recordLength()};
+    const char* field = firstField(dbf, column);
+
+    values.resize(recordsTotal);
+    for (std::uint32_t i = 0; i < recordsTotal; ++i, field += stride) {
+        values[i] = *field == 'T';
+    }
+
+    return true;
+}
+
+} // namespace utils
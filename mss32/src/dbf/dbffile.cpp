@@ -18,68 +18,88 @@
  */
 
 #include "dbffile.h"
+#include "dbfindex.h"
 #include <cassert>
+#include <cstring>
+#include <utility>
 
 namespace utils {
 
-bool DbfFile::open(const std::filesystem::path& file)
+bool DbfFile::open(const std::filesystem::path& file, bool writable)
 {
-    valid = false;
-
-    std::ifstream stream(file, std::ios_base::binary);
-    if (!stream.is_open()) {
+    MappedFile fileContents;
+    if (!fileContents.open(file, writable)) {
+        valid = false;
+        recordsData = nullptr;
+        filePath = file;
         return false;
     }
 
-    stream.seekg(0, stream.end);
-    const auto fileSize = stream.tellg();
-    stream.seekg(0, stream.beg);
+    return open(std::move(fileContents), file);
+}
+
+bool DbfFile::open(MappedFile&& fileContents, const std::filesystem::path& file)
+{
+    valid = false;
+    recordsData = nullptr;
+    filePath = file;
+    contents = std::move(fileContents);
+
+    const auto* data = contents.data();
+    const auto fileSize = contents.size();
 
     if (fileSize < sizeof(DbfHeader)) {
         return false;
     }
 
-    if (!readHeader(stream)) {
+    if (!readHeader(data)) {
         return false;
     }
 
-    const auto recordsDataLength = recordsTotal() * header.recordLength;
+    const std::size_t recordsDataLength = static_cast<std::size_t>(recordsTotal())
+                                          * header.recordLength;
     const auto recordsEnd = header.headerLength + recordsDataLength;
     if (recordsEnd + 1 != fileSize) {
         return false;
     }
 
-    if (!readColumns(stream)) {
+    if (!readColumns(data)) {
         return false;
     }
 
-    char endOfFields{};
-    stream.read(&endOfFields, 1);
-
-    if (endOfFields != 0xd) {
+    // Columns descriptors are followed by terminator byte
+    std::size_t offset = sizeof(DbfHeader) + columns.size() * sizeof(DbfColumn);
+    if (offset + 1 + recordsDataLength > fileSize) {
         return false;
     }
 
-    recordsData.resize(recordsDataLength);
+    if (data[offset++] != 0xd) {
+        return false;
+    }
 
     // https://en.wikipedia.org/wiki/.dbf#Database_records
     // Each record begins with a 1-byte "deletion" flag. The byte's value is a space (0x20), if the
     // record is active, or an asterisk (0x2A), if the record is deleted.
-    char firstChar{};
-    stream.read(&firstChar, 1);
+    const auto firstChar = data[offset];
     if (firstChar != 0x20 && firstChar != 0x2A) {
         // Workaround for different file formats from Sdbf/SergDBF where there is an additional
         // EOF/NUL between header and data blocks
-        stream.read(reinterpret_cast<char*>(&recordsData[0]), recordsDataLength);
-    } else {
-        recordsData[0] = firstChar;
-        stream.read(reinterpret_cast<char*>(&recordsData[1]), recordsDataLength - 1);
+        ++offset;
+        if (offset + recordsDataLength > fileSize) {
+            return false;
+        }
     }
 
+    recordsData = data + offset;
     valid = true;
     return true;
 }
 
+bool DbfFile::flush()
+{
+    return valid && contents.flush();
+}
+
 CodePage DbfFile::language() const
 {
     return header.language;
@@ -95,6 +115,11 @@ std::uint32_t DbfFile::recordsTotal() const
     return header.recordsTotal;
 }
 
+std::uint32_t DbfFile::recordLength() const
+{
+    return header.recordLength;
+}
+
 const DbfColumn* DbfFile::column(std::uint32_t index) const
 {
     return index < columns.size() ? &columns[index] : nullptr;
@@ -116,16 +141,27 @@ bool DbfFile::record(DbfRecord& result, std::uint32_t index) const
         return false;
     }
 
-    const auto* bgn = &recordsData[index * header.recordLength];
+    const auto* bgn = recordsData + static_cast<std::size_t>(index) * header.recordLength;
     bool deleted = *bgn == 0x2a;
     result = DbfRecord(this, DbfRecord::RecordData(bgn + 1, header.recordLength), deleted);
     return true;
 }
 
-bool DbfFile::readHeader(std::ifstream& stream)
+std::uint8_t* DbfFile::writableRecord(std::uint32_t index)
+{
+    auto* data = contents.writableData();
+    if (!valid || !data || index >= recordsTotal()) {
+        return nullptr;
+    }
+
+    const auto offset = static_cast<std::size_t>(recordsData - contents.data());
+    return data + offset + static_cast<std::size_t>(index) * header.recordLength;
+}
+
+bool DbfFile::readHeader(const std::uint8_t* data)
 {
     DbfHeader tmpHeader;
-    stream.read(reinterpret_cast<char*>(&tmpHeader), sizeof(tmpHeader));
+    std::memcpy(&tmpHeader, data, sizeof(tmpHeader));
 
     if (tmpHeader.version.parts.version != 0x3) {
         return false;
@@ -143,18 +179,19 @@ bool DbfFile::readHeader(std::ifstream& stream)
     return true;
 }
 
-bool DbfFile::readColumns(std::ifstream& stream)
+bool DbfFile::readColumns(const std::uint8_t* data)
 {
     const auto columnsTotal = (header.headerLength - sizeof(DbfHeader) - 1) / sizeof(DbfColumn);
     Columns tmpColumns(columnsTotal);
     ColumnIndexMap tmpIndices;
 
+    // Header length is already checked against file size, descriptors are inside file contents
+    const auto* descriptors = data + sizeof(DbfHeader);
+
     std::uint32_t index{0};
     std::uint32_t dataAddress{0};
     for (auto& column : tmpColumns) {
-        if (!readColumn(stream, column)) {
-            return false;
-        }
+        std::memcpy(&column, descriptors + index * sizeof(DbfColumn), sizeof(DbfColumn));
 
         column.dataAddress = dataAddress;
         dataAddress += column.length;
@@ -166,9 +203,28 @@ bool DbfFile::readColumns(std::ifstream& stream)
     return true;
 }
 
-bool DbfFile::readColumn(std::ifstream& stream, DbfColumn& column)
+bool DbfFile::index(DbfIndex& result, const std::string& columnName, bool persistent) const
 {
-    stream.read(reinterpret_cast<char*>(&column), sizeof(DbfColumn));
+    if (!valid) {
+        return false;
+    }
+
+    auto indexPath{filePath};
+    indexPath += "." + columnName + ".idx";
+
+    if (persistent && result.load(indexPath, filePath, columnName)) {
+        return true;
+    }
+
+    if (!result.build(*this, columnName)) {
+        return false;
+    }
+
+    if (persistent) {
+        // Index is usable even if it could not be saved
+        result.save(indexPath, filePath);
+    }
+
     return true;
 }
 
@@ -0,0 +1,244 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbfindex.h"
+#include "dbffile.h"
+#include "dbfsourcestate.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace utils {
+
+struct IndexHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+    char column[12];
+    std::uint32_t keysTotal;
+    std::uint32_t slotsTotal;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 48, "Size of IndexHeader structure must be exactly 48 bytes");
+
+static const char indexMagic[4] = {'D', 'B', 'F', 'I'};
+static const std::uint32_t indexVersion = 1;
+
+static constexpr std::size_t idLength = 10;
+
+/** SplitMix64 finalizer, spreads packed ids that differ only in last characters. */
+static std::uint64_t hashKey(std::uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+std::uint64_t DbfIndex::packId(std::string_view id)
+{
+    if (id.size() != idLength) {
+        return 0;
+    }
+
+    std::uint64_t packed{};
+    for (const char ch : id) {
+        const auto c = static_cast<unsigned char>(ch);
+
+        std::uint64_t code{};
+        if (c >= '0' && c <= '9') {
+            code = c - '0' + 1;
+        } else if (c >= 'A' && c <= 'Z') {
+            code = c - 'A' + 11;
+        } else if (c >= 'a' && c <= 'z') {
+            // Ranges are explicit since locale dependent checks accept bytes above 0x7f
+            code = c - 'a' + 11;
+        } else {
+            return 0;
+        }
+
+        // 6 bits per character, 60 bits total
+        packed = (packed << 6) | code;
+    }
+
+    return packed;
+}
+
+bool DbfIndex::build(const DbfFile& dbf, const std::string& columnName)
+{
+    slots.clear();
+    column.clear();
+    keysTotal = 0;
+
+    const auto idColumn{dbf.columnRef<std::string_view>(columnName)};
+    if (!idColumn.isValid()) {
+        return false;
+    }
+
+    const auto recordsTotal{dbf.recordsTotal()};
+
+    // Keep load factor at most 0.5 so probe sequences stay short
+    std::size_t capacity{16};
+    while (capacity < static_cast<std::size_t>(recordsTotal) * 2) {
+        capacity <<= 1;
+    }
+
+    slots.resize(capacity, Slot{});
+    column = columnName;
+
+    for (std::uint32_t i = 0; i < recordsTotal; ++i) {
+        DbfRecord record;
+        if (!dbf.record(record, i)) {
+            return false;
+        }
+
+        if (record.isDeleted()) {
+            continue;
+        }
+
+        const auto key{packId(idColumn.get(record))};
+        if (key) {
+            insert(key, i);
+        }
+    }
+
+    return true;
+}
+
+bool DbfIndex::load(const std::filesystem::path& indexPath,
+                    const std::filesystem::path& dbfPath,
+                    const std::string& columnName)
+{
+    std::uint64_t sourceSize{};
+    std::int64_t sourceTime{};
+    if (!sourceState(dbfPath, sourceSize, sourceTime)) {
+        return false;
+    }
+
+    std::ifstream stream(indexPath, std::ios_base::binary);
+    if (!stream) {
+        return false;
+    }
+
+    IndexHeader header{};
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+
+    if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) || header.version != indexVersion
+        || header.sourceSize != sourceSize || header.sourceTime != sourceTime
+        || std::strncmp(header.column, columnName.c_str(), sizeof(header.column))) {
+        return false;
+    }
+
+    // Capacity is always a power of two
+    if (!header.slotsTotal || (header.slotsTotal & (header.slotsTotal - 1))) {
+        return false;
+    }
+
+    std::vector<Slot> loaded(header.slotsTotal);
+    if (!stream.read(reinterpret_cast<char*>(loaded.data()), loaded.size() * sizeof(Slot))) {
+        return false;
+    }
+
+    // Lookups stop at empty slot, table without them is damaged
+    if (std::none_of(loaded.begin(), loaded.end(), [](const Slot& slot) { return !slot.key; })) {
+        return false;
+    }
+
+    slots.swap(loaded);
+    column = columnName;
+    keysTotal = header.keysTotal;
+    return true;
+}
+
+bool DbfIndex::save(const std::filesystem::path& indexPath,
+                    const std::filesystem::path& dbfPath) const
+{
+    if (slots.empty() || column.size() >= sizeof(IndexHeader::column)) {
+        return false;
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = indexVersion;
+    if (!sourceState(dbfPath, header.sourceSize, header.sourceTime)) {
+        return false;
+    }
+
+    std::memcpy(header.column, column.c_str(), column.size());
+    header.keysTotal = keysTotal;
+    header.slotsTotal = static_cast<std::uint32_t>(slots.size());
+
+    std::ofstream stream(indexPath, std::ios_base::binary | std::ios_base::trunc);
+    if (!stream) {
+        return false;
+    }
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(Slot));
+    return static_cast<bool>(stream);
+}
+
+std::optional<std::uint32_t> DbfIndex::find(std::string_view id) const
+{
+    const auto key{packId(id)};
+    if (!key || slots.empty()) {
+        return std::nullopt;
+    }
+
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hashKey(key) & mask;; i = (i + 1) & mask) {
+        const auto& slot = slots[i];
+        if (slot.key == key) {
+            return slot.row;
+        }
+
+        if (!slot.key) {
+            return std::nullopt;
+        }
+    }
+}
+
+bool DbfIndex::insert(std::uint64_t key, std::uint32_t row)
+{
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = hashKey(key) & mask;; i = (i + 1) & mask) {
+        auto& slot = slots[i];
+        if (slot.key == key) {
+            // Keep first record of duplicated id
+            return false;
+        }
+
+        if (!slot.key) {
+            slot.key = key;
+            slot.row = row;
+            ++keysTotal;
+            return true;
+        }
+    }
+}
+
+} // namespace utils
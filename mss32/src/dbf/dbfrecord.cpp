@@ -72,6 +72,59 @@ bool DbfRecord::value(std::string& result, const DbfColumn& column) const
     return true;
 }
 
+bool DbfRecord::value(std::string_view& result, std::uint32_t columnIndex) const
+{
+    if (!dbf) {
+        return false;
+    }
+
+    const auto column = dbf->column(columnIndex);
+    if (!column) {
+        return false;
+    }
+
+    return value(result, *column);
+}
+
+bool DbfRecord::value(std::string_view& result, const std::string& columnName) const
+{
+    if (!dbf) {
+        return false;
+    }
+
+    const auto column = dbf->column(columnName);
+    if (!column) {
+        return false;
+    }
+
+    return value(result, *column);
+}
+
+bool DbfRecord::value(std::string_view& result, const DbfColumn& column) const
+{
+    if (data.empty()) {
+        return false;
+    }
+
+    if (column.type != ColumnType::Character) {
+        return false;
+    }
+
+    const char* first = reinterpret_cast<const char*>(&data[column.dataAddress]);
+    const char* last = first + column.length;
+
+    while (first != last && *first == ' ') {
+        first++;
+    }
+
+    while (last != first && *(last - 1) == ' ') {
+        last--;
+    }
+
+    result = std::string_view(first, static_cast<std::size_t>(last - first));
+    return true;
+}
+
 bool DbfRecord::value(int& result, std::uint32_t columnIndex) const
 {
     if (!dbf) {
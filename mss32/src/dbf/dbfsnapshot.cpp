@@ -0,0 +1,109 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbfsnapshot.h"
+#include "dbffile.h"
+#include "dbfsourcestate.h"
+#include <string_view>
+
+namespace utils {
+
+bool DbfSnapshot::take(const DbfFile& dbf, const std::string& keyColumnName)
+{
+    valid = false;
+    records.clear();
+
+    if (!dbf.isValid() || !sourceState(dbf.path(), sourceSize, sourceTime)) {
+        return false;
+    }
+
+    const auto keyColumn{dbf.columnRef<std::string_view>(keyColumnName)};
+    if (!keyColumn.isValid()) {
+        return false;
+    }
+
+    const auto recordsTotal{dbf.recordsTotal()};
+    const std::size_t recordLength{dbf.recordLength()};
+    const std::uint8_t* recordData{dbf.recordsBuffer()};
+
+    std::vector<std::string> duplicates;
+    records.reserve(recordsTotal);
+    for (std::uint32_t i = 0; i < recordsTotal; ++i, recordData += recordLength) {
+        DbfRecord record;
+        if (!dbf.record(record, i) || record.isDeleted()) {
+            continue;
+        }
+
+        std::string_view key;
+        if (!keyColumn.read(key, record) || key.empty()) {
+            continue;
+        }
+
+        // Deletion flag is not hashed, it is already checked above
+        const auto hash{computeHash(recordData + 1, recordLength - 1)};
+        if (!records.emplace(std::string(key), hash).second) {
+            duplicates.emplace_back(key);
+        }
+    }
+
+    // Changes of duplicated records can not be tracked reliably
+    for (const auto& key : duplicates) {
+        records.erase(key);
+    }
+
+    sourcePath = dbf.path();
+    valid = true;
+    return true;
+}
+
+bool DbfSnapshot::isOutdated() const
+{
+    std::uint64_t size{};
+    std::int64_t time{};
+    if (!sourceState(sourcePath, size, time)) {
+        // File is missing or being replaced, check it later
+        return false;
+    }
+
+    return size != sourceSize || time != sourceTime;
+}
+
+DbfChanges DbfSnapshot::compare(const DbfSnapshot& newer) const
+{
+    DbfChanges changes;
+
+    for (const auto& [key, hash] : newer.records) {
+        const auto it = records.find(key);
+        if (it == records.end()) {
+            changes.added.push_back(key);
+        } else if (it->second != hash) {
+            changes.changed.push_back(key);
+        }
+    }
+
+    for (const auto& [key, hash] : records) {
+        if (newer.records.find(key) == newer.records.end()) {
+            changes.removed.push_back(key);
+        }
+    }
+
+    return changes;
+}
+
+} // namespace utils
@@ -0,0 +1,375 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbftable.h"
+#include "dbfcolumndecoders.h"
+#include "dbffile.h"
+#include "dbfsourcestate.h"
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace utils {
+
+struct DbfTable::CacheHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+    std::uint64_t sourceHash;
+    std::uint32_t recordsTotal;
+    std::uint32_t columnsTotal;
+    std::uint32_t stringPoolSize;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(DbfTable::CacheHeader) == 48,
+              "Size of DbfTable::CacheHeader structure must be exactly 48 bytes");
+
+struct DbfTable::CacheColumn
+{
+    char name[12]; /**< Null terminated column name. */
+    ColumnType type;
+    char padding[3];
+};
+
+static_assert(sizeof(DbfTable::CacheColumn) == 16,
+              "Size of DbfTable::CacheColumn structure must be exactly 16 bytes");
+
+static const char cacheMagic[4] = {'D', 'B', 'F', 'C'};
+static const std::uint32_t cacheVersion = 1;
+
+/** Size of deletion flags block, padded to keep cells aligned. */
+static std::size_t deletedBlockSize(std::uint32_t recordsTotal)
+{
+    return (static_cast<std::size_t>(recordsTotal) + 7) & ~std::size_t{7};
+}
+
+bool DbfTable::open(const std::filesystem::path& dbfPath, const std::filesystem::path& cacheFolder)
+{
+    header = nullptr;
+
+    CacheHeader expected{};
+    std::memcpy(expected.magic, cacheMagic, sizeof(cacheMagic));
+    expected.version = cacheVersion;
+    if (!sourceState(dbfPath, expected.sourceSize, expected.sourceTime)) {
+        return false;
+    }
+
+    std::filesystem::path cachePath;
+    if (!cacheFolder.empty()) {
+        cachePath = cacheFolder / (dbfPath.filename().string() + ".cache");
+        // Source with the same size and modification time is not read at all
+        if (load(cachePath, expected, false)) {
+            return true;
+        }
+    }
+
+    MappedFile source;
+    if (!source.open(dbfPath)) {
+        return false;
+    }
+
+    expected.sourceHash = computeHash(source.data(), source.size());
+    if (cachePath.empty()) {
+        return build(std::move(source), dbfPath, expected);
+    }
+
+    if (load(cachePath, expected, true)) {
+        // Source was touched without changes, remember its time so it is not hashed again
+        builtContents.assign(cache.data(), cache.data() + cache.size());
+        cache.close();
+
+        auto cacheHeader = reinterpret_cast<CacheHeader*>(builtContents.data());
+        cacheHeader->sourceTime = expected.sourceTime;
+        readContents(builtContents.data(), builtContents.size());
+    } else if (!build(std::move(source), dbfPath, expected)) {
+        return false;
+    }
+
+    // Failure to write the cache is not an error, table is already built
+    writeCache(cachePath);
+    return true;
+}
+
+std::uint32_t DbfTable::columnsTotal() const
+{
+    return header ? header->columnsTotal : 0;
+}
+
+std::uint32_t DbfTable::recordsTotal() const
+{
+    return header ? header->recordsTotal : 0;
+}
+
+bool DbfTable::isDeleted(std::uint32_t row) const
+{
+    return row < recordsTotal() && deleted[row] != 0;
+}
+
+bool DbfTable::hasColumn(const std::string& name) const
+{
+    for (std::uint32_t i = 0; i < columnsTotal(); ++i) {
+        if (!std::strncmp(columns[i].name, name.c_str(), sizeof(columns[i].name))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool DbfTable::load(const std::filesystem::path& cachePath,
+                    const CacheHeader& expected,
+                    bool compareHash)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(cachePath, error) || !cache.open(cachePath)) {
+        return false;
+    }
+
+    if (cache.size() < sizeof(CacheHeader)) {
+        cache.close();
+        return false;
+    }
+
+    CacheHeader cached;
+    std::memcpy(&cached, cache.data(), sizeof(cached));
+    const bool sourceMatches = compareHash ? cached.sourceHash == expected.sourceHash
+                                           : cached.sourceTime == expected.sourceTime;
+    if (std::memcmp(cached.magic, expected.magic, sizeof(cached.magic))
+        || cached.version != expected.version || cached.sourceSize != expected.sourceSize
+        || !sourceMatches) {
+        cache.close();
+        return false;
+    }
+
+    if (!readContents(cache.data(), cache.size())) {
+        cache.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool DbfTable::writeCache(const std::filesystem::path& cachePath) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+
+    // Cache is replaced only when completely written, so crashes and other game instances
+    // writing the same cache never leave truncated file
+    auto tmpPath{cachePath};
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream stream(tmpPath, std::ios_base::binary | std::ios_base::trunc);
+        stream.write(reinterpret_cast<const char*>(builtContents.data()), builtContents.size());
+        stream.close();
+
+        if (!stream) {
+            std::filesystem::remove(tmpPath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, cachePath, error);
+    if (error) {
+        // Cache can be mapped by another instance, it will be rebuilt next time
+        std::filesystem::remove(tmpPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+bool DbfTable::build(MappedFile&& source,
+                     const std::filesystem::path& dbfPath,
+                     const CacheHeader& expected)
+{
+    DbfFile dbf;
+    if (!dbf.open(std::move(source), dbfPath)) {
+        return false;
+    }
+
+    const auto recordsTotal = dbf.recordsTotal();
+    const auto columnsTotal = dbf.columnsTotal();
+
+    std::vector<CacheColumn> tableColumns(columnsTotal);
+    std::vector<std::uint8_t> tableDeleted(deletedBlockSize(recordsTotal));
+    std::vector<Cell> tableCells(static_cast<std::size_t>(columnsTotal) * recordsTotal);
+    std::string pool;
+
+    for (std::uint32_t i = 0; i < columnsTotal; ++i) {
+        const auto column = dbf.column(i);
+        auto& tableColumn = tableColumns[i];
+
+        std::memcpy(tableColumn.name, column->name, sizeof(column->name));
+        tableColumn.type = column->type;
+    }
+
+    for (std::uint32_t row = 0; row < recordsTotal; ++row) {
+        DbfRecord record;
+        if (!dbf.record(record, row)) {
+            return false;
+        }
+
+        tableDeleted[row] = record.isDeleted() ? 1 : 0;
+    }
+
+    std::vector<std::string_view> strings;
+    std::vector<int> numbers;
+    std::vector<bool> parsed;
+    std::vector<bool> logicals;
+
+    for (std::uint32_t i = 0; i < columnsTotal; ++i) {
+        const auto& column = *dbf.column(i);
+        Cell* columnCells = &tableCells[static_cast<std::size_t>(i) * recordsTotal];
+
+        switch (column.type) {
+        case ColumnType::Character:
+            if (!decodeColumn(strings, dbf, column)) {
+                return false;
+            }
+
+            for (std::uint32_t row = 0; row < recordsTotal; ++row) {
+                columnCells[row].value = static_cast<std::int32_t>(pool.size());
+                columnCells[row].length = static_cast<std::uint32_t>(strings[row].size());
+                pool.append(strings[row]);
+            }
+            break;
+
+        case ColumnType::Number:
+            if (!decodeColumn(numbers, parsed, dbf, column)) {
+                return false;
+            }
+
+            for (std::uint32_t row = 0; row < recordsTotal; ++row) {
+                columnCells[row].value = numbers[row];
+                columnCells[row].length = parsed[row] ? 1 : 0;
+            }
+            break;
+
+        case ColumnType::Logical:
+            if (!decodeColumn(logicals, dbf, column)) {
+                return false;
+            }
+
+            for (std::uint32_t row = 0; row < recordsTotal; ++row) {
+                columnCells[row].value = logicals[row] ? 1 : 0;
+                columnCells[row].length = 1;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    CacheHeader tableHeader{expected};
+    tableHeader.recordsTotal = recordsTotal;
+    tableHeader.columnsTotal = columnsTotal;
+    tableHeader.stringPoolSize = static_cast<std::uint32_t>(pool.size());
+
+    const std::size_t columnsSize = tableColumns.size() * sizeof(CacheColumn);
+    const std::size_t cellsSize = tableCells.size() * sizeof(Cell);
+
+    std::vector<std::uint8_t> contents(sizeof(CacheHeader) + columnsSize + tableDeleted.size()
+                                       + cellsSize + pool.size());
+    auto* dst = contents.data();
+
+    std::memcpy(dst, &tableHeader, sizeof(CacheHeader));
+    dst += sizeof(CacheHeader);
+    std::memcpy(dst, tableColumns.data(), columnsSize);
+    dst += columnsSize;
+    std::memcpy(dst, tableDeleted.data(), tableDeleted.size());
+    dst += tableDeleted.size();
+    std::memcpy(dst, tableCells.data(), cellsSize);
+    dst += cellsSize;
+    std::memcpy(dst, pool.data(), pool.size());
+
+    builtContents.swap(contents);
+    return readContents(builtContents.data(), builtContents.size());
+}
+
+bool DbfTable::readContents(const std::uint8_t* data, std::size_t size)
+{
+    if (size < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    auto tableHeader = reinterpret_cast<const CacheHeader*>(data);
+
+    const std::size_t columnsSize = tableHeader->columnsTotal * sizeof(CacheColumn);
+    const std::size_t deletedSize = deletedBlockSize(tableHeader->recordsTotal);
+    const std::size_t cellsSize = static_cast<std::size_t>(tableHeader->columnsTotal)
+                                  * tableHeader->recordsTotal * sizeof(Cell);
+
+    const std::size_t expectedSize = sizeof(CacheHeader) + columnsSize + deletedSize + cellsSize
+                                     + tableHeader->stringPoolSize;
+    if (size != expectedSize) {
+        return false;
+    }
+
+    const auto* src = data + sizeof(CacheHeader);
+    columns = reinterpret_cast<const CacheColumn*>(src);
+    src += columnsSize;
+    deleted = src;
+    src += deletedSize;
+    cellsData = reinterpret_cast<const Cell*>(src);
+    src += cellsSize;
+    stringPool = reinterpret_cast<const char*>(src);
+
+    header = tableHeader;
+    return true;
+}
+
+const DbfTable::CacheColumn* DbfTable::findColumn(const std::string& name, ColumnType type) const
+{
+    for (std::uint32_t i = 0; i < columnsTotal(); ++i) {
+        const auto& column = columns[i];
+        if (column.type == type && !std::strncmp(column.name, name.c_str(), sizeof(column.name))) {
+            return &column;
+        }
+    }
+
+    return nullptr;
+}
+
+const DbfTable::Cell* DbfTable::cells(const CacheColumn* column) const
+{
+    if (!column) {
+        return nullptr;
+    }
+
+    const auto index = static_cast<std::size_t>(column - columns);
+    return cellsData + index * recordsTotal();
+}
+
+std::string_view DbfTable::string(const Cell& cell) const
+{
+    if (cell.value < 0 || cell.value + cell.length > header->stringPoolSize) {
+        return {};
+    }
+
+    return std::string_view(stringPool + cell.value, cell.length);
+}
+
+} // namespace utils
@@ -0,0 +1,319 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dbfwriter.h"
+#include "dbffile.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <system_error>
+
+namespace utils {
+
+/** Records are written to the file in blocks of this size. */
+static constexpr std::size_t bufferSize = 1 << 20;
+
+static char* fieldData(std::uint8_t* record, const DbfColumn& column)
+{
+    // Skip deletion flag
+    return reinterpret_cast<char*>(record + 1 + column.dataAddress);
+}
+
+bool writeField(std::uint8_t* record, const DbfColumn& column, std::string_view value)
+{
+    if (value.size() > column.length) {
+        return false;
+    }
+
+    char* field = fieldData(record, column);
+    std::memset(field, ' ', column.length);
+
+    switch (column.type) {
+    case ColumnType::Character:
+        std::memcpy(field, value.data(), value.size());
+        return true;
+
+    case ColumnType::Number:
+        std::memcpy(field + column.length - value.size(), value.data(), value.size());
+        return true;
+
+    case ColumnType::Logical:
+        if (!value.empty()) {
+            *field = value[0];
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool writeField(std::uint8_t* record, const DbfColumn& column, const char* value)
+{
+    return writeField(record, column, std::string_view(value));
+}
+
+bool writeField(std::uint8_t* record, const DbfColumn& column, int value)
+{
+    if (column.type != ColumnType::Number) {
+        return false;
+    }
+
+    char text[16];
+    const auto [end, error] = std::to_chars(std::begin(text), std::end(text), value);
+    if (error != std::errc()) {
+        return false;
+    }
+
+    return writeField(record, column, std::string_view(text, end - text));
+}
+
+bool writeField(std::uint8_t* record, const DbfColumn& column, bool value)
+{
+    if (column.type != ColumnType::Logical) {
+        return false;
+    }
+
+    *fieldData(record, column) = value ? 'T' : 'F';
+    return true;
+}
+
+DbfWriter::~DbfWriter()
+{
+    close();
+}
+
+bool DbfWriter::open(const std::filesystem::path& file,
+                     const std::vector<DbfColumnInfo>& columnInfos,
+                     CodePage language)
+{
+    close();
+
+    std::vector<DbfColumn> columns;
+    std::size_t recordLength{1};
+    for (const auto& info : columnInfos) {
+        if (info.name.empty() || info.name.size() >= sizeof(DbfColumn::name) || !info.length
+            || (info.type == ColumnType::Logical && info.length != 1)) {
+            return false;
+        }
+
+        const auto duplicate = std::any_of(columns.begin(), columns.end(),
+                                           [&info](const DbfColumn& column) {
+                                               return info.name == column.name;
+                                           });
+        if (duplicate) {
+            return false;
+        }
+
+        DbfColumn column{};
+        std::memcpy(column.name, info.name.c_str(), info.name.size());
+        column.type = info.type;
+        column.dataAddress = static_cast<std::uint32_t>(recordLength - 1);
+        column.length = info.length;
+        column.decimalCount = info.decimalCount;
+        columns.push_back(column);
+
+        recordLength += info.length;
+    }
+
+    const std::size_t headerLength = sizeof(DbfHeader) + columns.size() * sizeof(DbfColumn) + 1;
+    if (columns.empty() || recordLength > UINT16_MAX || headerLength > UINT16_MAX) {
+        return false;
+    }
+
+    stream.open(file, std::ios_base::binary | std::ios_base::trunc);
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    const std::time_t time{std::time(nullptr)};
+    const std::tm tm = *std::localtime(&time);
+
+    header = DbfHeader{};
+    header.version.data = 0x3;
+    header.lastUpdate.year = static_cast<std::uint8_t>(tm.tm_year);
+    header.lastUpdate.month = static_cast<std::uint8_t>(tm.tm_mon + 1);
+    header.lastUpdate.day = static_cast<std::uint8_t>(tm.tm_mday);
+    header.headerLength = static_cast<std::uint16_t>(headerLength);
+    header.recordLength = static_cast<std::uint16_t>(recordLength);
+    header.language = language;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(columns.data()),
+                 columns.size() * sizeof(DbfColumn));
+    stream.put(0xd);
+
+    tableColumns.swap(columns);
+
+    // Keep whole records in buffer so record pointers stay valid until written
+    buffer.clear();
+    buffer.reserve(std::max(bufferSize, recordLength));
+    recordStarted = false;
+    return stream.good();
+}
+
+bool DbfWriter::close()
+{
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    if (recordStarted) {
+        buffer.resize(recordOffset);
+        recordStarted = false;
+    }
+
+    flushBuffer();
+    stream.put(0x1a);
+
+    stream.seekp(offsetof(DbfHeader, recordsTotal));
+    stream.write(reinterpret_cast<const char*>(&header.recordsTotal),
+                 sizeof(header.recordsTotal));
+
+    const bool result = stream.good();
+    stream.close();
+    tableColumns.clear();
+    buffer.clear();
+    buffer.shrink_to_fit();
+    return result;
+}
+
+std::uint8_t* DbfWriter::newRecord(bool deleted)
+{
+    if (!stream.is_open()) {
+        return nullptr;
+    }
+
+    if (recordStarted) {
+        buffer.resize(recordOffset);
+    }
+
+    if (buffer.size() + header.recordLength > buffer.capacity() && !flushBuffer()) {
+        return nullptr;
+    }
+
+    recordOffset = buffer.size();
+    buffer.resize(recordOffset + header.recordLength, ' ');
+    buffer[recordOffset] = deleted ? 0x2a : 0x20;
+
+    recordStarted = true;
+    return &buffer[recordOffset];
+}
+
+bool DbfWriter::writeRecord()
+{
+    if (!recordStarted || header.recordsTotal == UINT32_MAX) {
+        return false;
+    }
+
+    ++header.recordsTotal;
+    recordStarted = false;
+    return true;
+}
+
+bool DbfWriter::flushBuffer()
+{
+    stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    buffer.clear();
+    return stream.good();
+}
+
+static bool copyWithColumns(const DbfFile& dbf,
+                            const std::filesystem::path& destination,
+                            const std::vector<DbfColumnInfo>& columnInfos,
+                            const std::vector<std::string>& defaultValues)
+{
+    std::vector<DbfColumnInfo> infos;
+    for (std::uint32_t i = 0; i < dbf.columnsTotal(); ++i) {
+        const auto column = dbf.column(i);
+        const auto nameEnd = std::find(std::begin(column->name), std::end(column->name), '\0');
+        infos.push_back(DbfColumnInfo{std::string(std::begin(column->name), nameEnd),
+                                      column->type, column->length, column->decimalCount});
+    }
+
+    const auto oldColumnsTotal{infos.size()};
+    infos.insert(infos.end(), columnInfos.begin(), columnInfos.end());
+
+    DbfWriter writer;
+    if (!writer.open(destination, infos, dbf.language())) {
+        return false;
+    }
+
+    const std::size_t sourceLength{dbf.recordLength()};
+    const auto* sourceRecord = dbf.recordsBuffer();
+    for (std::uint32_t i = 0; i < dbf.recordsTotal(); ++i, sourceRecord += sourceLength) {
+        auto* record = writer.newRecord();
+        if (!record) {
+            return false;
+        }
+
+        // New columns are appended, so old fields and deletion flag keep their offsets
+        std::memcpy(record, sourceRecord, sourceLength);
+
+        for (std::size_t j = 0; j < columnInfos.size() && j < defaultValues.size(); ++j) {
+            if (!writeField(record, writer.columns()[oldColumnsTotal + j], defaultValues[j])) {
+                return false;
+            }
+        }
+
+        if (!writer.writeRecord()) {
+            return false;
+        }
+    }
+
+    return writer.close();
+}
+
+bool addColumns(const std::filesystem::path& source,
+                const std::filesystem::path& destination,
+                const std::vector<DbfColumnInfo>& columnInfos,
+                const std::vector<std::string>& defaultValues)
+{
+    // Copy is written next to destination and replaces it only when complete,
+    // so destination is left intact on errors and can be the source itself
+    auto temporary{destination};
+    temporary += ".tmp";
+
+    bool copied{};
+    {
+        DbfFile dbf;
+        if (!dbf.open(source)) {
+            return false;
+        }
+
+        copied = copyWithColumns(dbf, temporary, columnInfos, defaultValues);
+        // Source is unmapped before it is replaced, mapped files can not be replaced on Windows
+    }
+
+    std::error_code error;
+    if (copied) {
+        std::filesystem::rename(temporary, destination, error);
+        if (!error) {
+            return true;
+        }
+    }
+
+    std::filesystem::remove(temporary, error);
+    return false;
+}
+
+} // namespace utils
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mappedfile.h"
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+
+        buffer = std::move(other.buffer);
+        view = std::exchange(other.view, nullptr);
+        viewSize = std::exchange(other.viewSize, 0);
+        mapped = std::exchange(other.mapped, false);
+        writable = std::exchange(other.writable, false);
+
+        if (!mapped) {
+            // Moved vector keeps its storage, but make it explicit
+            view = buffer.empty() ? nullptr : buffer.data();
+        }
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& path, bool writable)
+{
+    close();
+
+    if (writable) {
+        return map(path, true);
+    }
+
+    return map(path, false) || read(path);
+}
+
+void MappedFile::close()
+{
+    if (mapped && view) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+#else
+        munmap(const_cast<std::uint8_t*>(view), viewSize);
+#endif
+    }
+
+    buffer.clear();
+    buffer.shrink_to_fit();
+    view = nullptr;
+    viewSize = 0;
+    mapped = false;
+    writable = false;
+}
+
+bool MappedFile::flush()
+{
+    if (!writable || !view) {
+        return false;
+    }
+
+#ifdef _WIN32
+    return FlushViewOfFile(view, 0) != FALSE;
+#else
+    return msync(const_cast<std::uint8_t*>(view), viewSize, MS_SYNC) == 0;
+#endif
+}
+
+bool MappedFile::map(const std::filesystem::path& path, bool writable)
+{
+#ifdef _WIN32
+    const DWORD access = writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+    // Share the same way streams do, so the game and DBF editors can still open the file
+    const DWORD share = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+    HANDLE file = CreateFileW(path.c_str(), access, share, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0
+        || fileSize.QuadPart > static_cast<LONGLONG>(SIZE_MAX)) {
+        // Empty files can not be mapped
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        0, 0, nullptr);
+    // View keeps mapping and file alive, handles are not needed anymore
+    CloseHandle(file);
+    if (!mapping) {
+        return false;
+    }
+
+    void* address = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!address) {
+        return false;
+    }
+
+    view = static_cast<const std::uint8_t*>(address);
+    viewSize = static_cast<std::size_t>(fileSize.QuadPart);
+    mapped = true;
+    this->writable = writable;
+    return true;
+#else
+    const int file = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (file == -1) {
+        return false;
+    }
+
+    struct stat status{};
+    if (fstat(file, &status) == -1 || status.st_size == 0) {
+        // Empty files can not be mapped
+        ::close(file);
+        return false;
+    }
+
+    const int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* address = mmap(nullptr, static_cast<std::size_t>(status.st_size), protection,
+                         writable ? MAP_SHARED : MAP_PRIVATE, file, 0);
+    // Mapping keeps file alive, descriptor is not needed anymore
+    ::close(file);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+
+    view = static_cast<const std::uint8_t*>(address);
+    viewSize = static_cast<std::size_t>(status.st_size);
+    mapped = true;
+    this->writable = writable;
+    return true;
+#endif
+}
+
+bool MappedFile::read(const std::filesystem::path& path)
+{
+    std::ifstream stream(path, std::ios_base::binary | std::ios_base::ate);
+    if (!stream.is_open()) {
+        return false;
+    }
+
+    const auto fileSize = stream.tellg();
+    if (fileSize < 0) {
+        return false;
+    }
+
+    buffer.resize(static_cast<std::size_t>(fileSize));
+    stream.seekg(0, stream.beg);
+    if (!buffer.empty() && !stream.read(reinterpret_cast<char*>(buffer.data()), fileSize)) {
+        buffer.clear();
+        return false;
+    }
+
+    view = buffer.empty() ? nullptr : buffer.data();
+    viewSize = buffer.size();
+    return true;
+}
+
+} // namespace utils
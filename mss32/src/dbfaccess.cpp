@@ -20,6 +20,7 @@
 #include "dbfaccess.h"
 #include "dbf/dbffile.h"
 #include "midgardid.h"
+#include <array>
 #include <functional>
 
 namespace utils {
@@ -91,4 +92,44 @@ bool dbRead(int& result, const DbfFile& database, size_t row, const std::string&
     return dbRead<int>(result, database, row, columnName, convertInt);
 }
 
+static bool idFromString(game::CMidgardID& id, std::string_view idString)
+{
+    // Game expects null terminated string, character fields are at most 255 bytes long
+    std::array<char, 256> buffer{};
+    idString.copy(buffer.data(), buffer.size() - 1);
+
+    const auto& idApi = game::CMidgardIDApi::get();
+    game::CMidgardID tmpId{};
+    idApi.fromString(&tmpId, buffer.data());
+    if (tmpId == game::invalidId) {
+        return false;
+    }
+
+    id = tmpId;
+    return true;
+}
+
+bool dbRead(game::CMidgardID& id,
+            const DbfRecord& record,
+            const DbfColumnRef<std::string_view>& column)
+{
+    std::string_view idString;
+    if (!column.read(idString, record)) {
+        return false;
+    }
+
+    return idFromString(id, idString);
+}
+
+bool dbRead(game::CMidgardID& id,
+            const DbfTable::Column<std::string_view>& column,
+            std::uint32_t row)
+{
+    if (!column.isValid()) {
+        return false;
+    }
+
+    return idFromString(id, column.get(row));
+}
+
 } // namespace utils
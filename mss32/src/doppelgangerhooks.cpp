@@ -26,6 +26,7 @@
 #include "globaldata.h"
 #include "immunecat.h"
 #include "log.h"
+#include "metrics.h"
 #include "midgardobjectmap.h"
 #include "midunit.h"
 #include "scripts.h"
@@ -62,6 +63,7 @@ static int getDoppelgangerTransformLevel(const game::CMidUnit* doppelganger,
         const bindings::UnitView attacker{doppelganger};
         const bindings::UnitView target{targetUnit};
 
+        MetricTimer timer{Metric::Scripts};
         return (*getLevel)(attacker, target);
     } catch (const std::exception& e) {
         showErrorMessageBox(fmt::format("Failed to run '{:s}' script.\n"
@@ -18,7 +18,8 @@
  */
 
 #include "eventconditioncathooks.h"
-#include "dbf/dbffile.h"
+#include "dbf/dbfcatalog.h"
+#include "dbfaccess.h"
 #include "log.h"
 #include "midgardid.h"
 #include "utils.h"
@@ -41,27 +42,26 @@ CustomEventConditions& customEventConditions()
     return customConditions;
 }
 
-static void readCustomCondition(const utils::DbfRecord& record, CustomEventCondition& condition)
+struct CustomEventConditionColumns
 {
-    const auto& idApi = game::CMidgardIDApi::get();
-
-    std::string info;
-    record.value(info, "INFO");
-    idApi.fromString(&condition.infoText, info.c_str());
-
-    std::string brief;
-    record.value(brief, "BRIEF");
-    idApi.fromString(&condition.brief, brief.c_str());
-
-    std::string descr;
-    record.value(descr, "DESCR");
-    idApi.fromString(&condition.description, descr.c_str());
+    utils::DbfTable::Column<std::string_view> info;
+    utils::DbfTable::Column<std::string_view> brief;
+    utils::DbfTable::Column<std::string_view> description;
+};
+
+static void readCustomCondition(const CustomEventConditionColumns& columns,
+                                std::uint32_t row,
+                                CustomEventCondition& condition)
+{
+    utils::dbRead(condition.infoText, columns.info, row);
+    utils::dbRead(condition.brief, columns.brief, row);
+    utils::dbRead(condition.description, columns.description, row);
 }
 
 static bool readCustomConditions(const std::filesystem::path& dbfFilePath)
 {
-    utils::DbfFile dbf;
-    if (!dbf.open(dbfFilePath)) {
+    const auto dbf{dbfCatalog().table(dbfFilePath)};
+    if (!dbf) {
         logError("mssProxyError.log",
                  fmt::format("Could not open {:s}", dbfFilePath.filename().string()));
         return false;
@@ -69,37 +69,32 @@ static bool readCustomConditions(const std::filesystem::path& dbfFilePath)
 
     bool customConditions{false};
 
-    const auto recordsTotal{dbf.recordsTotal()};
+    const auto textColumn{dbf->column<std::string_view>("TEXT")};
+    const CustomEventConditionColumns columns{dbf->column<std::string_view>("INFO"),
+                                              dbf->column<std::string_view>("BRIEF"),
+                                              dbf->column<std::string_view>("DESCR")};
+    const auto recordsTotal{dbf->recordsTotal()};
     for (std::uint32_t i = 0; i < recordsTotal; ++i) {
-        utils::DbfRecord record;
-        if (!dbf.record(record, i)) {
-            logError("mssProxyError.log", fmt::format("Could not read record {:d} from {:s}", i,
-                                                      dbfFilePath.filename().string()));
-            return false;
-        }
-
-        if (record.isDeleted()) {
+        if (dbf->isDeleted(i)) {
             continue;
         }
 
-        std::string categoryName;
-        record.value(categoryName, "TEXT");
-        categoryName = trimSpaces(categoryName);
+        const auto categoryName{textColumn.get(i)};
 
         if (ownResourceCategoryName == categoryName) {
-            readCustomCondition(record, customEventConditions().ownResource);
+            readCustomCondition(columns, i, customEventConditions().ownResource);
             customConditions = true;
         } else if (gameModeCategoryName == categoryName) {
-            readCustomCondition(record, customEventConditions().gameMode);
+            readCustomCondition(columns, i, customEventConditions().gameMode);
             customConditions = true;
         } else if (playerTypeCategoryName == categoryName) {
-            readCustomCondition(record, customEventConditions().playerType);
+            readCustomCondition(columns, i, customEventConditions().playerType);
             customConditions = true;
         } else if (variableCmpCategoryName == categoryName) {
-            readCustomCondition(record, customEventConditions().variableCmp);
+            readCustomCondition(columns, i, customEventConditions().variableCmp);
             customConditions = true;
         } else if (scriptCategoryName == categoryName) {
-            readCustomCondition(record, customEventConditions().script);
+            readCustomCondition(columns, i, customEventConditions().script);
             customConditions = true;
         }
     }
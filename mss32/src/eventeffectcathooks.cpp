@@ -18,7 +18,8 @@
  */
 
 #include "eventeffectcathooks.h"
-#include "dbf/dbffile.h"
+#include "dbf/dbfcatalog.h"
+#include "dbfaccess.h"
 #include "log.h"
 #include "utils.h"
 #include <fmt/format.h>
@@ -32,27 +33,26 @@ CustomEventEffects& customEventEffects()
     return customEffects;
 }
 
-static void readCustomEffect(const utils::DbfRecord& record, CustomEventEffect& effect)
+struct CustomEventEffectColumns
 {
-    const auto& idApi = game::CMidgardIDApi::get();
-
-    std::string info;
-    record.value(info, "INFO");
-    idApi.fromString(&effect.infoText, info.c_str());
-
-    std::string brief;
-    record.value(brief, "BRIEF");
-    idApi.fromString(&effect.brief, brief.c_str());
-
-    std::string descr;
-    record.value(descr, "DESCR");
-    idApi.fromString(&effect.description, descr.c_str());
+    utils::DbfTable::Column<std::string_view> info;
+    utils::DbfTable::Column<std::string_view> brief;
+    utils::DbfTable::Column<std::string_view> description;
+};
+
+static void readCustomEffect(const CustomEventEffectColumns& columns,
+                             std::uint32_t row,
+                             CustomEventEffect& effect)
+{
+    utils::dbRead(effect.infoText, columns.info, row);
+    utils::dbRead(effect.brief, columns.brief, row);
+    utils::dbRead(effect.description, columns.description, row);
 }
 
 static bool readCustomEffects(const std::filesystem::path& dbfFilePath)
 {
-    utils::DbfFile dbf;
-    if (!dbf.open(dbfFilePath)) {
+    const auto dbf{dbfCatalog().table(dbfFilePath)};
+    if (!dbf) {
         logError("mssProxyError.log",
                  fmt::format("Could not open {:s}", dbfFilePath.filename().string()));
         return false;
@@ -60,22 +60,17 @@ static bool readCustomEffects(const std::filesystem::path& dbfFilePath)
 
     bool customEffects{false};
 
-    const auto recordsTotal{dbf.recordsTotal()};
+    const auto textColumn{dbf->column<std::string_view>("TEXT")};
+    const CustomEventEffectColumns columns{dbf->column<std::string_view>("INFO"),
+                                           dbf->column<std::string_view>("BRIEF"),
+                                           dbf->column<std::string_view>("DESCR")};
+    const auto recordsTotal{dbf->recordsTotal()};
     for (std::uint32_t i = 0; i < recordsTotal; ++i) {
-        utils::DbfRecord record;
-        if (!dbf.record(record, i)) {
-            logError("mssProxyError.log", fmt::format("Could not read record {:d} from {:s}", i,
-                                                      dbfFilePath.filename().string()));
-            return false;
-        }
-
-        if (record.isDeleted()) {
+        if (dbf->isDeleted(i)) {
             continue;
         }
 
-        std::string categoryName;
-        record.value(categoryName, "TEXT");
-        categoryName = trimSpaces(categoryName);
+        const auto categoryName{textColumn.get(i)};
     }
 
     return customEffects;
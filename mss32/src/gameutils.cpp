@@ -19,6 +19,8 @@
 
 #include "gameutils.h"
 #include "game.h"
+#include "midgardobjectmap.h"
+#include "scenarioinfo.h"
 
 namespace hooks {
 
@@ -47,4 +49,21 @@ game::CMidUnitGroup* getAllyOrEnemyGroup(const game::IMidgardObjectMap* objectMa
     return fn.getStackFortRuinGroup(tmp, objectMap, &groupId);
 }
 
+int getScenarioTurn(const game::IMidgardObjectMap* objectMap)
+{
+    using namespace game;
+
+    const auto& id = CMidgardIDApi::get();
+    auto scenarioId = objectMap->vftable->getId(objectMap);
+
+    CMidgardID infoId{};
+    id.fromParts(&infoId, id.getCategory(scenarioId), id.getCategoryIndex(scenarioId),
+                 IdType::ScenarioInfo, 0);
+
+    auto info = static_cast<const CScenarioInfo*>(
+        objectMap->vftable->findScenarioObjectById(objectMap, &infoId));
+
+    return info ? info->currentTurn : -1;
+}
+
 } // namespace hooks
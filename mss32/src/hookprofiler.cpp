@@ -0,0 +1,321 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hookprofiler.h"
+#include "log.h"
+#include "tracerecorder.h"
+#include "utils.h"
+#include <Windows.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <intrin.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hooks {
+
+struct HookProfile
+{
+    void* target;
+    void* hook;
+    std::uint32_t traceName;
+    std::atomic<std::uint64_t> calls{};
+    std::atomic<std::uint64_t> totalCycles{};
+    std::atomic<std::uint64_t> maxCycles{};
+    /** Bucket N counts calls that took [2^N, 2^(N+1)) cycles. */
+    std::array<std::atomic<std::uint64_t>, 64> histogram{};
+};
+
+/** Hook call that has not returned yet. */
+struct ActiveCall
+{
+    void* returnAddress;
+    /** Stack slot of the return address, tells which call returns. */
+    std::uintptr_t returnAddressSlot;
+    HookProfile* profile;
+    std::uint64_t start;
+};
+
+// Profiles are added only from DllMain before hooks are called, deque keeps their addresses
+static std::deque<HookProfile> profiles;
+
+static constexpr std::uint32_t maxCallDepth{256};
+static thread_local ActiveCall activeCalls[maxCallDepth];
+static thread_local std::uint32_t callDepth{};
+
+/** Size of per-hook thunk: push imm32, jmp rel32. */
+static constexpr std::size_t thunkSize{10};
+static constexpr std::size_t maxThunks{2048};
+static std::uint8_t* thunks{};
+static std::size_t thunksTotal{};
+
+static void profilerExitStub();
+
+static std::uint32_t bucketIndex(std::uint64_t cycles)
+{
+    unsigned long index{};
+    const auto high = static_cast<std::uint32_t>(cycles >> 32);
+    if (high) {
+        _BitScanReverse(&index, high);
+        return index + 32;
+    }
+
+    const auto low = static_cast<std::uint32_t>(cycles);
+    return _BitScanReverse(&index, low) ? index : 0;
+}
+
+static void updateMax(std::atomic<std::uint64_t>& maximum, std::uint64_t value)
+{
+    auto current = maximum.load(std::memory_order_relaxed);
+    while (current < value
+           && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+}
+
+/**
+ * Called by thunk before the hook, replaces caller return address with exit stub
+ * so the hook returns through it. Returns hook address.
+ */
+extern "C" void* __stdcall profilerEnter(HookProfile* profile, void** returnAddressSlot)
+{
+    if (callDepth < maxCallDepth) {
+        activeCalls[callDepth++] = {*returnAddressSlot,
+                                    reinterpret_cast<std::uintptr_t>(returnAddressSlot), profile,
+                                    __rdtsc()};
+        *returnAddressSlot = reinterpret_cast<void*>(&profilerExitStub);
+
+        if (traceRecording) {
+            traceRecord(TraceEvent::Hook, TracePhase::Begin, profile->traceName,
+                        reinterpret_cast<std::uintptr_t>(profile->hook));
+        }
+    }
+
+    return profile->hook;
+}
+
+/**
+ * Called by exit stub after the hook returned, records call duration.
+ * Returns original caller return address.
+ */
+extern "C" void* __stdcall profilerExit(std::uintptr_t stackPointer)
+{
+    const auto end{__rdtsc()};
+
+    // Returning call is the outermost of active calls with return address slots below
+    // stack pointer, calls above it were abandoned by exceptions
+    auto index = callDepth;
+    while (index > 0 && activeCalls[index - 1].returnAddressSlot < stackPointer) {
+        --index;
+    }
+
+    const auto& call = activeCalls[index];
+    callDepth = index;
+
+    auto& profile = *call.profile;
+    const auto cycles{end - call.start};
+    profile.calls.fetch_add(1, std::memory_order_relaxed);
+    profile.totalCycles.fetch_add(cycles, std::memory_order_relaxed);
+    profile.histogram[bucketIndex(cycles)].fetch_add(1, std::memory_order_relaxed);
+    updateMax(profile.maxCycles, cycles);
+
+    if (traceRecording) {
+        traceRecord(TraceEvent::Hook, TracePhase::End, profile.traceName,
+                    reinterpret_cast<std::uintptr_t>(profile.hook));
+    }
+
+    return call.returnAddress;
+}
+
+/**
+ * Common part of hook thunks.
+ * Stack holds HookProfile address pushed by thunk, followed by caller return address.
+ * Registers that can pass arguments in __thiscall and __fastcall are preserved.
+ */
+static __declspec(naked) void profilerEnterStub()
+{
+    __asm {
+        push ecx
+        push edx
+        lea eax, [esp + 12]
+        push eax
+        push dword ptr [esp + 12]
+        call profilerEnter
+        pop edx
+        pop ecx
+        add esp, 4
+        jmp eax
+    }
+}
+
+/** Hook returns here, return value registers are preserved. */
+static __declspec(naked) void profilerExitStub()
+{
+    __asm {
+        push eax
+        push edx
+        lea ecx, [esp + 8]
+        push ecx
+        call profilerExit
+        mov ecx, eax
+        pop edx
+        pop eax
+        jmp ecx
+    }
+}
+
+static std::uint64_t percentile(const HookProfile& profile, std::uint64_t calls, double fraction)
+{
+    const auto threshold{static_cast<std::uint64_t>(calls * fraction)};
+
+    std::uint64_t count{};
+    for (std::uint32_t i = 0; i < profile.histogram.size(); ++i) {
+        count += profile.histogram[i].load(std::memory_order_relaxed);
+        if (count > threshold) {
+            return (std::uint64_t{2} << i) - 1;
+        }
+    }
+
+    return profile.maxCycles.load(std::memory_order_relaxed);
+}
+
+static std::string moduleOffset(void* address)
+{
+    HMODULE module{};
+    char name[MAX_PATH]{};
+    if (!GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS
+                               | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           static_cast<LPCSTR>(address), &module)
+        || !GetModuleFileName(module, name, sizeof(name))) {
+        return fmt::format("{:p}", address);
+    }
+
+    const auto offset{reinterpret_cast<std::uintptr_t>(address)
+                      - reinterpret_cast<std::uintptr_t>(module)};
+    return fmt::format("{:s}+{:#x}", std::filesystem::path(name).filename().string(), offset);
+}
+
+static void watchHotkey()
+{
+    std::thread([]() {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            if (isGameWindowActive() && (GetAsyncKeyState(VK_CONTROL) & 0x8000)
+                && (GetAsyncKeyState(VK_SHIFT) & 0x8000) && (GetAsyncKeyState('P') & 0x8000)) {
+                writeHookProfile();
+                // Do not write report again while keys are held
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        }
+    }).detach();
+}
+
+void* profileHook(void* target, void* hook)
+{
+    if (!thunks) {
+        thunks = static_cast<std::uint8_t*>(VirtualAlloc(nullptr, thunkSize * maxThunks,
+                                                         MEM_COMMIT | MEM_RESERVE,
+                                                         PAGE_EXECUTE_READWRITE));
+        if (!thunks) {
+            logError("mssProxyError.log", "Could not allocate memory for hook profiler");
+            return hook;
+        }
+
+        watchHotkey();
+    }
+
+    if (thunksTotal == maxThunks) {
+        logError("mssProxyError.log",
+                 fmt::format("Hook {:p} is not profiled, too many hooks", hook));
+        return hook;
+    }
+
+    auto& profile = profiles.emplace_back();
+    profile.target = target;
+    profile.hook = hook;
+    if (traceRecording) {
+        profile.traceName = traceName(moduleOffset(hook));
+    }
+
+    auto thunk = thunks + thunkSize * thunksTotal++;
+    const auto profileAddress{reinterpret_cast<std::uint32_t>(&profile)};
+    const auto jumpOffset{reinterpret_cast<std::uint32_t>(&profilerEnterStub)
+                          - reinterpret_cast<std::uint32_t>(thunk + thunkSize)};
+
+    thunk[0] = 0x68; // push imm32
+    std::memcpy(thunk + 1, &profileAddress, sizeof(profileAddress));
+    thunk[5] = 0xe9; // jmp rel32
+    std::memcpy(thunk + 6, &jumpOffset, sizeof(jumpOffset));
+
+    FlushInstructionCache(GetCurrentProcess(), thunk, thunkSize);
+    return thunk;
+}
+
+void writeHookProfile(bool processExit)
+{
+    static std::mutex mutex;
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+
+    if (!processExit) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return;
+    }
+
+    std::vector<const HookProfile*> sorted;
+    for (const auto& profile : profiles) {
+        if (profile.calls.load(std::memory_order_relaxed)) {
+            sorted.push_back(&profile);
+        }
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const HookProfile* a, const HookProfile* b) {
+        return a->totalCycles.load(std::memory_order_relaxed)
+               > b->totalCycles.load(std::memory_order_relaxed);
+    });
+
+    const auto path{gameFolder() / "hookProfile.log"};
+    std::ofstream file(path.c_str());
+
+    file << fmt::format("{:d} of {:d} profiled hooks were called. "
+                        "Durations are in CPU cycles and include nested hooks and original "
+                        "functions, percentiles are rounded up to a power of two.\n",
+                        sorted.size(), profiles.size());
+    file << fmt::format("{:>28s} {:>28s} {:>12s} {:>16s} {:>10s} {:>10s} {:>12s}\n", "Hook",
+                        "Target", "Calls", "Total", "p50", "p99", "Max");
+
+    for (const auto* profile : sorted) {
+        const auto calls{profile->calls.load(std::memory_order_relaxed)};
+        file << fmt::format("{:>28s} {:>28s} {:>12d} {:>16d} {:>10d} {:>10d} {:>12d}\n",
+                            moduleOffset(profile->hook), moduleOffset(profile->target), calls,
+                            profile->totalCycles.load(std::memory_order_relaxed),
+                            percentile(*profile, calls, 0.5), percentile(*profile, calls, 0.99),
+                            profile->maxCycles.load(std::memory_order_relaxed));
+    }
+}
+
+} // namespace hooks
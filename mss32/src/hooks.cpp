@@ -18,6 +18,7 @@
  */
 
 #include "hooks.h"
+#include "allocationstats.h"
 #include "attackimpl.h"
 #include "attackreachcat.h"
 #include "attackutils.h"
@@ -49,7 +50,8 @@
 #include "customattacks.h"
 #include "customattackutils.h"
 #include "d2string.h"
-#include "dbf/dbffile.h"
+#include "databasereload.h"
+#include "dbf/dbfcatalog.h"
 #include "dbtable.h"
 #include "dialoginterf.h"
 #include "difficultylevel.h"
@@ -77,6 +79,7 @@
 #include "mapgen.h"
 #include "mempool.h"
 #include "menunewskirmishsingle.h"
+#include "metrics.h"
 #include "middatacache.h"
 #include "midevconditionhooks.h"
 #include "mideveffecthooks.h"
@@ -782,6 +785,8 @@ bool __stdcall addPlayerUnitsToHireListHooked(game::CMidDataCache2* dataCache,
 {
     using namespace game;
 
+    reloadChangedDatabases();
+
     const auto& list = IdListApi::get();
     list.clear(hireList);
 
@@ -865,7 +870,6 @@ void __stdcall createBuildingTypeHooked(const game::CDBTable* dbTable,
     auto& db = CDBTableApi::get();
     db.findBuildingCategory(&category, dbTable, "CATEGORY", buildings);
 
-    auto memAlloc = Memory::get().allocate;
     auto constructor = TBuildingTypeApi::get().constructor;
     TBuildingType* buildingType = nullptr;
 
@@ -874,8 +878,7 @@ void __stdcall createBuildingTypeHooked(const game::CDBTable* dbTable,
         || (customCategoryExists && (category.id == custom.id))) {
         // This is TBuildingUnitUpgType constructor
         // without TBuildingTypeData::category validity check
-        TBuildingUnitUpgType* unitBuilding = (TBuildingUnitUpgType*)memAlloc(
-            sizeof(TBuildingUnitUpgType));
+        auto unitBuilding = allocateTracked<TBuildingUnitUpgType>(AllocationTag::Buildings);
 
         constructor(unitBuilding, dbTable, globalData);
         unitBuilding->branch.vftable = UnitBranchCategories::vftable();
@@ -887,8 +890,8 @@ void __stdcall createBuildingTypeHooked(const game::CDBTable* dbTable,
 
         buildingType = unitBuilding;
     } else {
-        buildingType = constructor((TBuildingType*)memAlloc(sizeof(TBuildingType)), dbTable,
-                                   globalData);
+        buildingType = constructor(allocateTracked<TBuildingType>(AllocationTag::Buildings),
+                                   dbTable, globalData);
     }
 
     if (!gameFunctions().addObjectAndCheckDuplicates(a2, buildingType)) {
@@ -907,19 +910,13 @@ game::LBuildingCategoryTable* __fastcall buildingCategoryTableCtorHooked(
     logDebug("newBuildingType.log", "Hook started");
 
     {
-        utils::DbfFile dbf;
         std::filesystem::path globals{globalsFolderPath};
-        if (!dbf.open(globals / dbfFileName)) {
+        const auto dbf{dbfCatalog().table(globals / dbfFileName)};
+        if (!dbf) {
             logError("mssProxyError.log", fmt::format("Could not open {:s}", dbfFileName));
-        } else {
-            utils::DbfRecord record;
-            if (dbf.recordsTotal() > 4 && dbf.record(record, 4)) {
-                std::string categoryName;
-                if (record.value(categoryName, "TEXT") && trimSpaces(categoryName) == "L_CUSTOM") {
-                    customCategoryExists = true;
-                    logDebug("newBuildingType.log", "Found custom building category");
-                }
-            }
+        } else if (dbf->column<std::string_view>("TEXT").get(4) == "L_CUSTOM") {
+            customCategoryExists = true;
+            logDebug("newBuildingType.log", "Found custom building category");
         }
     }
 
@@ -958,8 +955,7 @@ game::CBuildingBranch* __fastcall buildingBranchCtorHooked(game::CBuildingBranch
 
     logDebug("newBuildingType.log", "CBuildingBranchCtor hook started");
 
-    auto memAlloc = Memory::get().allocate;
-    CBuildingBranchData* data = (CBuildingBranchData*)memAlloc(sizeof(CBuildingBranchData));
+    auto data = allocateTracked<CBuildingBranchData>(AllocationTag::Buildings);
 
     const auto& buildingBranch = CBuildingBranchApi::get();
     buildingBranch.initData(data);
@@ -1494,6 +1490,10 @@ void __stdcall beforeAttackHooked(game::BattleMsgData* battleMsgData,
 {
     using namespace game;
 
+    // Custom attack tables are not in use between attacks
+    reloadChangedDatabases();
+    updateMetricsTurn(objectMap);
+
     const auto& battle = BattleMsgDataApi::get();
     battle.setUnitStatus(battleMsgData, unitId, BattleStatus::Defend, false);
 
@@ -1507,8 +1507,10 @@ void __stdcall beforeAttackHooked(game::BattleMsgData* battleMsgData,
     battle.setAttackPowerReduction(battleMsgData, unitId, 0);
 
     auto& customDamageRatio = getCustomAttacks().damageRatio;
-    if (customDamageRatio.enabled)
+    if (customDamageRatio.enabled) {
         customDamageRatio.ratios.clear();
+        setMetric(Metric::CustomDamageRatios, 0);
+    }
 
     auto& customTransformSelf = getCustomAttacks().transformSelf;
     if (customTransformSelf.freeAttackUnitId != *unitId)
@@ -1517,6 +1519,8 @@ void __stdcall beforeAttackHooked(game::BattleMsgData* battleMsgData,
 
 void __stdcall throwExceptionHooked(const game::os_exception* thisptr, const void* throwInfo)
 {
+    flushLogs();
+
     if (thisptr && thisptr->message) {
         showErrorMessageBox(fmt::format("Caught exception '{:s}'.\n"
                                         "The {:s} will probably crash now.",
@@ -18,6 +18,7 @@
  */
 
 #include "itemtransferhooks.h"
+#include "allocationstats.h"
 #include "button.h"
 #include "citystackinterf.h"
 #include "dialoginterf.h"
@@ -969,8 +970,7 @@ void __fastcall merchantSellValuables(game::CSiteMerchantInterf* thisptr, int /*
                               priceText);
     }
 
-    auto memAlloc = Memory::get().allocate;
-    auto handler = (SellItemsMsgBoxHandler*)memAlloc(sizeof(SellItemsMsgBoxHandler));
+    auto handler = allocateTracked<SellItemsMsgBoxHandler>(AllocationTag::MessageBoxes);
     handler->vftable = &sellValuablesMsgBoxHandlerVftable;
     handler->merchantInterf = thisptr;
     hooks::showMessageBox(message, handler, true);
@@ -999,8 +999,7 @@ void __fastcall merchantSellAll(game::CSiteMerchantInterf* thisptr, int /*%edx*/
         message = fmt::format("Do you want to sell all items? Revenue will be:\n{:s}", priceText);
     }
 
-    auto memAlloc = Memory::get().allocate;
-    auto handler = (SellItemsMsgBoxHandler*)memAlloc(sizeof(SellItemsMsgBoxHandler));
+    auto handler = allocateTracked<SellItemsMsgBoxHandler>(AllocationTag::MessageBoxes);
     handler->vftable = &sellAllItemsMsgBoxHandlerVftable;
     handler->merchantInterf = thisptr;
     hooks::showMessageBox(message, handler, true);
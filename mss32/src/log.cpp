@@ -20,36 +20,284 @@
 #include "log.h"
 #include "settings.h"
 #include "utils.h"
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
 
 namespace hooks {
 
-static void logAction(const std::string& logFile, const std::string& message)
+struct LogMessage
 {
-    using namespace std::chrono;
+    std::string logFile;
+    std::string text;
+    std::time_t time;
+};
 
-    const auto path{hooks::gameFolder() / logFile};
+/**
+ * Bounded multi-producer queue of log messages with a single consumer.
+ * Each slot has a sequence number that tells whether it is free for producer
+ * with the same position or holds a message for consumer, so producers only
+ * compete for the enqueue position and never wait for each other.
+ */
+class LogQueue
+{
+public:
+    explicit LogQueue(std::size_t capacity)
+        : slots{std::make_unique<Slot[]>(capacity)}
+        , mask{capacity - 1}
+    {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns false if queue is full. */
+    bool push(LogMessage& message)
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = slots[position & mask];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1,
+                                                          std::memory_order_relaxed)) {
+                    slot.message = std::move(message);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Must be called by one thread at a time. */
+    bool pop(LogMessage& message)
+    {
+        const auto position = dequeuePosition.load(std::memory_order_relaxed);
+        auto& slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+
+        message = std::move(slot.message);
+        slot.sequence.store(position + mask + 1, std::memory_order_release);
+        dequeuePosition.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** Returns approximate number of queued messages. */
+    std::size_t size() const
+    {
+        return enqueuePosition.load(std::memory_order_relaxed)
+               - dequeuePosition.load(std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence;
+        LogMessage message;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    const std::size_t mask;
+    std::atomic<std::size_t> enqueuePosition{0};
+    std::atomic<std::size_t> dequeuePosition{0};
+};
+
+/**
+ * Queues messages and writes them to files on a background thread,
+ * keeping log files open and flushing them once per batch.
+ * Writer thread does not start until DllMain returns,
+ * messages logged before that are written by the first flush() call or by the writer.
+ */
+class Logger
+{
+public:
+    Logger()
+        : queue{queueCapacity}
+        , folder{gameFolder()}
+    {
+        std::thread([this]() { run(); }).detach();
+    }
+
+    void log(std::string_view logFile, std::string_view message)
+    {
+        LogMessage queued{std::string(logFile), std::string(message), std::time(nullptr)};
+        if (!queue.push(queued)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (queue.size() >= queue.capacity() / 2) {
+            wakeUp.notify_one();
+        }
+    }
+
+    /**
+     * Writes queued messages on the calling thread.
+     * Waits a bit if writer thread is busy with them: on exit it could be already terminated
+     * while writing, so it is not waited forever.
+     */
+    void flush()
+    {
+        const auto deadline{std::chrono::steady_clock::now() + flushTimeout};
+        while (writing.test_and_set(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return;
+            }
+
+            std::this_thread::yield();
+        }
+
+        write();
+        writing.clear(std::memory_order_release);
+    }
+
+private:
+    static constexpr std::size_t queueCapacity{8192};
+    static constexpr std::chrono::milliseconds writeInterval{50};
+    static constexpr std::chrono::milliseconds flushTimeout{100};
 
-    std::ofstream file(path.c_str(), std::ios_base::app);
-    const std::time_t time{std::time(nullptr)};
-    const std::tm tm = *std::localtime(&time);
+    void run()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(wakeUpMutex);
+                wakeUp.wait_for(lock, writeInterval);
+            }
 
-    file << "[" << std::put_time(&tm, "%c") << "] " << message << "\n";
+            if (!writing.test_and_set(std::memory_order_acquire)) {
+                write();
+                writing.clear(std::memory_order_release);
+            }
+        }
+    }
+
+    void write()
+    {
+        LogMessage message;
+        while (queue.pop(message)) {
+            auto& file = openFile(message.logFile);
+            file << '[' << timestamp(message.time) << "] " << message.text << '\n';
+        }
+
+        const auto droppedTotal = dropped.load(std::memory_order_relaxed);
+        if (droppedTotal != droppedReported) {
+            openFile("mssProxyError.log")
+                << '[' << timestamp(std::time(nullptr)) << "] Log queue was full, "
+                << droppedTotal - droppedReported << " messages were dropped\n";
+            droppedReported = droppedTotal;
+        }
+
+        for (auto& [name, file] : files) {
+            file.flush();
+        }
+    }
+
+    std::ofstream& openFile(const std::string& logFile)
+    {
+        auto it = files.find(logFile);
+        if (it == files.end()) {
+            const auto path{folder / logFile};
+            it = files.emplace(logFile, std::ofstream(path.c_str(), std::ios_base::app)).first;
+        }
+
+        return it->second;
+    }
+
+    /** Formatting time is slow, messages of the same second share timestamp. */
+    const std::string& timestamp(std::time_t time)
+    {
+        if (time != cachedTime) {
+            const std::tm tm = *std::localtime(&time);
+
+            std::ostringstream stream;
+            stream << std::put_time(&tm, "%c");
+            cachedTimestamp = stream.str();
+            cachedTime = time;
+        }
+
+        return cachedTimestamp;
+    }
+
+    LogQueue queue;
+    std::atomic<std::size_t> dropped{0};
+    std::mutex wakeUpMutex;
+    std::condition_variable wakeUp;
+
+    // Accessed only by the thread that sets writing flag
+    std::atomic_flag writing = ATOMIC_FLAG_INIT;
+    const std::filesystem::path folder;
+    std::unordered_map<std::string, std::ofstream> files;
+    std::size_t droppedReported{};
+    std::time_t cachedTime{-1};
+    std::string cachedTimestamp;
+};
+
+/** Set once logger is created by the first logged message. */
+static std::atomic<Logger*> loggerInstance{nullptr};
+
+static Logger& logger()
+{
+    auto instance = loggerInstance.load(std::memory_order_acquire);
+    if (instance) {
+        return *instance;
+    }
+
+    static std::once_flag created;
+    std::call_once(created, []() {
+        // Never destroyed: writer thread is detached and can outlive static destructors
+        loggerInstance.store(new Logger(), std::memory_order_release);
+    });
+
+    return *loggerInstance.load(std::memory_order_acquire);
 }
 
-void logDebug(const std::string& logFile, const std::string& message)
+bool debugLogEnabled()
 {
-    if (userSettings().debugMode) {
-        logAction(logFile, message);
+    return userSettings().debugMode;
+}
+
+void logDebug(std::string_view logFile, std::string_view message)
+{
+    if (debugLogEnabled()) {
+        logger().log(logFile, message);
     }
 }
 
-void logError(const std::string& logFile, const std::string& message)
+void logError(std::string_view logFile, std::string_view message)
+{
+    // Errors often precede message boxes and failures, write them right away
+    auto& instance = logger();
+    instance.log(logFile, message);
+    instance.flush();
+}
+
+void flushLogs()
 {
-    logAction(logFile, message);
+    // Called on process detach, creating logger there would start a thread under loader lock
+    auto instance = loggerInstance.load(std::memory_order_acquire);
+    if (instance) {
+        instance->flush();
+    }
 }
 
 } // namespace hooks
@@ -0,0 +1,103 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "luagctelemetry.h"
+#include "log.h"
+#include "settings.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <lua.hpp>
+
+namespace hooks {
+
+static std::size_t getHeapSize(lua_State* lua)
+{
+    return static_cast<std::size_t>(lua_gc(lua, LUA_GCCOUNT)) * 1024
+           + static_cast<std::size_t>(lua_gc(lua, LUA_GCCOUNTB));
+}
+
+LuaGcTelemetry::LuaGcTelemetry(const char* category)
+    : category(category)
+{ }
+
+void LuaGcTelemetry::attach(lua_State* lua)
+{
+    if (userSettings().debugMode) {
+        createSentinel(lua);
+    }
+}
+
+void LuaGcTelemetry::callStarted(lua_State*)
+{
+    callStart = Clock::now();
+    cyclesAtCallStart = cycles;
+}
+
+void LuaGcTelemetry::callFinished(lua_State* lua)
+{
+    if (!userSettings().debugMode) {
+        return;
+    }
+
+    ++calls;
+    const auto heapSize = getHeapSize(lua);
+    peakHeapSize = std::max(peakHeapSize, heapSize);
+
+    if (cycles == cyclesAtCallStart) {
+        return;
+    }
+
+    // Collector work is interleaved with script execution,
+    // so the whole call is accounted as an upper bound of the pause
+    using namespace std::chrono;
+    const auto callTimeUs = duration_cast<microseconds>(Clock::now() - callStart).count();
+
+    ++callsWithCollection;
+    collectionCallsTimeUs += callTimeUs;
+    maxCollectionCallTimeUs = std::max<std::int64_t>(maxCollectionCallTimeUs, callTimeUs);
+
+    logDebug("luaGc.log",
+             "{:s}: cycles {:d}, heap {:d} KB, peak heap {:d} KB, "
+             "calls {:d}, calls with collection {:d}, "
+             "collection call time {:d} us, total {:d} us, max {:d} us",
+             category, cycles, heapSize / 1024, peakHeapSize / 1024, calls, callsWithCollection,
+             callTimeUs, collectionCallsTimeUs, maxCollectionCallTimeUs);
+}
+
+int LuaGcTelemetry::sentinelFinalizer(lua_State* lua)
+{
+    auto telemetry = static_cast<LuaGcTelemetry*>(lua_touserdata(lua, lua_upvalueindex(1)));
+    ++telemetry->cycles;
+    telemetry->createSentinel(lua);
+    return 0;
+}
+
+void LuaGcTelemetry::createSentinel(lua_State* lua)
+{
+    lua_newtable(lua);
+    lua_newtable(lua);
+    lua_pushlightuserdata(lua, this);
+    lua_pushcclosure(lua, &LuaGcTelemetry::sentinelFinalizer, 1);
+    lua_setfield(lua, -2, "__gc");
+    lua_setmetatable(lua, -2);
+    // Leave the sentinel unreferenced so the next cycle collects it
+    lua_pop(lua, 1);
+}
+
+} // namespace hooks
@@ -19,23 +19,39 @@
 
 #pragma comment(lib, "detours.lib")
 
+#include "allocationstats.h"
+#include "battlecapture.h"
 #include "customattackutils.h"
+#include "databasereload.h"
+#include "dbf/dbfcatalog.h"
+#include "hookprofiler.h"
 #include "hooks.h"
 #include "log.h"
+#include "metrics.h"
 #include "restrictions.h"
+#include "scripts.h"
 #include "settings.h"
+#include "textids.h"
+#include "tracerecorder.h"
 #include "unitsforhire.h"
 #include "utils.h"
 #include "version.h"
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <algorithm>
+#include <chrono>
 #include <detours.h>
 #include <fmt/format.h>
 #include <string>
+#include <thread>
+#include <vector>
 
 static HMODULE library{};
 static void* registerInterface{};
 static void* unregisterInterface{};
+static LPTOP_LEVEL_EXCEPTION_FILTER previousExceptionFilter{};
+/** Read on attach, settings are not accessed under loader lock on detach. */
+static bool writeHookProfileOnExit{};
 
 extern "C" __declspec(naked) void __stdcall RIB_register_interface(void)
 {
@@ -54,15 +70,7 @@ extern "C" __declspec(naked) void __stdcall RIB_unregister_interface(void)
 template <typename T>
 static void writeProtectedMemory(T* address, T value)
 {
-    DWORD oldProtection{};
-    if (VirtualProtect(address, sizeof(T), PAGE_EXECUTE_READWRITE, &oldProtection)) {
-        *address = value;
-        VirtualProtect(address, sizeof(T), oldProtection, &oldProtection);
-        return;
-    }
-
-    hooks::logError("mssProxyError.log",
-                    fmt::format("Failed to change memory protection for {:p}", (void*)address));
+    hooks::writeProtectedMemory(address, &value, sizeof(T));
 }
 
 template <typename T>
@@ -71,7 +79,7 @@ static void adjustRestrictionMax(game::Restriction<T>* restriction,
                                  const char* name)
 {
     if (value >= restriction->min) {
-        hooks::logDebug("restrictions.log", fmt::format("Set '{:s}' to {:d}", name, value));
+        hooks::logDebug("restrictions.log", "Set '{:s}' to {:d}", name, value);
         writeProtectedMemory(&restriction->max, value);
         return;
     }
@@ -111,26 +119,35 @@ static void adjustGameRestrictions()
 
     if (executableIsGame()) {
         if (userSettings().criticalHitDamage != baseSettings().criticalHitDamage) {
-            logDebug("restrictions.log", fmt::format("Set 'criticalHitDamage' to {:d}",
-                                                     (int)userSettings().criticalHitDamage));
+            logDebug("restrictions.log", "Set 'criticalHitDamage' to {:d}",
+                     (int)userSettings().criticalHitDamage);
             writeProtectedMemory(restrictions.criticalHitDamage, userSettings().criticalHitDamage);
         }
 
         if (userSettings().mageLeaderAttackPowerReduction
             != baseSettings().mageLeaderAttackPowerReduction) {
-            logDebug("restrictions.log",
-                     fmt::format("Set 'mageLeaderPowerReduction' to {:d}",
-                                 (int)userSettings().mageLeaderAttackPowerReduction));
+            logDebug("restrictions.log", "Set 'mageLeaderPowerReduction' to {:d}",
+                     (int)userSettings().mageLeaderAttackPowerReduction);
             writeProtectedMemory(restrictions.mageLeaderAttackPowerReduction,
                                  userSettings().mageLeaderAttackPowerReduction);
         }
     }
 }
 
+/** Hooks are wrapped by profiler thunks only if their calls are measured or traced. */
+static bool profileHooks()
+{
+    return hooks::userSettings().profileHooks || hooks::userSettings().recordTrace;
+}
+
 static bool setupHook(hooks::HookInfo& hook)
 {
-    hooks::logDebug("mss32Proxy.log", fmt::format("Try to attach hook. Function {:p}, hook {:p}.",
-                                                  hook.target, hook.hook));
+    if (profileHooks()) {
+        hook.hook = hooks::profileHook(hook.target, hook.hook);
+    }
+
+    hooks::logDebug("mss32Proxy.log", "Try to attach hook. Function {:p}, hook {:p}.", hook.target,
+                    hook.hook);
 
     // hook.original is an optional field that can point to where the new address of the original
     // function should be placed.
@@ -154,6 +171,14 @@ static bool setupHook(hooks::HookInfo& hook)
 static bool setupHooks()
 {
     auto hooks{hooks::getHooks()};
+    if (hooks.overflowed()) {
+        const std::string msg{fmt::format("Too many hooks, only {:d} are supported.",
+                                          hooks::Hooks::capacity)};
+
+        hooks::logError("mssProxyError.log", msg);
+        MessageBox(NULL, msg.c_str(), "mss32.dll proxy", MB_OK);
+        return false;
+    }
 
     DetourTransactionBegin();
     DetourUpdateThread(GetCurrentThread());
@@ -178,22 +203,152 @@ static bool setupHooks()
     return true;
 }
 
-static void setupVftableHooks()
+static void prefetchDatabases()
 {
-    for (const auto& hook : hooks::getVftableHooks()) {
+    const auto globalsFolder{hooks::gameFolder() / "globals"};
+
+    // Databases read by the proxy itself, during DllMain and in hooked table constructors
+    std::vector<std::filesystem::path> databases{globalsFolder / "Gattacks.dbf",
+                                                 globalsFolder / "LAttC.dbf",
+                                                 globalsFolder / "LAttS.dbf",
+                                                 globalsFolder / "LAttR.dbf",
+                                                 globalsFolder / "LBuild.dbf",
+                                                 globalsFolder / "LEvCond.dbf",
+                                                 globalsFolder / "LEvEffct.dbf"};
+
+    if (hooks::executableIsGame()) {
+        databases.push_back(globalsFolder / "Grace.dbf");
+    }
+
+    const std::uint32_t threadsTotal{std::clamp(std::thread::hardware_concurrency(), 1u, 4u)};
+    hooks::dbfCatalog().prefetch(databases, threadsTotal);
+}
+
+/**
+ * Starts initialization that does not touch the game on a background thread.
+ * Thread starts running only after DllMain returns, while the game loads its own data.
+ * Its results are guarded, consumer that needs them earlier waits or does the work itself.
+ */
+static void startBackgroundInitialization()
+{
+    std::thread([]() {
+        using namespace std::chrono;
+        const auto start{steady_clock::now()};
+
+        hooks::textIds();
+
+        if (hooks::executableIsGame()) {
+            const auto& scriptsFolder{hooks::scriptsFolder()};
+            std::vector<std::filesystem::path> scripts{scriptsFolder / "doppelganger.lua",
+                                                       scriptsFolder / "summon.lua",
+                                                       scriptsFolder / "transformSelf.lua"};
+
+            // Targeting scripts of custom attack reaches
+            const auto reaches{hooks::dbfCatalog().table(hooks::gameFolder() / "globals"
+                                                         / "LAttR.dbf")};
+            if (reaches) {
+                const auto selectionScript{reaches->column<std::string_view>("SEL_SCRIPT")};
+                const auto attackScript{reaches->column<std::string_view>("ATT_SCRIPT")};
+
+                for (std::uint32_t i = 0; i < reaches->recordsTotal(); ++i) {
+                    if (reaches->isDeleted(i)) {
+                        continue;
+                    }
+
+                    for (const auto& column : {selectionScript, attackScript}) {
+                        const auto script{column.get(i)};
+                        if (!script.empty()) {
+                            scripts.push_back(scriptsFolder / std::string(script));
+                        }
+                    }
+                }
+            }
+
+            std::sort(scripts.begin(), scripts.end());
+            scripts.erase(std::unique(scripts.begin(), scripts.end()), scripts.end());
+            hooks::preloadScriptFiles(scripts);
+        }
+
+        hooks::logDebug("mss32Proxy.log", "Background initialization finished in {:d} us",
+                        duration_cast<microseconds>(steady_clock::now() - start).count());
+    }).detach();
+}
+
+/** Logs duration of startup phase when it goes out of scope. */
+class StartupPhase
+{
+public:
+    explicit StartupPhase(const char* name)
+        : name{name}
+        , start{std::chrono::steady_clock::now()}
+    { }
+
+    ~StartupPhase()
+    {
+        using namespace std::chrono;
+        hooks::logDebug("mss32Proxy.log", "Startup phase '{:s}' finished in {:d} us", name,
+                        duration_cast<microseconds>(steady_clock::now() - start).count());
+    }
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+static bool setupVftableHooks()
+{
+    const bool profile{profileHooks()};
+
+    const auto hooks{hooks::getVftableHooks()};
+    if (hooks.overflowed()) {
+        // Partially hooked vftables are worse than refusing to start
+        const std::string msg{fmt::format("Too many vftable hooks, only {:d} are supported.",
+                                          hooks::Hooks::capacity)};
+
+        hooks::logError("mssProxyError.log", msg);
+        MessageBox(NULL, msg.c_str(), "mss32.dll proxy", MB_OK);
+        return false;
+    }
+
+    for (const auto& hook : hooks) {
         void** target = (void**)hook.target;
         if (hook.original)
             *hook.original = *target;
 
-        writeProtectedMemory(target, hook.hook);
+        void* hookFunction = profile ? hooks::profileHook(hook.target, hook.hook) : hook.hook;
+        writeProtectedMemory(target, hookFunction);
     }
 
     hooks::logDebug("mss32Proxy.log", "All vftable hooks are set");
+    return true;
+}
+
+/** Writes queued log messages before the game process is terminated. */
+static LONG WINAPI unhandledExceptionFilter(EXCEPTION_POINTERS* exceptionInfo)
+{
+    hooks::flushLogs();
+
+    if (previousExceptionFilter) {
+        return previousExceptionFilter(exceptionInfo);
+    }
+
+    return EXCEPTION_CONTINUE_SEARCH;
 }
 
 BOOL APIENTRY DllMain(HMODULE hDll, DWORD reason, LPVOID reserved)
 {
     if (reason == DLL_PROCESS_DETACH) {
+        // Reserved is set when the process terminates
+        const bool processExit{reserved != NULL};
+        if (writeHookProfileOnExit) {
+            hooks::writeHookProfile(processExit);
+        }
+
+        hooks::writeTrace(processExit);
+        hooks::flushMetrics();
+        hooks::reportAllocationLeaks();
+
+        hooks::flushLogs();
         FreeLibrary(library);
         return TRUE;
     }
@@ -215,9 +370,24 @@ BOOL APIENTRY DllMain(HMODULE hDll, DWORD reason, LPVOID reserved)
         return FALSE;
     }
 
+    const auto start{std::chrono::steady_clock::now()};
+
     DisableThreadLibraryCalls(hDll);
 
-    const auto error = hooks::determineGameVersion(hooks::exePath());
+    previousExceptionFilter = SetUnhandledExceptionFilter(unhandledExceptionFilter);
+
+    {
+        // Settings are needed right away, phases below log through them
+        StartupPhase phase{"userSettings"};
+        writeHookProfileOnExit = hooks::userSettings().profileHooks;
+    }
+
+    std::error_code error;
+    {
+        StartupPhase phase{"determineGameVersion"};
+        error = hooks::determineGameVersion(hooks::exePath());
+    }
+
     if (error || hooks::gameVersion() == hooks::GameVersion::Unknown) {
         const std::string msg{
             fmt::format("Failed to determine target exe type.\nReason: {:s}.", error.message())};
@@ -227,15 +397,61 @@ BOOL APIENTRY DllMain(HMODULE hDll, DWORD reason, LPVOID reserved)
         return FALSE;
     }
 
-    if (hooks::executableIsGame() && !hooks::loadUnitsForHire(hooks::gameFolder())) {
-        MessageBox(NULL, "Failed to load new units. Check error log for details.",
-                   "mss32.dll proxy", MB_OK);
-        return FALSE;
+    if (hooks::userSettings().recordTrace) {
+        hooks::startTraceRecording();
     }
 
-    hooks::initializeAttackDamageRatio();
+    if (hooks::userSettings().captureBattles) {
+        hooks::startBattleCapture();
+    }
+
+    {
+        StartupPhase phase{"prefetchDatabases"};
+        prefetchDatabases();
+    }
+
+    startBackgroundInitialization();
+
+    if (hooks::executableIsGame()) {
+        StartupPhase phase{"loadUnitsForHire"};
+        if (!hooks::loadUnitsForHire(hooks::gameFolder())) {
+            MessageBox(NULL, "Failed to load new units. Check error log for details.",
+                       "mss32.dll proxy", MB_OK);
+            return FALSE;
+        }
+
+        // Hire list hooks are installed only if there are new units at startup
+        if (!hooks::unitsForHire().empty()) {
+            hooks::watchDatabase(hooks::ReloadableDatabase::Races,
+                                 hooks::gameFolder() / "globals" / "Grace.dbf");
+        }
+    }
+
+    {
+        StartupPhase phase{"initializeAttackDamageRatio"};
+        hooks::initializeAttackDamageRatio();
+    }
+
+    {
+        StartupPhase phase{"adjustGameRestrictions"};
+        adjustGameRestrictions();
+    }
+
+    {
+        StartupPhase phase{"setupVftableHooks"};
+        if (!setupVftableHooks()) {
+            return FALSE;
+        }
+    }
+
+    bool result{};
+    {
+        StartupPhase phase{"setupHooks"};
+        result = setupHooks();
+    }
 
-    adjustGameRestrictions();
-    setupVftableHooks();
-    return setupHooks();
+    using namespace std::chrono;
+    hooks::logDebug("mss32Proxy.log", "DllMain finished in {:d} us",
+                    duration_cast<microseconds>(steady_clock::now() - start).count());
+    return result;
 }
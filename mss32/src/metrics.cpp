@@ -0,0 +1,264 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+#include "allocationstats.h"
+#include "gameutils.h"
+#include "log.h"
+#include "settings.h"
+#include "utils.h"
+#include <Windows.h>
+#include <array>
+#include <atomic>
+#include <ctime>
+#include <fmt/format.h>
+#include <fstream>
+#include <mutex>
+
+namespace hooks {
+
+struct MetricInfo
+{
+    const char* name;
+    MetricType type;
+};
+
+static constexpr std::array<MetricInfo, (std::size_t)Metric::Count> metricInfos{{
+    {"scripts", MetricType::Timer},
+    {"scriptCacheHits", MetricType::Counter},
+    {"scriptCacheMisses", MetricType::Counter},
+    {"dbfLoads", MetricType::Timer},
+    {"dbfBytesLoaded", MetricType::Counter},
+    {"battleMessagesSerialized", MetricType::Counter},
+    {"customDamageRatios", MetricType::Gauge},
+    {"turn", MetricType::Gauge},
+}};
+
+struct MetricCounters
+{
+    std::atomic<std::int64_t> value{};
+    std::atomic<std::int64_t> ticks{};
+    /** Values when current turn started. */
+    std::atomic<std::int64_t> turnValue{};
+    std::atomic<std::int64_t> turnTicks{};
+};
+
+static std::array<MetricCounters, (std::size_t)Metric::Count> counters;
+
+static std::mutex turnMutex;
+static std::atomic<int> currentTurn{-1};
+
+static MetricCounters& getCounters(Metric metric)
+{
+    return counters[static_cast<std::size_t>(metric)];
+}
+
+void addMetric(Metric metric, std::int64_t value)
+{
+    getCounters(metric).value.fetch_add(value, std::memory_order_relaxed);
+}
+
+void setMetric(Metric metric, std::int64_t value)
+{
+    getCounters(metric).value.store(value, std::memory_order_relaxed);
+}
+
+std::int64_t metricTicks()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+void addMetricTime(Metric metric, std::int64_t ticks)
+{
+    auto& metricCounters = getCounters(metric);
+    metricCounters.value.fetch_add(1, std::memory_order_relaxed);
+    metricCounters.ticks.fetch_add(ticks, std::memory_order_relaxed);
+}
+
+static double ticksToMilliseconds(std::int64_t ticks)
+{
+    static const double ticksPerMillisecond = []() {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        return frequency.QuadPart / 1000.0;
+    }();
+
+    return ticks / ticksPerMillisecond;
+}
+
+static MetricValue getMetricValue(std::size_t index)
+{
+    const auto& info = metricInfos[index];
+    const auto& metricCounters = counters[index];
+
+    const auto value{metricCounters.value.load(std::memory_order_relaxed)};
+    const auto ticks{metricCounters.ticks.load(std::memory_order_relaxed)};
+    const auto turnValue{info.type == MetricType::Gauge
+                             ? value
+                             : value - metricCounters.turnValue.load(std::memory_order_relaxed)};
+    const auto turnTicks{ticks - metricCounters.turnTicks.load(std::memory_order_relaxed)};
+
+    return MetricValue{info.name,
+                       info.type,
+                       value,
+                       turnValue,
+                       ticksToMilliseconds(ticks),
+                       ticksToMilliseconds(turnTicks)};
+}
+
+std::vector<MetricValue> metricValues()
+{
+    std::vector<MetricValue> values;
+    values.reserve(counters.size());
+
+    for (std::size_t i = 0; i < counters.size(); ++i) {
+        values.push_back(getMetricValue(i));
+    }
+
+    return values;
+}
+
+std::optional<MetricValue> findMetric(std::string_view name)
+{
+    for (std::size_t i = 0; i < metricInfos.size(); ++i) {
+        if (name == metricInfos[i].name) {
+            return getMetricValue(i);
+        }
+    }
+
+    return std::nullopt;
+}
+
+static const char* getTypeName(MetricType type)
+{
+    switch (type) {
+    case MetricType::Counter:
+        return "counter";
+    case MetricType::Gauge:
+        return "gauge";
+    case MetricType::Timer:
+    default:
+        return "timer";
+    }
+}
+
+/** Appends values of the turn to 'metrics.csv', header is written to a new file. */
+static void writeCsv(int turn, const std::vector<MetricValue>& values)
+{
+    static std::ofstream file;
+    static bool failed{};
+
+    if (!file.is_open()) {
+        if (failed) {
+            return;
+        }
+
+        const auto path{gameFolder() / "metrics.csv"};
+        std::error_code error;
+        const bool exists{std::filesystem::exists(path, error)};
+
+        file.open(path.c_str(), std::ios_base::app);
+        if (!file) {
+            failed = true;
+            logError("mssProxyError.log", fmt::format("Could not open {:s}", path.string()));
+            return;
+        }
+
+        if (!exists) {
+            file << "time,turn,metric,type,value,turnValue,milliseconds,turnMilliseconds\n";
+        }
+    }
+
+    char time[32]{};
+    const std::time_t now{std::time(nullptr)};
+    std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+    for (const auto& value : values) {
+        file << fmt::format("{:s},{:d},{:s},{:s},{:d},{:d},{:.3f},{:.3f}\n", time, turn,
+                            value.name, getTypeName(value.type), value.value, value.turnValue,
+                            value.milliseconds, value.turnMilliseconds);
+    }
+
+    file.flush();
+}
+
+static void writeTurn(int turn)
+{
+    const auto values{metricValues()};
+
+    if (debugLogEnabled()) {
+        for (const auto& value : values) {
+            if (value.type == MetricType::Timer) {
+                logDebug("metrics.log", "Turn {:d}, {:s}: {:d} times, {:.3f} ms, total {:.3f} ms",
+                         turn, value.name, value.turnValue, value.turnMilliseconds,
+                         value.milliseconds);
+            } else {
+                logDebug("metrics.log", "Turn {:d}, {:s}: {:d}, total {:d}", turn, value.name,
+                         value.turnValue, value.value);
+            }
+        }
+    }
+
+    if (userSettings().writeMetrics) {
+        writeCsv(turn, values);
+    }
+}
+
+void updateMetricsTurn(const game::IMidgardObjectMap* objectMap)
+{
+    const int turn{getScenarioTurn(objectMap)};
+    if (turn == currentTurn.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(turnMutex);
+    const int previousTurn{currentTurn.exchange(turn, std::memory_order_relaxed)};
+    if (previousTurn == turn) {
+        return;
+    }
+
+    if (previousTurn != -1) {
+        finishAllocationTurn(previousTurn);
+        writeTurn(previousTurn);
+    }
+
+    for (auto& metricCounters : counters) {
+        metricCounters.turnValue.store(metricCounters.value.load(std::memory_order_relaxed),
+                                       std::memory_order_relaxed);
+        metricCounters.turnTicks.store(metricCounters.ticks.load(std::memory_order_relaxed),
+                                       std::memory_order_relaxed);
+    }
+
+    setMetric(Metric::Turn, turn);
+}
+
+bool metricsWriteEnabled()
+{
+    return userSettings().writeMetrics || debugLogEnabled();
+}
+
+void flushMetrics()
+{
+    std::lock_guard<std::mutex> lock(turnMutex);
+    writeTurn(currentTurn.load(std::memory_order_relaxed));
+}
+
+} // namespace hooks
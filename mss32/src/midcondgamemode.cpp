@@ -18,6 +18,7 @@
  */
 
 #include "midcondgamemode.h"
+#include "allocationstats.h"
 #include "button.h"
 #include "condinterf.h"
 #include "condinterfhandler.h"
@@ -28,6 +29,7 @@
 #include "game.h"
 #include "interfmanager.h"
 #include "mempool.h"
+#include "metrics.h"
 #include "midevcondition.h"
 #include "midevent.h"
 #include "mideventhooks.h"
@@ -36,8 +38,11 @@
 #include "midgardstream.h"
 #include "radiobuttoninterf.h"
 #include "testcondition.h"
+#include "testconditioncache.h"
 #include "textids.h"
+#include "tracerecorder.h"
 #include "utils.h"
+#include <cstring>
 
 namespace hooks {
 
@@ -57,8 +62,10 @@ struct CMidCondGameMode : public game::CMidEvCondition
 
 void __fastcall condGameModeDestructor(CMidCondGameMode* thisptr, int /*%edx*/, char flags)
 {
+    nextTestConditionGeneration();
+
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -112,7 +119,9 @@ game::CMidEvCondition* createMidCondGameMode()
 {
     using namespace game;
 
-    auto gameMode = (CMidCondGameMode*)Memory::get().allocate(sizeof(CMidCondGameMode));
+    nextTestConditionGeneration();
+
+    auto gameMode = allocateTracked<CMidCondGameMode>(AllocationTag::EventConditions);
 
     gameMode->category.vftable = EventCondCategories::vftable();
     gameMode->category.id = customEventConditions().gameMode.category.id;
@@ -170,7 +179,7 @@ struct CCondGameModeInterf : public game::editor::CCondInterf
 void __fastcall condGameModeInterfDestructor(CCondGameModeInterf* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -297,7 +306,7 @@ game::editor::CCondInterf* createCondGameModeInterf(game::ITask* task,
     using namespace game;
     using namespace editor;
 
-    auto thisptr = (CCondGameModeInterf*)Memory::get().allocate(sizeof(CCondGameModeInterf));
+    auto thisptr = allocateTracked<CCondGameModeInterf>(AllocationTag::EventConditions);
 
     static const char dialogName[]{"DLG_COND_GAME_MODE"};
 
@@ -367,19 +376,15 @@ struct CTestGameMode : public game::ITestCondition
 void __fastcall testGameModeDestructor(CTestGameMode* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
-bool __fastcall testGameModeDoTest(const CTestGameMode* thisptr,
-                                   int /*%edx*/,
-                                   const game::IMidgardObjectMap*,
-                                   const game::CMidgardID*,
-                                   const game::CMidgardID*)
+static bool testGameMode(GameMode gameMode)
 {
     const auto* data = game::CMidgardApi::get().instance()->data;
 
-    switch (thisptr->condition->gameMode) {
+    switch (gameMode) {
     case GameMode::Single:
         return !data->hotseatGame && !data->multiplayerGame;
 
@@ -393,6 +398,24 @@ bool __fastcall testGameModeDoTest(const CTestGameMode* thisptr,
     return false;
 }
 
+bool __fastcall testGameModeDoTest(const CTestGameMode* thisptr,
+                                   int /*%edx*/,
+                                   const game::IMidgardObjectMap* objectMap,
+                                   const game::CMidgardID*,
+                                   const game::CMidgardID*)
+{
+    static const auto traceId{traceName("CMidCondGameMode")};
+    TraceScope trace{TraceEvent::EventConditionTest, traceId};
+    if (metricsWriteEnabled()) {
+        updateMetricsTurn(objectMap);
+    }
+
+    // Game mode never changes during the session
+    const auto condition = thisptr->condition;
+    return getSessionTestResult(condition,
+                                [condition]() { return testGameMode(condition->gameMode); });
+}
+
 static game::ITestConditionVftable testGameModeVftable{
     (game::ITestConditionVftable::Destructor)testGameModeDestructor,
     (game::ITestConditionVftable::Test)testGameModeDoTest,
@@ -400,7 +423,7 @@ static game::ITestConditionVftable testGameModeVftable{
 
 game::ITestCondition* createTestGameMode(game::CMidEvCondition* eventCondition)
 {
-    auto thisptr = (CTestGameMode*)game::Memory::get().allocate(sizeof(CTestGameMode));
+    auto thisptr = allocateTracked<CTestGameMode>(AllocationTag::EventConditions);
     thisptr->condition = static_cast<CMidCondGameMode*>(eventCondition);
     thisptr->vftable = &testGameModeVftable;
 
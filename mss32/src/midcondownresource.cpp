@@ -18,6 +18,7 @@
  */
 
 #include "midcondownresource.h"
+#include "allocationstats.h"
 #include "button.h"
 #include "condinterf.h"
 #include "condinterfhandler.h"
@@ -29,6 +30,7 @@
 #include "interfmanager.h"
 #include "log.h"
 #include "mempool.h"
+#include "metrics.h"
 #include "midevcondition.h"
 #include "midevent.h"
 #include "mideventhooks.h"
@@ -37,9 +39,11 @@
 #include "midgardstream.h"
 #include "midplayer.h"
 #include "testcondition.h"
+#include "testconditioncache.h"
 #include "textboxinterf.h"
 #include "textids.h"
 #include "togglebutton.h"
+#include "tracerecorder.h"
 #include "utils.h"
 #include <fmt/format.h>
 
@@ -58,8 +62,10 @@ struct CMidCondOwnResource : public game::CMidEvCondition
 
 void __fastcall condOwnResourceDestructor(CMidCondOwnResource* thisptr, int /*%edx*/, char flags)
 {
+    nextTestConditionGeneration();
+
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -113,7 +119,9 @@ game::CMidEvCondition* createMidCondOwnResource()
 {
     using namespace game;
 
-    auto ownResource = (CMidCondOwnResource*)Memory::get().allocate(sizeof(CMidCondOwnResource));
+    nextTestConditionGeneration();
+
+    auto ownResource = allocateTracked<CMidCondOwnResource>(AllocationTag::EventConditions);
 
     ownResource->category.vftable = EventCondCategories::vftable();
     ownResource->category.id = customEventConditions().ownResource.category.id;
@@ -158,7 +166,7 @@ void __fastcall condOwnResourceInterfDestructor(CCondOwnResourceInterf* thisptr,
                                                 char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -361,7 +369,7 @@ game::editor::CCondInterf* createCondOwnResourceInterf(game::ITask* task,
     using namespace game;
     using namespace editor;
 
-    auto thisptr = (CCondOwnResourceInterf*)Memory::get().allocate(sizeof(CCondOwnResourceInterf));
+    auto thisptr = allocateTracked<CCondOwnResourceInterf>(AllocationTag::EventConditions);
 
     static const char dialogName[]{"DLG_COND_OWN_RESOURCE"};
 
@@ -441,7 +449,7 @@ struct CTestOwnResource : public game::ITestCondition
 void __fastcall testOwnResourceDestructor(CTestOwnResource* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -451,9 +459,17 @@ bool __fastcall testOwnResourceDoTest(const CTestOwnResource* thisptr,
                                       const game::CMidgardID* playerId,
                                       const game::CMidgardID* eventId)
 {
+    static const auto traceId{traceName("CMidCondOwnResource")};
+    TraceScope trace{TraceEvent::EventConditionTest, traceId};
+    if (metricsWriteEnabled()) {
+        updateMetricsTurn(objectMap);
+    }
+
     using namespace game;
 
-    if (!CMidEventApi::get().affectsPlayer(objectMap, playerId, eventId)) {
+    // Bank is the only input that changes during the session,
+    // read it directly since comparison is cheaper than tracking its changes
+    if (!eventAffectsPlayer(objectMap, playerId, eventId)) {
         return false;
     }
 
@@ -473,7 +489,7 @@ game::ITestConditionVftable testOwnResourceVftable{
 
 game::ITestCondition* createTestOwnResource(game::CMidEvCondition* eventCondition)
 {
-    auto thisptr = (CTestOwnResource*)game::Memory::get().allocate(sizeof(CTestOwnResource));
+    auto thisptr = allocateTracked<CTestOwnResource>(AllocationTag::EventConditions);
     thisptr->ownResource = reinterpret_cast<CMidCondOwnResource*>(eventCondition);
     thisptr->vftable = &testOwnResourceVftable;
 
@@ -18,6 +18,7 @@
  */
 
 #include "midcondplayertype.h"
+#include "allocationstats.h"
 #include "button.h"
 #include "condinterf.h"
 #include "condinterfhandler.h"
@@ -28,6 +29,7 @@
 #include "game.h"
 #include "interfmanager.h"
 #include "mempool.h"
+#include "metrics.h"
 #include "midevcondition.h"
 #include "midevent.h"
 #include "mideventhooks.h"
@@ -35,9 +37,12 @@
 #include "midgardstream.h"
 #include "midplayer.h"
 #include "testcondition.h"
+#include "testconditioncache.h"
 #include "textids.h"
 #include "togglebutton.h"
+#include "tracerecorder.h"
 #include "utils.h"
+#include <cstring>
 
 namespace hooks {
 
@@ -49,8 +54,10 @@ struct CMidCondPlayerType : public game::CMidEvCondition
 
 void __fastcall condPlayerTypeDestructor(CMidCondPlayerType* thisptr, int /*%edx*/, char flags)
 {
+    nextTestConditionGeneration();
+
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -103,7 +110,9 @@ game::CMidEvCondition* createMidCondPlayerType()
 {
     using namespace game;
 
-    auto playerType = (CMidCondPlayerType*)Memory::get().allocate(sizeof(CMidCondPlayerType));
+    nextTestConditionGeneration();
+
+    auto playerType = allocateTracked<CMidCondPlayerType>(AllocationTag::EventConditions);
 
     playerType->category.vftable = EventCondCategories::vftable();
     playerType->category.id = customEventConditions().playerType.category.id;
@@ -154,7 +163,7 @@ void __fastcall condPlayerTypeInterfDestructor(CCondPlayerTypeInterf* thisptr,
                                                char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -280,7 +289,7 @@ game::editor::CCondInterf* createCondPlayerTypeInterf(game::ITask* task,
     using namespace game;
     using namespace editor;
 
-    auto thisptr = (CCondPlayerTypeInterf*)Memory::get().allocate(sizeof(CCondPlayerTypeInterf));
+    auto thisptr = allocateTracked<CCondPlayerTypeInterf>(AllocationTag::EventConditions);
 
     static const char dialogName[]{"DLG_COND_PLAYER_TYPE"};
 
@@ -350,7 +359,7 @@ struct CTestPlayerType : public game::ITestCondition
 void __fastcall testPlayerTypeDestructor(CTestPlayerType* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -360,19 +369,27 @@ bool __fastcall testPlayerTypeDoTest(const CTestPlayerType* thisptr,
                                      const game::CMidgardID* playerId,
                                      const game::CMidgardID* eventId)
 {
-    using namespace game;
-
-    if (!CMidEventApi::get().affectsPlayer(objectMap, playerId, eventId)) {
-        return false;
+    static const auto traceId{traceName("CMidCondPlayerType")};
+    TraceScope trace{TraceEvent::EventConditionTest, traceId};
+    if (metricsWriteEnabled()) {
+        updateMetricsTurn(objectMap);
     }
 
-    auto obj = objectMap->vftable->findScenarioObjectById(objectMap, playerId);
-    if (!obj) {
-        return false;
-    }
+    // Player type and players affected by event never change during the session
+    const auto condition = thisptr->condition;
+    return getPlayerTestResult(condition, playerId, [=]() {
+        if (!eventAffectsPlayer(objectMap, playerId, eventId)) {
+            return false;
+        }
+
+        auto obj = objectMap->vftable->findScenarioObjectById(objectMap, playerId);
+        if (!obj) {
+            return false;
+        }
 
-    auto player = static_cast<const CMidPlayer*>(obj);
-    return thisptr->condition->playerTypeAi == !player->isHuman;
+        auto player = static_cast<const game::CMidPlayer*>(obj);
+        return condition->playerTypeAi == !player->isHuman;
+    });
 }
 
 static game::ITestConditionVftable testPlayerTypeVftable{
@@ -382,7 +399,7 @@ static game::ITestConditionVftable testPlayerTypeVftable{
 
 game::ITestCondition* createTestPlayerType(game::CMidEvCondition* eventCondition)
 {
-    auto thisptr = (CTestPlayerType*)game::Memory::get().allocate(sizeof(CTestPlayerType));
+    auto thisptr = allocateTracked<CTestPlayerType>(AllocationTag::EventConditions);
     thisptr->condition = static_cast<CMidCondPlayerType*>(eventCondition);
     thisptr->vftable = &testPlayerTypeVftable;
 
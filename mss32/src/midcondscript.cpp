@@ -18,6 +18,7 @@
  */
 
 #include "midcondscript.h"
+#include "allocationstats.h"
 #include "bindings/scenarioview.h"
 #include "button.h"
 #include "condinterf.h"
@@ -32,7 +33,9 @@
 #include "interfmanager.h"
 #include "iterators.h"
 #include "listbox.h"
+#include "luagctelemetry.h"
 #include "mempool.h"
+#include "metrics.h"
 #include "midbag.h"
 #include "midevcondition.h"
 #include "midevent.h"
@@ -41,6 +44,7 @@
 #include "scripts.h"
 #include "testcondition.h"
 #include "textboxinterf.h"
+#include "tracerecorder.h"
 #include "utils.h"
 #include <Windows.h>
 #include <fmt/format.h>
@@ -64,7 +68,7 @@ void __fastcall condScriptDestructor(CMidCondScript* thisptr, int /*%edx*/, char
     thisptr->description.~basic_string();
 
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -131,7 +135,7 @@ game::CMidEvCondition* createMidCondScript()
 {
     using namespace game;
 
-    auto script = (CMidCondScript*)Memory::get().allocate(sizeof(CMidCondScript));
+    auto script = allocateTracked<CMidCondScript>(AllocationTag::EventConditions);
     std::memset(script, 0, sizeof(CMidCondScript));
 
     script->category.vftable = EventCondCategories::vftable();
@@ -190,7 +194,7 @@ void __fastcall condScriptInterfDestructor(CCondScriptInterf* thisptr, int /*%ed
     thisptr->bags.~vector();
 
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -529,7 +533,7 @@ game::editor::CCondInterf* createCondScriptInterf(game::ITask* task,
     using namespace game;
     using namespace editor;
 
-    auto thisptr = (CCondScriptInterf*)Memory::get().allocate(sizeof(CCondScriptInterf));
+    auto thisptr = allocateTracked<CCondScriptInterf>(AllocationTag::EventConditions);
     std::memset(thisptr, 0, sizeof(CCondScriptInterf));
 
     static const char dialogName[]{"DLG_COND_SCRIPT"};
@@ -730,7 +734,7 @@ struct CTestScript : public game::ITestCondition
 void __fastcall testScriptDestructor(CTestScript* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -740,18 +744,38 @@ bool __fastcall testScriptDoTest(const CTestScript* thisptr,
                                  const game::CMidgardID* playerId,
                                  const game::CMidgardID* eventId)
 {
+    static const auto traceId{traceName("CMidCondScript")};
+    TraceScope trace{TraceEvent::EventConditionTest, traceId};
+    updateMetricsTurn(objectMap);
+
     const auto& body = thisptr->condition->code;
     if (body.empty()) {
         return false;
     }
 
-    static sol::state lua{createLuaState(true)};
+    // Telemetry is declared first so it outlives the state and its finalizers
+    static LuaGcTelemetry gcTelemetry{"eventConditions"};
+    static sol::state lua{[]() {
+        auto state{createLuaState(true)};
+        configureGarbageCollector(state.lua_state(), userSettings().luaGc.eventConditions);
+        gcTelemetry.attach(state.lua_state());
+        return state;
+    }()};
     const auto code{fmt::format("{:s}\n{:s}\nend\n", scriptSignature, body)};
 
     // Environment prevents cluttering of global namespace by scripts
     // making each script run isolated from others.
     sol::environment env{lua, sol::create, lua.globals()};
 
+    gcTelemetry.callStarted(lua.lua_state());
+    struct CallGuard
+    {
+        ~CallGuard()
+        {
+            gcTelemetry.callFinished(lua.lua_state());
+        }
+    } callGuard;
+
     auto result = lua.safe_script(code, env, [](lua_State*, sol::protected_function_result pfr) {
         return pfr;
     });
@@ -781,6 +805,7 @@ bool __fastcall testScriptDoTest(const CTestScript* thisptr,
     try {
         const bindings::ScenarioView scenario{objectMap};
 
+        MetricTimer timer{Metric::Scripts};
         return (*checkCondition)(scenario);
     } catch (const std::exception& e) {
         logError("mssProxyError.log",
@@ -802,7 +827,7 @@ static game::ITestConditionVftable testScriptVftable{
 
 game::ITestCondition* createTestScript(game::CMidEvCondition* eventCondition)
 {
-    auto thisptr = (CTestScript*)game::Memory::get().allocate(sizeof(CTestScript));
+    auto thisptr = allocateTracked<CTestScript>(AllocationTag::EventConditions);
     thisptr->condition = static_cast<CMidCondScript*>(eventCondition);
     thisptr->vftable = &testScriptVftable;
 
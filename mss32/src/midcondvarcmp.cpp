@@ -18,6 +18,7 @@
  */
 
 #include "midcondvarcmp.h"
+#include "allocationstats.h"
 #include "button.h"
 #include "condinterf.h"
 #include "condinterfhandler.h"
@@ -29,6 +30,7 @@
 #include "interfmanager.h"
 #include "listbox.h"
 #include "mempool.h"
+#include "metrics.h"
 #include "midevcondition.h"
 #include "midevent.h"
 #include "mideventhooks.h"
@@ -36,8 +38,10 @@
 #include "midgardstream.h"
 #include "midscenvariables.h"
 #include "radiobuttoninterf.h"
+#include "scenvariablesindex.h"
 #include "testcondition.h"
 #include "textids.h"
+#include "tracerecorder.h"
 #include "utils.h"
 #include <fmt/format.h>
 #include <functional>
@@ -107,7 +111,7 @@ struct CMidCondVarCmp : game::CMidEvCondition
 void __fastcall condVarCmpDestructor(CMidCondVarCmp* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -160,7 +164,7 @@ game::CMidEvCondition* createMidCondVarCmp()
 {
     using namespace game;
 
-    auto varCmp = (CMidCondVarCmp*)Memory::get().allocate(sizeof(CMidCondVarCmp));
+    auto varCmp = allocateTracked<CMidCondVarCmp>(AllocationTag::EventConditions);
 
     varCmp->category.vftable = EventCondCategories::vftable();
     varCmp->category.id = customEventConditions().variableCmp.category.id;
@@ -248,7 +252,7 @@ void __fastcall condVarCmpInterfDestructor(CCondVarCmpInterf* thisptr, int /*%ed
     Variables().swap(thisptr->variables);
 
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -434,7 +438,7 @@ game::editor::CCondInterf* createCondVarCmpInterf(game::ITask* task,
     using namespace game;
     using namespace editor;
 
-    auto thisptr = (CCondVarCmpInterf*)Memory::get().allocate(sizeof(CCondVarCmpInterf));
+    auto thisptr = allocateTracked<CCondVarCmpInterf>(AllocationTag::EventConditions);
     // Set all values to zero, so std::vector variables in CCondVarCmpInterf can work properly
     std::memset(thisptr, 0, sizeof(CCondVarCmpInterf));
 
@@ -547,7 +551,7 @@ struct CTestVarCmp : public game::ITestCondition
 void __fastcall testVarCmpDestructor(CTestVarCmp* thisptr, int /*%edx*/, char flags)
 {
     if (flags & 1) {
-        game::Memory::get().freeNonZero(thisptr);
+        freeTracked(AllocationTag::EventConditions, thisptr);
     }
 }
 
@@ -557,6 +561,12 @@ bool __fastcall testVarCmpDoTest(const CTestVarCmp* thisptr,
                                  const game::CMidgardID* playerId,
                                  const game::CMidgardID* eventId)
 {
+    static const auto traceId{traceName("CMidCondVarCmp")};
+    TraceScope trace{TraceEvent::EventConditionTest, traceId};
+    if (metricsWriteEnabled()) {
+        updateMetricsTurn(objectMap);
+    }
+
     auto variables = getScenarioVariables(objectMap);
     if (!variables) {
         // Sanity check, this should never happen
@@ -564,10 +574,17 @@ bool __fastcall testVarCmpDoTest(const CTestVarCmp* thisptr,
     }
 
     const auto& getData = game::CMidScenVariablesApi::get().getData;
+    const auto& index = getScenarioVariablesIndex(variables);
     const auto* condition = thisptr->condition;
 
-    const auto value1 = getData(variables, condition->variableId1)->value;
-    const auto value2 = getData(variables, condition->variableId2)->value;
+    // Fallback to game search keeps its behavior for ids missing in scenario
+    const auto variable1 = index.findById(condition->variableId1);
+    const auto value1 = variable1 ? variable1->data.value
+                                  : getData(variables, condition->variableId1)->value;
+
+    const auto variable2 = index.findById(condition->variableId2);
+    const auto value2 = variable2 ? variable2->data.value
+                                  : getData(variables, condition->variableId2)->value;
 
     switch (condition->compareType) {
     case CompareType::Equal:
@@ -599,7 +616,7 @@ static game::ITestConditionVftable testVarCmpVftable{
 
 game::ITestCondition* createTestVarCmp(game::CMidEvCondition* eventCondition)
 {
-    auto thisptr = (CTestVarCmp*)game::Memory::get().allocate(sizeof(CTestVarCmp));
+    auto thisptr = allocateTracked<CTestVarCmp>(AllocationTag::EventConditions);
     thisptr->condition = static_cast<CMidCondVarCmp*>(eventCondition);
     thisptr->vftable = &testVarCmpVftable;
 
@@ -18,6 +18,7 @@
  */
 
 #include "movepathhooks.h"
+#include "allocationstats.h"
 #include "dynamiccast.h"
 #include "game.h"
 #include "gameimages.h"
@@ -108,7 +109,6 @@ void __stdcall showMovementPathHooked(const game::IMidgardObjectMap* objectMap,
     auto images = *imagesPtr.data;
 
     const int maxMovepoints = game::CMidStackApi::get().getMaxMovepoints(stack, objectMap);
-    const auto& memAlloc = Memory::get().allocate;
 
     auto gameSettings = *CMidgardApi::get().instance()->data->settings;
     const bool displayPathTurn{gameSettings->displayPathTurn};
@@ -235,7 +235,7 @@ void __stdcall showMovementPathHooked(const game::IMidgardObjectMap* objectMap,
             }
 
             if (drawTurnNumber) {
-                turnNumberImage = static_cast<CImage2Text*>(memAlloc(sizeof(CImage2Text)));
+                turnNumberImage = allocateTracked<CImage2Text>(AllocationTag::Images);
                 CImage2TextApi::get().constructor(turnNumberImage, 32, 64);
 
                 std::string text{turnString};
@@ -253,7 +253,7 @@ void __stdcall showMovementPathHooked(const game::IMidgardObjectMap* objectMap,
         CImage2Text* moveCostImage{};
 
         if (pathAllowed && !turnNumberImage) {
-            moveCostImage = static_cast<CImage2Text*>(memAlloc(sizeof(CImage2Text)));
+            moveCostImage = allocateTracked<CImage2Text>(AllocationTag::Images);
             CImage2TextApi::get().constructor(moveCostImage, 32, 64);
 
             const auto moveCostString{fmt::format(
@@ -264,7 +264,7 @@ void __stdcall showMovementPathHooked(const game::IMidgardObjectMap* objectMap,
             CImage2TextApi::get().setText(moveCostImage, moveCostString.c_str());
         }
 
-        auto multilayerImg = static_cast<CMultiLayerImg*>(memAlloc(sizeof(CMultiLayerImg)));
+        auto multilayerImg = allocateTracked<CMultiLayerImg>(AllocationTag::Images);
         CMultiLayerImgApi::get().constructor(multilayerImg);
 
         CMultiLayerImgApi::get().addImage(multilayerImg, flagImage, -999, -999);
@@ -19,7 +19,9 @@
 
 #include "netmsgutils.h"
 #include "battlemsgdata.h"
+#include "metrics.h"
 #include "mqstream.h"
+#include "tracerecorder.h"
 #include <vector>
 
 namespace hooks {
@@ -31,6 +33,9 @@ void serializeMsgWithBattleMsgData(game::CNetMsg* msg,
 {
     using namespace game;
 
+    TraceScope trace{TraceEvent::BattleMsgSerialize, emptyTraceName, stream->read ? 1u : 0u};
+    addMetric(Metric::BattleMessagesSerialized);
+
     if (stream->read) {
         const size_t count = std::size(battleMsgData->unitsInfo);
         std::vector<ModifiedUnitInfo*> prev(count);
@@ -32,6 +32,7 @@
 #include "originalfunctions.h"
 #include "racecategory.h"
 #include "racetype.h"
+#include "scenvariablesindex.h"
 #include "utils.h"
 #include <algorithm>
 #include <array>
@@ -95,13 +96,10 @@ game::Bank* __stdcall computePlayerDailyIncomeHooked(game::Bank* income,
 
     std::array<int, 6> cityIncome = {0, 0, 0, 0, 0, 0};
 
-    logDebug("cityIncome.log",
-             fmt::format("Loop through {:d} scenario variables", variables->variables.length));
+    logDebug("cityIncome.log", "Loop through {:d} scenario variables", variables->variables.length);
 
     std::uint32_t listIndex{};
-    forEachScenarioVariable(variables, [racePrefix, &cityIncome,
-                                        &listIndex](const game::ScenarioVariable* variable,
-                                                    std::uint32_t) {
+    for (const auto variable : getScenarioVariablesIndex(variables).getVariables()) {
         const auto& name = variable->data.name;
 
         // Additional income for specific race
@@ -129,9 +127,9 @@ game::Bank* __stdcall computePlayerDailyIncomeHooked(game::Bank* income,
         }
 
         listIndex++;
-    });
+    }
 
-    logDebug("cityIncome.log", fmt::format("Loop done in {:d} iterations", listIndex));
+    logDebug("cityIncome.log", "Loop done in {:d} iterations", listIndex);
 
     if (std::all_of(std::begin(cityIncome), std::end(cityIncome),
                     [](int value) { return value == 0; })) {
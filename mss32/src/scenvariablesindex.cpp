@@ -0,0 +1,135 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scenvariablesindex.h"
+#include "log.h"
+#include "midscenvariables.h"
+#include "utils.h"
+#include <fmt/format.h>
+#include <optional>
+
+namespace hooks {
+
+/** Ids above this limit are not stored in flat array to protect from malformed scenarios. */
+static constexpr int maxIndexedVariableId{65535};
+
+/** Incremented each time the game destroys scenario variables object. */
+static std::uint32_t variablesGeneration{};
+static game::IMidObjectVftable::Destructor variablesDestructor{};
+
+static void __fastcall scenVariablesDtorHooked(game::IMidObject* thisptr,
+                                               int /*%edx*/,
+                                               char flags)
+{
+    ++variablesGeneration;
+    variablesDestructor(thisptr, flags);
+}
+
+/**
+ * Replaces destructor in scenario variables vftable.
+ * Vftable address is not known for all game versions, so it is taken from a live object.
+ */
+static void hookScenVariablesDestructor(const game::CMidScenVariables* variables)
+{
+    using Destructor = game::IMidObjectVftable::Destructor;
+
+    auto destructor = const_cast<Destructor*>(&variables->vftable->destructor);
+    const auto hook = reinterpret_cast<Destructor>(scenVariablesDtorHooked);
+    if (*destructor == hook) {
+        return;
+    }
+
+    const auto original{*destructor};
+    if (writeProtectedMemory(destructor, &hook, sizeof(hook))) {
+        variablesDestructor = original;
+    }
+}
+
+ScenarioVariablesIndex::ScenarioVariablesIndex(const game::CMidScenVariables* variables,
+                                               std::uint32_t generation)
+    : scenVariables(variables)
+    , generation(generation)
+{
+    this->variables.reserve(variables->variables.length);
+
+    int maxId{-1};
+    forEachScenarioVariable(variables, [this, &maxId](const game::ScenarioVariable* variable,
+                                                      std::uint32_t) {
+        this->variables.push_back(variable);
+        variablesByName[variable->data.name] = variable;
+
+        if (variable->variableId > maxId && variable->variableId <= maxIndexedVariableId) {
+            maxId = variable->variableId;
+        }
+    });
+
+    variablesById.resize(static_cast<std::size_t>(maxId + 1), nullptr);
+    for (const auto variable : this->variables) {
+        const int id = variable->variableId;
+        if (id >= 0 && id <= maxId) {
+            variablesById[id] = variable;
+        }
+    }
+
+    logDebug("mss32Proxy.log", "Scenario variables index built: {:d} variables, max id {:d}",
+             this->variables.size(), maxId);
+}
+
+bool ScenarioVariablesIndex::isBuiltFor(const game::CMidScenVariables* variables,
+                                        std::uint32_t generation) const
+{
+    return this->generation == generation && scenVariables == variables;
+}
+
+const game::ScenarioVariable* ScenarioVariablesIndex::findById(int variableId) const
+{
+    if (variableId < 0 || variableId >= static_cast<int>(variablesById.size())) {
+        return nullptr;
+    }
+
+    return variablesById[variableId];
+}
+
+const game::ScenarioVariable* ScenarioVariablesIndex::findByName(const std::string& name) const
+{
+    const auto it = variablesByName.find(name);
+    return it != variablesByName.end() ? it->second : nullptr;
+}
+
+const std::vector<const game::ScenarioVariable*>& ScenarioVariablesIndex::getVariables() const
+{
+    return variables;
+}
+
+const ScenarioVariablesIndex& getScenarioVariablesIndex(const game::CMidScenVariables* variables)
+{
+    // Conditions and scripts access variables from the main thread only
+    static std::optional<ScenarioVariablesIndex> index;
+
+    if (!index || !index->isBuiltFor(variables, variablesGeneration)) {
+        // Hook is installed before index is built,
+        // so destruction of indexed variables is always noticed
+        hookScenVariablesDestructor(variables);
+        index.emplace(variables, variablesGeneration);
+    }
+
+    return *index;
+}
+
+} // namespace hooks
@@ -18,20 +18,28 @@
  */
 
 #include "scripts.h"
+#include "allocationstats.h"
+#include "battlemsgdata.h"
+#include "battlesnapshotview.h"
 #include "categoryids.h"
 #include "dynupgradeview.h"
+#include "fortview.h"
 #include "idview.h"
 #include "locationview.h"
 #include "log.h"
+#include "metrics.h"
 #include "point.h"
 #include "scenariovariableview.h"
 #include "scenarioview.h"
 #include "scenvariablesview.h"
+#include "stackview.h"
 #include "tileview.h"
 #include "unitimplview.h"
 #include "unitslotview.h"
 #include "unitview.h"
 #include "utils.h"
+#include <mutex>
+#include <unordered_map>
 
 namespace hooks {
 
@@ -82,6 +90,47 @@ static void doBindApi(sol::state& lua)
         "Water", GroundId::Water,
         "Mountain", GroundId::Mountain
     );
+
+    lua.new_enum("FortCategory",
+        "Capital", FortId::Capital,
+        "Village", FortId::Village
+    );
+
+    lua.new_enum("BattleStatus",
+        "XpCounted", BattleStatus::XpCounted,
+        "Dead", BattleStatus::Dead,
+        "Paralyze", BattleStatus::Paralyze,
+        "Petrify", BattleStatus::Petrify,
+        "DisableLong", BattleStatus::DisableLong,
+        "BoostDamageLvl1", BattleStatus::BoostDamageLvl1,
+        "BoostDamageLvl2", BattleStatus::BoostDamageLvl2,
+        "BoostDamageLvl3", BattleStatus::BoostDamageLvl3,
+        "BoostDamageLvl4", BattleStatus::BoostDamageLvl4,
+        "BoostDamageLong", BattleStatus::BoostDamageLong,
+        "LowerDamageLvl1", BattleStatus::LowerDamageLvl1,
+        "LowerDamageLvl2", BattleStatus::LowerDamageLvl2,
+        "LowerDamageLong", BattleStatus::LowerDamageLong,
+        "LowerInitiative", BattleStatus::LowerInitiative,
+        "LowerInitiativeLong", BattleStatus::LowerInitiativeLong,
+        "Poison", BattleStatus::Poison,
+        "PoisonLong", BattleStatus::PoisonLong,
+        "Frostbite", BattleStatus::Frostbite,
+        "FrostbiteLong", BattleStatus::FrostbiteLong,
+        "Blister", BattleStatus::Blister,
+        "BlisterLong", BattleStatus::BlisterLong,
+        "Cured", BattleStatus::Cured,
+        "Transform", BattleStatus::Transform,
+        "TransformLong", BattleStatus::TransformLong,
+        "TransformSelf", BattleStatus::TransformSelf,
+        "TransformDoppelganger", BattleStatus::TransformDoppelganger,
+        "TransformDrainLevel", BattleStatus::TransformDrainLevel,
+        "Summon", BattleStatus::Summon,
+        "Retreated", BattleStatus::Retreated,
+        "Retreat", BattleStatus::Retreat,
+        "Hidden", BattleStatus::Hidden,
+        "Defend", BattleStatus::Defend,
+        "Unsummoned", BattleStatus::Unsummoned
+    );
     // clang-format on
 
     bindings::UnitView::bind(lua);
@@ -95,7 +144,95 @@ static void doBindApi(sol::state& lua)
     bindings::ScenVariablesView::bind(lua);
     bindings::ScenarioVariableView::bind(lua);
     bindings::TileView::bind(lua);
+    bindings::FortView::bind(lua);
+    bindings::StackView::bind(lua);
+    bindings::BattleSnapshotView::bind(lua);
     lua.set_function("log", [](const std::string& message) { logDebug("luaDebug.log", message); });
+    lua.set_function("getAllocations", [](sol::this_state state) {
+        sol::state_view view{state};
+        auto result = view.create_table();
+
+        for (const auto& stats : allocationStats()) {
+            result[stats.name] = view.create_table_with(
+                "bytes", stats.bytes, "objects", stats.objects, "peakBytes", stats.peakBytes,
+                "allocations", stats.allocations, "turnAllocations", stats.turnAllocations,
+                "turnBytes", stats.turnBytes);
+        }
+
+        return result;
+    });
+
+    // Metrics are looked up on each access, so scripts always read current values
+    auto metrics = lua.create_named_table("metrics");
+    metrics[sol::metatable_key] = lua.create_table_with(
+        "__index", [](sol::this_state state, sol::table, const std::string& name) -> sol::object {
+            sol::state_view view{state};
+
+            const auto metric{findMetric(name)};
+            if (!metric) {
+                return sol::make_object(view, sol::lua_nil);
+            }
+
+            return view.create_table_with("value", metric->value, "turnValue", metric->turnValue,
+                                          "milliseconds", metric->milliseconds,
+                                          "turnMilliseconds", metric->turnMilliseconds);
+        });
+}
+
+static int writeChunk(lua_State*, const void* data, size_t size, void* chunk)
+{
+    static_cast<std::string*>(chunk)->append(static_cast<const char*>(data), size);
+    return 0;
+}
+
+/** Returns bytecode of the script or source itself if script does not compile. */
+static std::string compileChunk(const std::string& source, const std::string& chunkName)
+{
+    std::string chunk;
+
+    lua_State* lua = luaL_newstate();
+    if (luaL_loadbuffer(lua, source.data(), source.size(), chunkName.c_str()) == LUA_OK) {
+        lua_dump(lua, writeChunk, &chunk, 0);
+    }
+
+    lua_close(lua);
+    return chunk.empty() ? source : chunk;
+}
+
+/**
+ * Scripts with api bound are loaded for each call, so they are read and compiled only once.
+ * Scripts that do not compile are kept as source, their errors are reported on load.
+ * Returns empty string if script could not be read.
+ */
+static const std::string& scriptChunk(const std::filesystem::path& path)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::string> chunks;
+
+    std::string pathString{path.string()};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = chunks.find(pathString);
+    if (it == chunks.end()) {
+        addMetric(Metric::ScriptCacheMisses);
+        const auto source{readFile(path)};
+        auto chunk{source.empty() ? source : compileChunk(source, "@" + pathString)};
+        trackAllocation(AllocationTag::Scripts, chunk.size());
+        it = chunks.emplace(std::move(pathString), std::move(chunk)).first;
+    } else {
+        addMetric(Metric::ScriptCacheHits);
+    }
+
+    return it->second;
+}
+
+void preloadScriptFiles(const std::vector<std::filesystem::path>& paths)
+{
+    for (const auto& path : paths) {
+        if (std::filesystem::exists(path)) {
+            scriptChunk(path);
+        }
+    }
 }
 
 std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
@@ -105,15 +242,12 @@ std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
     if (!alwaysExists && !std::filesystem::exists(path))
         return std::nullopt;
 
-    sol::state lua;
+    sol::state lua{sol::default_at_panic, trackedLuaAlloc};
     sol::protected_function_result result;
     std::string pathString = path.string();
     if (bindApi) {
-        static std::unordered_map<std::string, std::string> sources;
-        if (sources.find(pathString) == sources.end())
-            sources[pathString] = readFile(path);
-
-        if (sources[pathString].empty()) {
+        const auto& chunk{scriptChunk(path)};
+        if (chunk.empty()) {
             showErrorMessageBox(fmt::format("Failed to read '{:s}' script file", pathString));
             return std::nullopt;
         }
@@ -121,11 +255,11 @@ std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
         lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::table,
                            sol::lib::os);
         doBindApi(lua);
+        configureGarbageCollector(lua.lua_state(), userSettings().luaGc.scripts);
 
-        result = lua.safe_script(sources[pathString].c_str(),
-                                 [](lua_State*, sol::protected_function_result pfr) {
-                                     return pfr;
-                                 });
+        result = lua.safe_script(chunk, [](lua_State*, sol::protected_function_result pfr) {
+            return pfr;
+        });
     } else {
         result = lua.load_file(pathString)();
     }
@@ -143,7 +277,7 @@ std::optional<sol::state> loadScriptFile(const std::filesystem::path& path,
 
 sol::state createLuaState(bool bindApi)
 {
-    sol::state lua;
+    sol::state lua{sol::default_at_panic, trackedLuaAlloc};
     lua.open_libraries(sol::lib::base, sol::lib::package, sol::lib::math, sol::lib::table,
                        sol::lib::os);
 
@@ -154,4 +288,13 @@ sol::state createLuaState(bool bindApi)
     return std::move(lua);
 }
 
+void configureGarbageCollector(lua_State* lua, const Settings::LuaGarbageCollector& settings)
+{
+    if (settings.generational) {
+        lua_gc(lua, LUA_GCGEN, settings.minorMultiplier, settings.majorMultiplier);
+    } else {
+        lua_gc(lua, LUA_GCINC, settings.pause, settings.stepMultiplier, settings.stepSize);
+    }
+}
+
 } // namespace hooks
@@ -98,6 +98,43 @@ static void readMovementCostSettings(const sol::table& table, Settings::Movement
     }
 }
 
+static void readLuaGcSettings(const sol::table& table,
+                              const char* name,
+                              const Settings::LuaGarbageCollector& def,
+                              Settings::LuaGarbageCollector& value)
+{
+    value = def;
+
+    auto gc = table.get<sol::optional<sol::table>>(name);
+    if (!gc.has_value()) {
+        return;
+    }
+
+    // Zero values are not allowed since lua_gc treats them as 'keep current value'
+    value.generational = readSetting(gc.value(), "generational", def.generational);
+    value.pause = readSetting(gc.value(), "pause", def.pause, 1, 1000);
+    value.stepMultiplier = readSetting(gc.value(), "stepMultiplier", def.stepMultiplier, 1, 1000);
+    value.stepSize = readSetting(gc.value(), "stepSize", def.stepSize, 1, 20);
+    value.minorMultiplier = readSetting(gc.value(), "minorMultiplier", def.minorMultiplier, 1,
+                                        100);
+    value.majorMultiplier = readSetting(gc.value(), "majorMultiplier", def.majorMultiplier, 1, 1000);
+}
+
+static void readLuaGcSettings(const sol::table& table, Settings::LuaGarbageCollectors& value)
+{
+    const auto& def = defaultSettings().luaGc;
+
+    auto luaGc = table.get<sol::optional<sol::table>>("luaGc");
+    if (!luaGc.has_value()) {
+        value = def;
+        return;
+    }
+
+    readLuaGcSettings(luaGc.value(), "scripts", def.scripts, value.scripts);
+    readLuaGcSettings(luaGc.value(), "eventConditions", def.eventConditions,
+                      value.eventConditions);
+}
+
 static void readSettings(const sol::table& table, Settings& settings)
 {
     // clang-format off
@@ -128,11 +165,18 @@ static void readSettings(const sol::table& table, Settings& settings)
     settings.unrestrictedBestowWards = readSetting(table, "unrestrictedBestowWards", defaultSettings().unrestrictedBestowWards);
     settings.freeTransformSelfAttack = readSetting(table, "freeTransformSelfAttack", defaultSettings().freeTransformSelfAttack);
     settings.detailedAttackDescription = readSetting(table, "detailedAttackDescription", defaultSettings().detailedAttackDescription);
+    settings.cacheDatabases = readSetting(table, "cacheDatabases", defaultSettings().cacheDatabases);
+    settings.reloadDatabases = readSetting(table, "reloadDatabases", defaultSettings().reloadDatabases);
+    settings.profileHooks = readSetting(table, "profileHooks", defaultSettings().profileHooks);
+    settings.recordTrace = readSetting(table, "recordTrace", defaultSettings().recordTrace);
+    settings.captureBattles = readSetting(table, "captureBattles", defaultSettings().captureBattles);
+    settings.writeMetrics = readSetting(table, "writeMetrics", defaultSettings().writeMetrics);
     settings.debugMode = readSetting(table, "debugHooks", defaultSettings().debugMode);
     // clang-format on
 
     readAiAttackPowerSettings(table, settings.aiAttackPowerBonus);
     readMovementCostSettings(table, settings.movementCost);
+    readLuaGcSettings(table, settings.luaGc);
 }
 
 const Settings& baseSettings()
@@ -176,6 +220,20 @@ const Settings& baseSettings()
         settings.movementCost.textColor = Color{200, 200, 200};
         settings.movementCost.show = false;
         settings.movementCost.realMovementCost = false;
+        // Lua 5.4 collector defaults
+        settings.luaGc.scripts.generational = false;
+        settings.luaGc.scripts.pause = 200;
+        settings.luaGc.scripts.stepMultiplier = 100;
+        settings.luaGc.scripts.stepSize = 13;
+        settings.luaGc.scripts.minorMultiplier = 20;
+        settings.luaGc.scripts.majorMultiplier = 100;
+        settings.luaGc.eventConditions = settings.luaGc.scripts;
+        settings.cacheDatabases = false;
+        settings.reloadDatabases = false;
+        settings.profileHooks = false;
+        settings.recordTrace = false;
+        settings.captureBattles = false;
+        settings.writeMetrics = false;
         settings.debugMode = false;
 
         initialized = true;
@@ -196,6 +254,8 @@ const Settings& defaultSettings()
         settings.movementCost.show = true;
         settings.movementCost.realMovementCost = false;
         settings.detailedAttackDescription = true;
+        settings.luaGc.eventConditions.generational = true;
+        settings.cacheDatabases = true;
 
         initialized = true;
     }
@@ -25,6 +25,7 @@
 #include "game.h"
 #include "globaldata.h"
 #include "log.h"
+#include "metrics.h"
 #include "midgardobjectmap.h"
 #include "midunit.h"
 #include "midunitgroup.h"
@@ -61,6 +62,7 @@ static int getSummonLevel(const game::CMidUnit* summoner, game::TUsUnitImpl* sum
         const bindings::UnitView summonerUnit{summoner};
         const bindings::UnitImplView impl{summonImpl};
 
+        MetricTimer timer{Metric::Scripts};
         return (*getLevel)(summonerUnit, impl);
     } catch (const std::exception& e) {
         showErrorMessageBox(fmt::format("Failed to run '{:s}' script.\n"
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "testconditioncache.h"
+#include "log.h"
+#include "midevent.h"
+#include "midgardid.h"
+#include <atomic>
+#include <cstdint>
+#include <fmt/format.h>
+#include <unordered_map>
+
+namespace hooks {
+
+/** Pair of condition or event and player the cached value belongs to. */
+struct ObjectKey
+{
+    std::uintptr_t object;
+    int playerId;
+
+    bool operator==(const ObjectKey& other) const
+    {
+        return object == other.object && playerId == other.playerId;
+    }
+};
+
+struct ObjectKeyHash
+{
+    std::size_t operator()(const ObjectKey& key) const
+    {
+        return std::hash<std::uintptr_t>{}(key.object) ^ (std::hash<int>{}(key.playerId) * 31);
+    }
+};
+
+static ObjectKey makeKey(const void* condition, int playerId)
+{
+    return ObjectKey{reinterpret_cast<std::uintptr_t>(condition), playerId};
+}
+
+struct TestConditionCache
+{
+    std::uint32_t generation{};
+
+    std::unordered_map<ObjectKey, bool, ObjectKeyHash> testResults;
+    std::unordered_map<ObjectKey, bool, ObjectKeyHash> eventsAffectPlayers;
+
+    std::uint32_t tests{};
+    std::uint32_t cacheHits{};
+};
+
+static std::atomic<std::uint32_t> sessionGeneration{1};
+
+void nextTestConditionGeneration()
+{
+    sessionGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+static TestConditionCache& getCache()
+{
+    static TestConditionCache cache;
+
+    // Condition addresses can be reused by the next loaded scenario,
+    // so generation is changed by the conditions themselves rather than guessed from the map
+    const auto generation = sessionGeneration.load(std::memory_order_relaxed);
+    if (cache.generation != generation) {
+        if (cache.tests) {
+            logDebug("mss32Proxy.log",
+                     "Event condition cache generation {:d}: {:d} tests, "
+                     "{:d} served from cache",
+                     cache.generation, cache.tests, cache.cacheHits);
+        }
+
+        cache.generation = generation;
+        cache.testResults.clear();
+        cache.eventsAffectPlayers.clear();
+        cache.tests = 0;
+        cache.cacheHits = 0;
+    }
+
+    return cache;
+}
+
+static bool getTestResult(TestConditionCache& cache,
+                          const ObjectKey& key,
+                          const std::function<bool()>& test)
+{
+    ++cache.tests;
+
+    const auto it = cache.testResults.find(key);
+    if (it != cache.testResults.end()) {
+        ++cache.cacheHits;
+        return it->second;
+    }
+
+    const bool result = test();
+    cache.testResults[key] = result;
+    return result;
+}
+
+bool getSessionTestResult(const void* condition, const std::function<bool()>& test)
+{
+    return getTestResult(getCache(), makeKey(condition, 0), test);
+}
+
+bool getPlayerTestResult(const void* condition,
+                         const game::CMidgardID* playerId,
+                         const std::function<bool()>& test)
+{
+    return getTestResult(getCache(), makeKey(condition, playerId->value), test);
+}
+
+bool eventAffectsPlayer(const game::IMidgardObjectMap* objectMap,
+                        const game::CMidgardID* playerId,
+                        const game::CMidgardID* eventId)
+{
+    auto& cache = getCache();
+
+    const ObjectKey key{static_cast<std::uintptr_t>(eventId->value), playerId->value};
+
+    const auto it = cache.eventsAffectPlayers.find(key);
+    if (it != cache.eventsAffectPlayers.end()) {
+        return it->second;
+    }
+
+    const bool affects = game::CMidEventApi::get().affectsPlayer(objectMap, playerId, eventId);
+    cache.eventsAffectPlayers[key] = affects;
+    return affects;
+}
+
+} // namespace hooks
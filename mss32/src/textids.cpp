@@ -22,6 +22,7 @@
 #include "scripts.h"
 #include "utils.h"
 #include <fmt/format.h>
+#include <mutex>
 #include <sol/sol.hpp>
 
 namespace hooks {
@@ -133,13 +134,10 @@ void initialize(TextIds& value)
 const TextIds& textIds()
 {
     static TextIds value;
-    static bool initialized = false;
-
-    if (!initialized) {
-        initialize(value);
-        initialized = true;
-    }
+    static std::once_flag initialized;
 
+    // Text ids are preloaded on a background thread, callers wait until it finishes
+    std::call_once(initialized, []() { initialize(value); });
     return value;
 }
 
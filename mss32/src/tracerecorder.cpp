@@ -0,0 +1,194 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracerecorder.h"
+#include "log.h"
+#include "utils.h"
+#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hooks {
+
+bool traceRecording{};
+
+/** Keeps the latest records of a thread, 1.5 MB each. */
+struct ThreadBuffer
+{
+    static constexpr std::size_t capacity{65536};
+
+    std::uint32_t threadId;
+    std::atomic<std::uint64_t> written{};
+    TraceRecord records[capacity];
+};
+
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+static thread_local ThreadBuffer* threadBuffer{};
+
+static std::mutex namesMutex;
+static std::unordered_map<std::string, std::uint32_t> nameIds{{std::string(), emptyTraceName}};
+static std::vector<std::string> names{std::string()};
+
+static ThreadBuffer& getThreadBuffer()
+{
+    if (!threadBuffer) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->threadId = GetCurrentThreadId();
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threadBuffer = buffer.get();
+        buffers.push_back(std::move(buffer));
+    }
+
+    return *threadBuffer;
+}
+
+static void watchHotkey()
+{
+    std::thread([]() {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            if (isGameWindowActive() && (GetAsyncKeyState(VK_CONTROL) & 0x8000)
+                && (GetAsyncKeyState(VK_SHIFT) & 0x8000) && (GetAsyncKeyState('T') & 0x8000)) {
+                writeTrace();
+                // Do not write trace again while keys are held
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        }
+    }).detach();
+}
+
+void startTraceRecording()
+{
+    if (traceRecording) {
+        return;
+    }
+
+    traceRecording = true;
+    watchHotkey();
+}
+
+std::uint32_t traceName(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(namesMutex);
+
+    const auto [it, inserted] = nameIds.try_emplace(std::string(name),
+                                                    static_cast<std::uint32_t>(names.size()));
+    if (inserted) {
+        names.emplace_back(name);
+    }
+
+    return it->second;
+}
+
+void traceRecord(TraceEvent event, TracePhase phase, std::uint32_t name, std::uint64_t payload)
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+
+    auto& buffer = getThreadBuffer();
+    const auto index = buffer.written.load(std::memory_order_relaxed);
+
+    auto& record = buffer.records[index % ThreadBuffer::capacity];
+    record.timestamp = static_cast<std::uint64_t>(counter.QuadPart);
+    record.name = name;
+    record.event = static_cast<std::uint16_t>(event);
+    record.phase = static_cast<std::uint8_t>(phase);
+    record.reserved = 0;
+    record.payload = payload;
+
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void writeTrace(bool processExit)
+{
+    if (!traceRecording) {
+        return;
+    }
+
+    static std::mutex writeMutex;
+    std::unique_lock<std::mutex> writeLock(writeMutex, std::defer_lock);
+    std::unique_lock<std::mutex> namesLock(namesMutex, std::defer_lock);
+    std::unique_lock<std::mutex> buffersLock(buffersMutex, std::defer_lock);
+
+    if (!processExit) {
+        std::lock(writeLock, namesLock, buffersLock);
+    } else if (std::try_lock(writeLock, namesLock, buffersLock) != -1) {
+        return;
+    }
+
+    const auto path{gameFolder() / "mss32Trace.bin"};
+    std::ofstream file(path.c_str(), std::ios_base::binary);
+    if (!file) {
+        logError("mssProxyError.log", fmt::format("Could not create {:s}", path.string()));
+        return;
+    }
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    TraceFileHeader header{};
+    std::memcpy(header.magic, traceMagic, sizeof(traceMagic));
+    header.version = traceVersion;
+    header.ticksPerSecond = static_cast<std::uint64_t>(frequency.QuadPart);
+    header.namesTotal = static_cast<std::uint32_t>(names.size());
+    header.threadsTotal = static_cast<std::uint32_t>(buffers.size());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& name : names) {
+        const auto length{static_cast<std::uint32_t>(name.size())};
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), length);
+    }
+
+    for (const auto& buffer : buffers) {
+        // Threads keep recording while the trace is written, records are copied first
+        // so the ones that were overwritten meanwhile are the only ones lost
+        const auto written = buffer->written.load(std::memory_order_acquire);
+        const auto first = written > ThreadBuffer::capacity ? written - ThreadBuffer::capacity : 0;
+
+        std::vector<TraceRecord> records;
+        records.reserve(static_cast<std::size_t>(written - first));
+        for (auto i = first; i < written; ++i) {
+            records.push_back(buffer->records[i % ThreadBuffer::capacity]);
+        }
+
+        const auto recordsTotal{static_cast<std::uint32_t>(records.size())};
+        file.write(reinterpret_cast<const char*>(&buffer->threadId), sizeof(buffer->threadId));
+        file.write(reinterpret_cast<const char*>(&recordsTotal), sizeof(recordsTotal));
+        file.write(reinterpret_cast<const char*>(records.data()),
+                   records.size() * sizeof(TraceRecord));
+    }
+
+    logDebug("mss32Proxy.log", "Trace of {:d} threads written to {:s}", buffers.size(),
+             path.string());
+}
+
+} // namespace hooks
@@ -26,6 +26,7 @@
 #include "game.h"
 #include "globaldata.h"
 #include "log.h"
+#include "metrics.h"
 #include "midgardobjectmap.h"
 #include "midunit.h"
 #include "scripts.h"
@@ -63,6 +64,7 @@ static int getTransformSelfLevel(const game::CMidUnit* unit, game::TUsUnitImpl*
         const bindings::UnitView attacker{unit};
         const bindings::UnitImplView impl{transformImpl};
 
+        MetricTimer timer{Metric::Scripts};
         return (*getLevel)(attacker, impl);
     } catch (const std::exception& e) {
         showErrorMessageBox(fmt::format("Failed to run '{:s}' script.\n"
@@ -19,13 +19,15 @@
 
 #include "unitsforhire.h"
 #include "categoryids.h"
-#include "dbf/dbffile.h"
+#include "dbf/dbfcatalog.h"
 #include "dbfaccess.h"
 #include "log.h"
 #include "midgardid.h"
+#include "utils.h"
 #include <fmt/format.h>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 /** Converts enum value to underlying integral type. */
 template <typename T>
@@ -45,33 +47,41 @@ bool loadUnitsForHire(const std::filesystem::path& gameFolder)
     const std::filesystem::path globalsFolder{gameFolder / "globals"};
     const std::string raceDbName{"Grace.dbf"};
 
-    DbfFile raceDb;
-    if (!raceDb.open(globalsFolder / raceDbName)) {
+    const auto raceDb{dbfCatalog().table(globalsFolder / raceDbName)};
+    if (!raceDb) {
         logError("mssProxyError.log", fmt::format("Could not read {:s} database.", raceDbName));
         return false;
     }
 
     // check how many new soldier_n columns we have, starting from soldier_6
     constexpr size_t columnsMax{10};
-    size_t newColumns{};
-    for (; newColumns < columnsMax; ++newColumns) {
-        const DbfColumn* column{raceDb.column(fmt::format("SOLDIER_{:d}", newColumns + 6))};
-        if (!column) {
+    std::vector<std::string> soldierColumnNames;
+    std::vector<DbfTable::Column<std::string_view>> soldierColumns;
+    for (size_t i = 0; i < columnsMax; ++i) {
+        const std::string columnName{fmt::format("SOLDIER_{:d}", i + 6)};
+        const auto column{raceDb->column<std::string_view>(columnName)};
+        if (!column.isValid()) {
             break;
         }
+
+        soldierColumnNames.push_back(columnName);
+        soldierColumns.push_back(column);
     }
 
+    const size_t newColumns{soldierColumns.size()};
     if (!newColumns) {
+        units.clear();
         return true;
     }
 
-    UnitsForHire tmpUnits(raceDb.recordsTotal());
+    const std::string idColumnName{"RACE_ID"};
+    const auto idColumn{raceDb->column<std::string_view>(idColumnName)};
 
-    for (size_t row = 0; row < raceDb.recordsTotal(); ++row) {
-        const std::string idColumnName{"RACE_ID"};
+    UnitsForHire tmpUnits(raceDb->recordsTotal());
 
+    for (std::uint32_t row = 0; row < raceDb->recordsTotal(); ++row) {
         game::CMidgardID raceId{};
-        if (!dbRead(raceId, raceDb, row, idColumnName)) {
+        if (!dbRead(raceId, idColumn, row)) {
             logError("mssProxyError.log",
                      fmt::format("Failed to read row {:d} column {:s} from {:s} database.", row,
                                  idColumnName, raceDbName));
@@ -100,12 +110,11 @@ bool loadUnitsForHire(const std::filesystem::path& gameFolder)
         }
 
         for (size_t i = 0; i < newColumns; ++i) {
-            const std::string columnName{fmt::format("SOLDIER_{:d}", i + 6)};
             game::CMidgardID soldierId{};
-            if (!dbRead(soldierId, raceDb, row, columnName) || soldierId == game::invalidId) {
+            if (!dbRead(soldierId, soldierColumns[i], row) || soldierId == game::invalidId) {
                 logError("mssProxyError.log",
                          fmt::format("Row {:d} column {:s} has invalid id in {:s} database", row,
-                                     columnName, raceDbName));
+                                     soldierColumnNames[i], raceDbName));
                 return false;
             }
 
@@ -18,6 +18,8 @@
  */
 
 #include "utils.h"
+#include "allocationstats.h"
+#include "dbf/dbfcatalog.h"
 #include "game.h"
 #include "interfmanager.h"
 #include "log.h"
@@ -26,7 +28,10 @@
 #include "midgardobjectmap.h"
 #include "midmsgboxbuttonhandlerstd.h"
 #include "midscenvariables.h"
+#include "settings.h"
 #include <Windows.h>
+#include <cstring>
+#include <fmt/format.h>
 #include <fstream>
 #include <random>
 
@@ -61,6 +66,22 @@ const std::filesystem::path& scriptsFolder()
     return folder;
 }
 
+std::filesystem::path dbfCacheFolder()
+{
+    if (!userSettings().cacheDatabases) {
+        return {};
+    }
+
+    return gameFolder() / "mss32Cache";
+}
+
+utils::DbfCatalog& dbfCatalog()
+{
+    static utils::DbfCatalog catalog{dbfCacheFolder()};
+
+    return catalog;
+}
+
 const std::filesystem::path& exePath()
 {
     static std::filesystem::path exe{};
@@ -166,13 +187,12 @@ void showMessageBox(const std::string& message,
 {
     using namespace game;
 
-    auto memAlloc = Memory::get().allocate;
     if (!buttonHandler) {
-        buttonHandler = (CMidMsgBoxButtonHandlerStd*)memAlloc(sizeof(CMidMsgBoxButtonHandlerStd));
+        buttonHandler = allocateTracked<CMidMsgBoxButtonHandlerStd>(AllocationTag::MessageBoxes);
         buttonHandler->vftable = CMidMsgBoxButtonHandlerStdApi::vftable();
     }
 
-    CMidgardMsgBox* msgBox = (CMidgardMsgBox*)memAlloc(sizeof(CMidgardMsgBox));
+    auto msgBox = allocateTracked<CMidgardMsgBox>(AllocationTag::MessageBoxes);
     CMidgardMsgBoxApi::get().constructor(msgBox, message.c_str(), showCancel, buttonHandler, 0,
                                          nullptr);
 
@@ -189,6 +209,27 @@ void showErrorMessageBox(const std::string& message)
     MessageBox(NULL, message.c_str(), "mss32.dll proxy", MB_OK);
 }
 
+bool writeProtectedMemory(void* address, const void* data, std::size_t size)
+{
+    DWORD oldProtection{};
+    if (!VirtualProtect(address, size, PAGE_EXECUTE_READWRITE, &oldProtection)) {
+        logError("mssProxyError.log",
+                 fmt::format("Failed to change memory protection for {:p}", address));
+        return false;
+    }
+
+    std::memcpy(address, data, size);
+    VirtualProtect(address, size, oldProtection, &oldProtection);
+    return true;
+}
+
+bool isGameWindowActive()
+{
+    DWORD processId{};
+    GetWindowThreadProcessId(GetForegroundWindow(), &processId);
+    return processId == GetCurrentProcessId();
+}
+
 game::CMidgardID createScenarioVariablesId(const game::IMidgardObjectMap* objectMap)
 {
     using namespace game;
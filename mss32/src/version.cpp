@@ -21,16 +21,12 @@
 
 namespace hooks {
 
-static GameVersion version{GameVersion::Unknown};
-
-GameVersion gameVersion()
-{
-    return version;
-}
+GameVersion currentGameVersion{GameVersion::Unknown};
 
 bool executableIsGame()
 {
-    return version != GameVersion::Unknown && version != GameVersion::ScenarioEditor;
+    return currentGameVersion != GameVersion::Unknown
+           && currentGameVersion != GameVersion::ScenarioEditor;
 }
 
 std::error_code determineGameVersion(const std::filesystem::path& exeFilePath)
@@ -44,26 +40,26 @@ std::error_code determineGameVersion(const std::filesystem::path& exeFilePath)
     // Determine game version by executable file size
     switch (exeFileSize) {
     case 3907200:
-        version = GameVersion::Akella;
+        currentGameVersion = GameVersion::Akella;
         break;
 
     // Mortling's mod, exe with custom icon
     case 4214272:
         [[fallthrough]];
     case 4187648:
-        version = GameVersion::Russobit;
+        currentGameVersion = GameVersion::Russobit;
         break;
 
     case 4474880:
-        version = GameVersion::Gog;
+        currentGameVersion = GameVersion::Gog;
         break;
 
     case 2895872:
-        version = GameVersion::ScenarioEditor;
+        currentGameVersion = GameVersion::ScenarioEditor;
         break;
 
     default:
-        version = GameVersion::Unknown;
+        currentGameVersion = GameVersion::Unknown;
         break;
     }
 
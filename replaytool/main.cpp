@@ -0,0 +1,528 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * Replays battle actions captured by mss32 proxy with "captureBattles" setting enabled.
+ * Targeting scripts are run through the proxy code and bindings against stand-in battle
+ * created from the captured unit stats, see benchtool/standins.h.
+ * Their results and damage ratios are compared with the ones chosen in the game.
+ * Battle state is checked to have the same layout as the proxy uses.
+ */
+
+#include "battlecaptureformat.h"
+#include "customattacks.h"
+#include "customattackutils.h"
+#include "damageratio.h"
+#include "midgardid.h"
+#include "standins.h"
+#include "unitslotview.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace hooks;
+
+namespace {
+
+struct Options
+{
+    std::filesystem::path capture{"battleCapture.bin"};
+    std::filesystem::path scriptsFolder{"Scripts"};
+    /** Number of times each script call is repeated to measure its duration. */
+    int repeats{1};
+    bool verbose{};
+};
+
+const char* actionNames[] = {"Attack", "Skip", "Retreat", "Wait",
+                             "Defend", "Auto", "UseItem", "Resolve"};
+
+const char* actionName(std::int32_t action)
+{
+    if (action < 0 || action >= static_cast<std::int32_t>(std::size(actionNames))) {
+        return "Unknown";
+    }
+
+    return actionNames[action];
+}
+
+/** Sequential reader of the record bytes. */
+class RecordReader
+{
+public:
+    explicit RecordReader(const std::vector<char>& data)
+        : data{data}
+    { }
+
+    bool read(void* value, std::size_t size)
+    {
+        if (data.size() - offset < size) {
+            return false;
+        }
+
+        std::memcpy(value, data.data() + offset, size);
+        offset += size;
+        return true;
+    }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        return read(&value, sizeof(T));
+    }
+
+    const char* skip(std::size_t size)
+    {
+        if (data.size() - offset < size) {
+            return nullptr;
+        }
+
+        const char* position{data.data() + offset};
+        offset += size;
+        return position;
+    }
+
+private:
+    const std::vector<char>& data;
+    std::size_t offset{};
+};
+
+struct Targeting
+{
+    BattleCaptureTargeting call;
+    std::vector<std::uint8_t> allies;
+    std::vector<std::uint8_t> targets;
+    std::vector<std::uint8_t> result;
+    std::string script;
+};
+
+struct Action
+{
+    BattleCaptureRecord record;
+    std::uint32_t modifiedUnits; /**< Non-empty entries in patched arrays. */
+    Targeting targeting;
+    std::vector<std::uint32_t> targetIds;
+    std::vector<double> ratios;
+};
+
+bool readAction(const BattleCaptureHeader& header, const std::vector<char>& data, Action& action)
+{
+    RecordReader reader{data};
+
+    if (!reader.skip(header.battleMsgDataSize)) {
+        return false;
+    }
+
+    action.modifiedUnits = 0;
+    for (std::uint32_t i = 0; i < header.unitsInfoTotal * header.modifiedUnitsTotal; ++i) {
+        const char* modifiedUnit{reader.skip(header.modifiedUnitSize)};
+        if (!modifiedUnit) {
+            return false;
+        }
+
+        // Each element starts with id of the modified unit
+        std::uint32_t unitId;
+        std::memcpy(&unitId, modifiedUnit, sizeof(unitId));
+        action.modifiedUnits += unitId != 0;
+    }
+
+    const auto& record = action.record;
+    if (record.flags & static_cast<std::uint8_t>(BattleCaptureFlag::Targeting)) {
+        auto& targeting = action.targeting;
+        if (!reader.read(targeting.call)) {
+            return false;
+        }
+
+        targeting.allies.resize(targeting.call.alliesTotal);
+        targeting.targets.resize(targeting.call.targetsTotal);
+        targeting.result.resize(targeting.call.resultTotal);
+
+        std::uint32_t length{};
+        if (!reader.read(targeting.allies.data(), targeting.allies.size())
+            || !reader.read(targeting.targets.data(), targeting.targets.size())
+            || !reader.read(targeting.result.data(), targeting.result.size())
+            || !reader.read(length)) {
+            return false;
+        }
+
+        targeting.script.resize(length);
+        if (!reader.read(targeting.script.data(), length)) {
+            return false;
+        }
+    }
+
+    action.targetIds.resize(record.targetsTotal);
+    action.ratios.resize(record.ratiosTotal);
+    return reader.read(action.targetIds.data(), action.targetIds.size() * sizeof(std::uint32_t))
+           && reader.read(action.ratios.data(), action.ratios.size() * sizeof(double));
+}
+
+/** Slot of the captured call in the stand-in battle. */
+struct ReplaySlot
+{
+    int group;
+    int position;
+};
+
+/** Stand-in battle groups are the attacker's group and the opposing group, as captured slots. */
+ReplaySlot replaySlot(std::uint8_t index)
+{
+    const int slot{index - 1};
+    return {slot / 6, slot % 6};
+}
+
+/** Creates stand-in battle from the captured unit stats and chosen targets. */
+benchtool::StandInBattle createBattle(const Targeting& targeting, bool targetsAreAllies)
+{
+    const auto& call = targeting.call;
+    const int targetGroup{targetsAreAllies ? 0 : 1};
+
+    benchtool::StandInBattle battle;
+    for (std::uint32_t i = 0; i < battleCaptureSlotsTotal; ++i) {
+        const auto& captured = call.units[i];
+        // Stats of empty slots are zero, large units are captured in both slots of their column
+        if (captured.hpMax <= 0) {
+            continue;
+        }
+
+        benchtool::StandInUnit unit;
+        unit.hp = captured.hp;
+        unit.hpMax = captured.hpMax;
+        unit.xp = captured.xp;
+        unit.level = captured.level;
+        unit.xpNext = captured.xpNext;
+        unit.xpKilled = captured.xpKilled;
+        unit.armor = captured.armor;
+        unit.regen = captured.regen;
+        unit.race = static_cast<game::RaceId>(captured.race);
+        unit.subrace = static_cast<game::SubRaceId>(captured.subrace);
+        unit.small = captured.small != 0;
+        unit.male = captured.male != 0;
+        unit.waterOnly = captured.waterOnly != 0;
+        unit.attacksTwice = captured.attacksTwice != 0;
+        unit.statuses = captured.statuses;
+        // Game checks whether units can be attacked before script is called
+        unit.attackable = false;
+
+        battle.groups[i / 6][i % 6] = unit;
+    }
+
+    for (auto index : targeting.targets) {
+        if (index < 1 || index > battleCaptureSlotsTotal) {
+            continue;
+        }
+
+        const auto slot{replaySlot(index)};
+        if (slot.group != targetGroup) {
+            continue;
+        }
+
+        auto& unit = battle.groups[slot.group][slot.position];
+        if (unit) {
+            unit->attackable = true;
+        } else {
+            // Only summon attacks target empty positions
+            battle.summonAttack = true;
+        }
+    }
+
+    return battle;
+}
+
+std::string formatIndices(const std::vector<std::uint8_t>& indices)
+{
+    std::string value{"["};
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        value += (i ? " " : "") + std::to_string(indices[i]);
+    }
+
+    return value + "]";
+}
+
+struct ScriptStats
+{
+    std::uint64_t calls{};
+    std::uint64_t mismatches{};
+    std::uint64_t errors{};
+    double microseconds{};
+};
+
+class Replay
+{
+public:
+    explicit Replay(const Options& options)
+        : options{options}
+    { }
+
+    void replay(std::uint64_t number, const Action& action)
+    {
+        const auto& record = action.record;
+        ++actions[actionName(record.action)];
+        modifiedUnits += action.modifiedUnits;
+
+        if (options.verbose) {
+            std::printf("#%llu round %d %s, reach %d, %u targets, %u modified units\n",
+                        static_cast<unsigned long long>(number), record.round,
+                        actionName(record.action), record.attackReach, record.targetsTotal,
+                        action.modifiedUnits);
+        }
+
+        if (record.flags & static_cast<std::uint8_t>(BattleCaptureFlag::Targeting)) {
+            replayTargeting(number, action);
+        }
+
+        if ((record.flags & static_cast<std::uint8_t>(BattleCaptureFlag::DamageRatio))
+            && record.ratiosTotal) {
+            replayDamageRatio(number, action);
+        }
+    }
+
+    /** Prints summary and returns true if all replayed actions match the captured ones. */
+    bool report() const
+    {
+        std::printf("Actions:\n");
+        for (const auto& [name, count] : actions) {
+            std::printf("  %-10s %llu\n", name.c_str(), static_cast<unsigned long long>(count));
+        }
+
+        std::printf("Modified unit entries: %llu\n",
+                    static_cast<unsigned long long>(modifiedUnits));
+
+        bool matched{true};
+        std::printf("Targeting scripts:\n");
+        for (const auto& [name, stats] : scripts) {
+            const double average{stats.calls ? stats.microseconds / stats.calls : 0.0};
+            std::printf("  %-48s %6llu calls %6llu mismatches %6llu errors %10.2f us/call\n",
+                        name.c_str(), static_cast<unsigned long long>(stats.calls),
+                        static_cast<unsigned long long>(stats.mismatches),
+                        static_cast<unsigned long long>(stats.errors), average);
+            matched &= !stats.mismatches && !stats.errors;
+        }
+
+        std::printf("Damage ratios: %llu checked, %llu mismatches\n",
+                    static_cast<unsigned long long>(ratiosChecked),
+                    static_cast<unsigned long long>(ratioMismatches));
+        return matched && !ratioMismatches;
+    }
+
+private:
+    void replayTargeting(std::uint64_t number, const Action& action)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const auto& targeting = action.targeting;
+        const auto& call = targeting.call;
+        auto& stats = scripts[targeting.script];
+
+        const bool targetsAreAllies{
+            (action.record.flags & static_cast<std::uint8_t>(BattleCaptureFlag::TargetsAreAllies))
+            != 0};
+        const int targetGroup{targetsAreAllies ? 0 : 1};
+
+        const auto attacker{replaySlot(call.attacker)};
+        const auto selected{replaySlot(call.selected)};
+        if (call.attacker < 1 || call.attacker > battleCaptureSlotsTotal || attacker.group != 0
+            || call.selected < 1 || call.selected > battleCaptureSlotsTotal
+            || selected.group != targetGroup) {
+            ++stats.errors;
+            std::printf("#%llu %s: unexpected attacker or selected slot\n",
+                        static_cast<unsigned long long>(number), targeting.script.c_str());
+            return;
+        }
+
+        const auto& objects{benchtool::setBattle(createBattle(targeting, targetsAreAllies))};
+
+        const auto& unitGroupId{objects.groupIds[0]};
+        const auto& unitId{objects.unitIds[0][attacker.position]};
+        const auto& targetGroupId{objects.groupIds[targetGroup]};
+        auto targetUnitId{objects.unitIds[targetGroup][selected.position]};
+        if (targetUnitId == game::emptyId) {
+            // Empty position is selected by summon attack
+            game::CMidgardIDApi::get().summonUnitIdFromPosition(&targetUnitId, selected.position);
+        }
+
+        CustomAttackReach reach{};
+        reach.attackScript = targeting.script;
+
+        auto& standIns{benchtool::standIns()};
+        const auto errors{standIns.errors};
+
+        UnitSlots slots;
+        const auto start{Clock::now()};
+        for (int i = 0; i < options.repeats; ++i) {
+            slots = getTargetsToAttackForCustomAttackReach(objects.objectMap,
+                                                           objects.battleMsgData,
+                                                           objects.batAttack, &targetGroupId,
+                                                           &targetUnitId, &unitGroupId, &unitId,
+                                                           reach);
+        }
+        const std::chrono::duration<double, std::micro> elapsed{Clock::now() - start};
+
+        ++stats.calls;
+        stats.microseconds += elapsed.count() / options.repeats;
+        if (standIns.errors != errors) {
+            ++stats.errors;
+            return;
+        }
+
+        std::vector<std::uint8_t> result;
+        for (const auto& slot : slots) {
+            const int group{slot.getGroupId() == objects.groupIds[0] ? 0 : 1};
+            result.push_back(static_cast<std::uint8_t>(group * 6 + slot.getPosition() + 1));
+        }
+
+        if (result != targeting.result) {
+            ++stats.mismatches;
+            std::printf("#%llu %s: captured targets %s, replayed %s\n",
+                        static_cast<unsigned long long>(number), targeting.script.c_str(),
+                        formatIndices(targeting.result).c_str(), formatIndices(result).c_str());
+        }
+    }
+
+    void replayDamageRatio(std::uint64_t number, const Action& action)
+    {
+        const auto& record = action.record;
+        const DamageRatio damageRatio{record.damageRatio, record.damageRatioPerTarget != 0,
+                                      record.damageSplit != 0};
+
+        const auto ratios{computeDamageRatios(damageRatio, record.targetsTotal)};
+
+        ++ratiosChecked;
+        const bool equal = ratios.size() == action.ratios.size()
+                           && std::equal(ratios.begin(), ratios.end(), action.ratios.begin(),
+                                         [](double a, double b) { return std::abs(a - b) < 1e-9; });
+        if (!equal) {
+            ++ratioMismatches;
+            std::printf("#%llu damage ratios of %u targets differ\n",
+                        static_cast<unsigned long long>(number), record.targetsTotal);
+        }
+    }
+
+    const Options& options;
+    std::map<std::string, ScriptStats> scripts;
+    std::map<std::string, std::uint64_t> actions;
+    std::uint64_t modifiedUnits{};
+    std::uint64_t ratiosChecked{};
+    std::uint64_t ratioMismatches{};
+};
+
+void printUsage()
+{
+    std::fputs("Usage:\n"
+               "  replaytool [options] [capture file]\n"
+               "Capture file is battleCapture.bin by default.\n"
+               "Options:\n"
+               "  -s <folder>  folder with targeting scripts, Scripts by default\n"
+               "  -r <count>   run each script call the specified number of times, 1 by default\n"
+               "  -v           print each replayed action\n"
+               "Exit code is 1 if replayed targets or damage ratios differ from captured ones.\n",
+               stderr);
+}
+
+bool parseOptions(Options& options, int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument{argv[i]};
+        if (argument == "-v") {
+            options.verbose = true;
+        } else if (argument == "-s" && i + 1 < argc) {
+            options.scriptsFolder = argv[++i];
+        } else if (argument == "-r" && i + 1 < argc) {
+            options.repeats = std::max(std::atoi(argv[++i]), 1);
+        } else if (!argument.empty() && argument[0] != '-') {
+            options.capture = argv[i];
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!parseOptions(options, argc, argv)) {
+        printUsage();
+        return 2;
+    }
+
+    std::ifstream stream(options.capture, std::ios_base::binary);
+    if (!stream) {
+        std::fprintf(stderr, "Could not open %s\n", options.capture.string().c_str());
+        return 2;
+    }
+
+    BattleCaptureHeader header{};
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, battleCaptureMagic, sizeof(battleCaptureMagic))
+        || header.version != battleCaptureVersion) {
+        std::fprintf(stderr, "%s is not a battle capture of version %u\n",
+                     options.capture.string().c_str(), battleCaptureVersion);
+        return 2;
+    }
+
+    if (header.modifiedUnitSize < sizeof(std::uint32_t)) {
+        std::fprintf(stderr, "Unexpected size of modified unit entries: %u\n",
+                     header.modifiedUnitSize);
+        return 2;
+    }
+
+    benchtool::installGameStandIns();
+
+    auto& standIns{benchtool::standIns()};
+    standIns.scriptsFolder = options.scriptsFolder;
+    // Proxy reads distances once, they must be set before the first script call
+    for (std::uint32_t from = 0; from < battleCaptureSlotsTotal; ++from) {
+        for (std::uint32_t to = 0; to < battleCaptureSlotsTotal; ++to) {
+            standIns.distances[from][to] = header.distances[from][to];
+        }
+    }
+
+    Replay replay{options};
+
+    std::uint64_t number{};
+    Action action;
+    std::vector<char> data;
+    while (stream.read(reinterpret_cast<char*>(&action.record), sizeof(action.record))) {
+        data.resize(action.record.size);
+        if (!stream.read(data.data(), data.size()) || !readAction(header, data, action)) {
+            // Game could be closed while the last action was written
+            std::fprintf(stderr, "Action #%llu is truncated, stopped\n",
+                         static_cast<unsigned long long>(number + 1));
+            break;
+        }
+
+        replay.replay(++number, action);
+    }
+
+    std::printf("Replayed %llu actions from %s\n", static_cast<unsigned long long>(number),
+                options.capture.string().c_str());
+    return replay.report() ? 0 : 1;
+}
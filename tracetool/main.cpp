@@ -0,0 +1,251 @@
+/*
+ * This file is part of the modding toolset for Disciples 2.
+ * (https://github.com/VladimirMakeev/D2ModdingToolset)
+ * Copyright (C) 2021 Vladimir Makeev.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Converts trace files recorded by the proxy into Chrome trace event JSON,
+ * that can be opened in chrome://tracing, Perfetto UI or speedscope as flame charts.
+ */
+
+#include "traceformat.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace hooks;
+
+namespace {
+
+const char* eventCategory(std::uint16_t event)
+{
+    switch (static_cast<TraceEvent>(event)) {
+    case TraceEvent::Hook:
+        return "hook";
+    case TraceEvent::LuaCall:
+        return "lua";
+    case TraceEvent::EventConditionTest:
+        return "eventCondition";
+    case TraceEvent::DbfLoad:
+        return "dbf";
+    case TraceEvent::BattleMsgSerialize:
+        return "battleMsg";
+    }
+
+    return "unknown";
+}
+
+std::string jsonEscape(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.size());
+
+    for (const char c : text) {
+        switch (c) {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                result += escaped;
+            } else {
+                result += c;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+template <typename T>
+bool read(std::ifstream& stream, T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+struct ThreadRecords
+{
+    std::uint32_t threadId;
+    std::vector<TraceRecord> records;
+};
+
+bool readTrace(const char* path,
+               TraceFileHeader& header,
+               std::vector<std::string>& names,
+               std::vector<ThreadRecords>& threads)
+{
+    std::ifstream stream(path, std::ios_base::binary);
+    if (!stream || !read(stream, header)) {
+        std::fprintf(stderr, "Could not read '%s'\n", path);
+        return false;
+    }
+
+    if (std::memcmp(header.magic, traceMagic, sizeof(traceMagic))
+        || header.version != traceVersion || !header.ticksPerSecond) {
+        std::fprintf(stderr, "'%s' is not a trace file or has unsupported version\n", path);
+        return false;
+    }
+
+    names.resize(header.namesTotal);
+    for (auto& name : names) {
+        std::uint32_t length{};
+        if (!read(stream, length)) {
+            std::fprintf(stderr, "Trace file is truncated\n");
+            return false;
+        }
+
+        name.resize(length);
+        if (length && !stream.read(&name[0], length)) {
+            std::fprintf(stderr, "Trace file is truncated\n");
+            return false;
+        }
+    }
+
+    threads.resize(header.threadsTotal);
+    for (auto& thread : threads) {
+        std::uint32_t recordsTotal{};
+        if (!read(stream, thread.threadId) || !read(stream, recordsTotal)) {
+            std::fprintf(stderr, "Trace file is truncated\n");
+            return false;
+        }
+
+        thread.records.resize(recordsTotal);
+        if (recordsTotal
+            && !stream.read(reinterpret_cast<char*>(thread.records.data()),
+                            recordsTotal * sizeof(TraceRecord))) {
+            std::fprintf(stderr, "Trace file is truncated\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Ring buffers keep only the latest records, so the oldest end records can miss their begins.
+ * Such records are skipped, as well as records overwritten while the trace was written,
+ * they break time order.
+ */
+std::vector<TraceRecord> balancedRecords(const std::vector<TraceRecord>& records)
+{
+    std::vector<TraceRecord> result;
+    result.reserve(records.size());
+
+    std::uint32_t depth{};
+    std::uint64_t lastTimestamp{};
+    for (const auto& record : records) {
+        if (record.timestamp < lastTimestamp) {
+            continue;
+        }
+
+        if (static_cast<TracePhase>(record.phase) == TracePhase::End) {
+            if (!depth) {
+                continue;
+            }
+
+            --depth;
+        } else {
+            ++depth;
+        }
+
+        lastTimestamp = record.timestamp;
+        result.push_back(record);
+    }
+
+    return result;
+}
+
+std::string eventName(const TraceRecord& record, const std::vector<std::string>& names)
+{
+    const std::string name{record.name < names.size() ? names[record.name] : std::string()};
+    if (!name.empty()) {
+        return name;
+    }
+
+    return eventCategory(record.event);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage:\n"
+                             "  tracetool <mss32Trace.bin> <trace.json>\n"
+                             "Converts trace recorded by mss32.dll proxy "
+                             "to Chrome trace event format.\n");
+        return 1;
+    }
+
+    TraceFileHeader header{};
+    std::vector<std::string> names;
+    std::vector<ThreadRecords> threads;
+    if (!readTrace(argv[1], header, names, threads)) {
+        return 1;
+    }
+
+    // Timestamps are shown relative to the earliest record
+    std::uint64_t start{UINT64_MAX};
+    for (const auto& thread : threads) {
+        if (!thread.records.empty()) {
+            start = std::min(start, thread.records.front().timestamp);
+        }
+    }
+
+    std::ofstream output(argv[2]);
+    if (!output) {
+        std::fprintf(stderr, "Could not create '%s'\n", argv[2]);
+        return 1;
+    }
+
+    const double microsecondsPerTick{1000000.0 / static_cast<double>(header.ticksPerSecond)};
+
+    output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::size_t eventsTotal{};
+    for (const auto& thread : threads) {
+        for (const auto& record : balancedRecords(thread.records)) {
+            const double timestamp{(record.timestamp - start) * microsecondsPerTick};
+            const bool begin{static_cast<TracePhase>(record.phase) == TracePhase::Begin};
+
+            char line[128];
+            std::snprintf(line, sizeof(line),
+                          "\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,"
+                          "\"args\":{\"payload\":%llu}}",
+                          begin ? "B" : "E", timestamp, thread.threadId,
+                          static_cast<unsigned long long>(record.payload));
+
+            output << (eventsTotal++ ? ",\n" : "\n") << "{\"name\":\""
+                   << jsonEscape(eventName(record, names)) << "\",\"cat\":\""
+                   << eventCategory(record.event) << "\"," << line;
+        }
+    }
+
+    output << "\n]}\n";
+
+    std::fprintf(stderr, "Converted %zu events of %zu threads\n", eventsTotal, threads.size());
+    return 0;
+}